@@ -0,0 +1,292 @@
+#include "../include/json_reader.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+/*
+ * Throughput of the marketplace loaders' JSON parsing: the line-by-line
+ * parsers loadMarketplaceData used before JsonReader, against JsonReader
+ * with JsonFields and JsonRecordHandler as the loaders use it now.
+ *
+ *   build/bench/json_parse_bench [records per file]
+ *
+ * Both parse generated listings.json and transactions.json files laid out
+ * as saveMarketplaceData writes them, ctime() timestamps with their raw
+ * newline included. Only parsing is timed; each record is handed to a
+ * callback that sums its price, so neither side builds NFTs or Transactions.
+ * Files are read from the page cache after the first pass; best of 5 runs.
+ */
+
+namespace {
+    const int RUNS = 5;
+
+    struct Listing {
+        std::string tokenId, name, owner, mintAddress, metadataUri, collection;
+        double price = 0.0;
+        bool isListed = false;
+    };
+
+    struct Sale {
+        std::string transactionId, tokenId, seller, buyer, timestamp, status;
+        double price = 0.0;
+    };
+
+    // --- The loaders' parsers before JsonReader, unchanged but for the record callback ---
+
+    // Value of a "key": "value" line; values may continue onto following lines
+    std::string readStringValue(std::istream& in, const std::string& line) {
+        size_t start = line.find("\"", line.find(":"));
+        if (start == std::string::npos) return "";
+        size_t end = line.find("\"", start + 1);
+        if (end != std::string::npos) {
+            return line.substr(start + 1, end - start - 1);
+        }
+        std::string value = line.substr(start + 1);
+        std::string next;
+        while (std::getline(in, next)) {
+            value += "\n";
+            end = next.find("\"");
+            if (end != std::string::npos) {
+                value += next.substr(0, end);
+                break;
+            }
+            value += next;
+        }
+        return value;
+    }
+
+    std::string quotedValue(const std::string& line) {
+        size_t start = line.find("\"", line.find(":"));
+        size_t end = line.find("\"", start + 1);
+        if (start != std::string::npos && end != std::string::npos) {
+            return line.substr(start + 1, end - start - 1);
+        }
+        return "";
+    }
+
+    void lineParseListings(const std::string& path, const std::function<void(const Listing&)>& onRecord) {
+        std::ifstream listings_file(path);
+        std::string line;
+        bool inListings = false;
+        bool inNFT = false;
+        Listing nft;
+        while (std::getline(listings_file, line)) {
+            line.erase(0, line.find_first_not_of(" \t"));
+            if (line.empty()) continue;
+
+            if (line.find("\"listings\":") != std::string::npos) {
+                inListings = true;
+            } else if (line.find("\"tokenId\":") != std::string::npos && inNFT) {
+                nft.tokenId = quotedValue(line);
+            } else if (line.find("\"name\":") != std::string::npos && inNFT) {
+                nft.name = quotedValue(line);
+            } else if (line.find("\"owner\":") != std::string::npos && inNFT) {
+                nft.owner = quotedValue(line);
+            } else if (line.find("\"price\":") != std::string::npos && inNFT) {
+                size_t colonPos = line.find(":");
+                if (colonPos != std::string::npos) {
+                    std::string priceStr = line.substr(colonPos + 1);
+                    if (!priceStr.empty() && priceStr.back() == ',') {
+                        priceStr.pop_back();
+                    }
+                    nft.price = std::stod(priceStr);
+                }
+            } else if (line.find("\"isListed\":") != std::string::npos && inNFT) {
+                if (line.find("true") != std::string::npos) {
+                    nft.isListed = true;
+                }
+            } else if (line.find("\"mintAddress\":") != std::string::npos && inNFT) {
+                nft.mintAddress = quotedValue(line);
+            } else if (line.find("\"metadataUri\":") != std::string::npos && inNFT) {
+                nft.metadataUri = quotedValue(line);
+            } else if (line.find("\"collection\":") != std::string::npos && inNFT) {
+                nft.collection = quotedValue(line);
+            } else if (line.find("{") != std::string::npos && inListings && !inNFT) {
+                inNFT = true;
+                nft = Listing();
+            } else if (line.find("}") != std::string::npos && inNFT) {
+                onRecord(nft);
+                inNFT = false;
+            }
+        }
+    }
+
+    void lineParseTransactions(const std::string& path, const std::function<void(const Sale&)>& onRecord) {
+        std::ifstream transactions_file(path);
+        std::string line;
+        bool inTransactions = false;
+        bool inTransaction = false;
+        Sale sale;
+        while (std::getline(transactions_file, line)) {
+            line.erase(0, line.find_first_not_of(" \t"));
+            if (line.empty()) continue;
+
+            if (line.find("\"transactionId\":") != std::string::npos && inTransaction) {
+                sale.transactionId = readStringValue(transactions_file, line);
+            } else if (line.find("\"tokenId\":") != std::string::npos && inTransaction) {
+                sale.tokenId = readStringValue(transactions_file, line);
+            } else if (line.find("\"seller\":") != std::string::npos && inTransaction) {
+                sale.seller = readStringValue(transactions_file, line);
+            } else if (line.find("\"buyer\":") != std::string::npos && inTransaction) {
+                sale.buyer = readStringValue(transactions_file, line);
+            } else if (line.find("\"price\":") != std::string::npos && inTransaction) {
+                std::string priceStr = line.substr(line.find(":") + 1);
+                if (!priceStr.empty() && priceStr.back() == ',') {
+                    priceStr.pop_back();
+                }
+                sale.price = std::stod(priceStr);
+            } else if (line.find("\"timestamp\":") != std::string::npos && inTransaction) {
+                sale.timestamp = readStringValue(transactions_file, line);
+            } else if (line.find("\"status\":") != std::string::npos && inTransaction) {
+                sale.status = readStringValue(transactions_file, line);
+            } else if (line.find("\"transactions\":") != std::string::npos) {
+                inTransactions = true;
+            } else if (line.find("{") != std::string::npos && inTransactions && !inTransaction) {
+                inTransaction = true;
+                sale = Sale();
+            } else if (line.find("}") != std::string::npos && inTransaction) {
+                onRecord(sale);
+                inTransaction = false;
+            }
+        }
+    }
+
+    // --- The same records through JsonReader, as loadMarketplaceData reads them now ---
+
+    void readerParseListings(const std::string& path, const std::function<void(const Listing&)>& onRecord) {
+        Listing nft;
+        JsonFields fields;
+        fields.bind("tokenId", nft.tokenId);
+        fields.bind("name", nft.name);
+        fields.bind("owner", nft.owner);
+        fields.bind("price", nft.price);
+        fields.bind("isListed", nft.isListed);
+        fields.bind("mintAddress", nft.mintAddress);
+        fields.bind("metadataUri", nft.metadataUri);
+        fields.bind("collection", nft.collection);
+        JsonRecordHandler listings(fields, 3, [&]() { onRecord(nft); });
+        parseJsonFile(path, listings);
+    }
+
+    void readerParseTransactions(const std::string& path, const std::function<void(const Sale&)>& onRecord) {
+        Sale sale;
+        JsonFields fields;
+        fields.bind("transactionId", sale.transactionId);
+        fields.bind("tokenId", sale.tokenId);
+        fields.bind("seller", sale.seller);
+        fields.bind("buyer", sale.buyer);
+        fields.bind("price", sale.price);
+        fields.bind("timestamp", sale.timestamp);
+        fields.bind("status", sale.status);
+        JsonRecordHandler transactions(fields, 3, [&]() { onRecord(sale); });
+        parseJsonFile(path, transactions);
+    }
+
+    // --- Generated input ---
+
+    std::string wallet(size_t i) {
+        // Base58-looking and 44 characters, like the real addresses
+        std::string address = "7xKXtg2CW87d97TXJSDpbD5jBkheTqA83TZRuJosg" + std::to_string(100 + i % 900);
+        return address.substr(0, 44);
+    }
+
+    size_t writeListings(const std::string& path, size_t count) {
+        std::ofstream out(path);
+        out << "{\n  \"listings\": [\n";
+        for (size_t i = 0; i < count; i++) {
+            out << "    {\n"
+                << "      \"tokenId\": \"NFT-" << std::hex << (0x1E35F20000ULL + i) << std::dec << "\",\n"
+                << "      \"name\": \"Generated NFT #" << i << "\",\n"
+                << "      \"owner\": \"" << wallet(i) << "\",\n"
+                << "      \"price\": " << (0.05 + (i % 400) / 100.0) << ",\n"
+                << "      \"isListed\": true,\n"
+                << "      \"mintAddress\": \"" << wallet(i + 7) << "\",\n"
+                << "      \"metadataUri\": \"https://arweave.net/meta-" << i << ".json\",\n"
+                << "      \"collection\": \"Collection " << i % 50 << "\"\n"
+                << "    }" << (i + 1 < count ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+        return static_cast<size_t>(out.tellp());
+    }
+
+    size_t writeTransactions(const std::string& path, size_t count) {
+        std::ofstream out(path);
+        out << "{\n  \"transactions\": [\n";
+        for (size_t i = 0; i < count; i++) {
+            out << "    {\n"
+                << "      \"transactionId\": \"TX-" << std::hex << (0x2A0000000ULL + i) << std::dec << "\",\n"
+                << "      \"tokenId\": \"NFT-" << std::hex << (0x1E35F20000ULL + i) << std::dec << "\",\n"
+                << "      \"seller\": \"" << wallet(i) << "\",\n"
+                << "      \"buyer\": \"" << wallet(i + 3) << "\",\n"
+                << "      \"price\": " << (0.05 + (i % 400) / 100.0) << ",\n"
+                << "      \"timestamp\": \"Fri Jul 18 18:44:57 2025\n\",\n"
+                << "      \"status\": \"Completed\"\n"
+                << "    }" << (i + 1 < count ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+        return static_cast<size_t>(out.tellp());
+    }
+
+    // Best MB/s over RUNS passes; records and checksum from the last pass
+    template <typename Parse>
+    double megabytesPerSecond(size_t bytes, Parse parse, size_t& records, double& checksum) {
+        double best = 0.0;
+        for (int run = 0; run < RUNS; run++) {
+            records = 0;
+            checksum = 0.0;
+            auto start = std::chrono::steady_clock::now();
+            parse(records, checksum);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            best = std::max(best, bytes / seconds / (1024.0 * 1024.0));
+        }
+        return best;
+    }
+
+    template <typename Record>
+    void compare(const char* name, const std::string& path, size_t bytes,
+                 void (*before)(const std::string&, const std::function<void(const Record&)>&),
+                 void (*after)(const std::string&, const std::function<void(const Record&)>&)) {
+        size_t oldRecords = 0, newRecords = 0;
+        double oldSum = 0.0, newSum = 0.0;
+        double oldRate = megabytesPerSecond(bytes, [&](size_t& records, double& sum) {
+            before(path, [&](const Record& record) { records++; sum += record.price; });
+        }, oldRecords, oldSum);
+        double newRate = megabytesPerSecond(bytes, [&](size_t& records, double& sum) {
+            after(path, [&](const Record& record) { records++; sum += record.price; });
+        }, newRecords, newSum);
+
+        std::cout << name << " (" << bytes / (1024 * 1024) << " MB, " << newRecords << " records): line parser "
+                  << oldRate << " MB/s, JsonReader " << newRate << " MB/s (" << newRate / oldRate << "x)";
+        if (oldRecords != newRecords || oldSum != newSum) {
+            std::cout << " -- MISMATCH: " << oldRecords << " vs " << newRecords << " records";
+        }
+        std::cout << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+
+    char scratch[] = "/tmp/json_parse_bench.XXXXXX";
+    if (!::mkdtemp(scratch) || ::chdir(scratch) != 0) {
+        std::cerr << "Cannot create a scratch directory" << std::endl;
+        return 1;
+    }
+
+    size_t listingBytes = writeListings("listings.json", count);
+    size_t transactionBytes = writeTransactions("transactions.json", count);
+
+    compare<Listing>("listings.json", "listings.json", listingBytes, lineParseListings, readerParseListings);
+    compare<Sale>("transactions.json", "transactions.json", transactionBytes,
+                  lineParseTransactions, readerParseTransactions);
+
+    ::unlink("listings.json");
+    ::unlink("transactions.json");
+    ::chdir("/");
+    ::rmdir(scratch);
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include "../include/header.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <unistd.h>
+
+/*
+ * Per-sale cost of Marketplace::buyNFT against the seller's inventory size.
+ * A sale moves one NFT between two accounts' indexes and commits a few small
+ * records for each side (balance, the token's record, the buyer's history),
+ * so neither part should grow with the inventory. The timings include that
+ * commit and its fsync.
+ *
+ *   build/bench/sale_bench [sales per size]
+ *
+ * Runs in a scratch directory, so the store and journal it writes are thrown
+ * away. Balances come from a seeded balanceCache(), not an RPC node.
+ */
+
+namespace {
+    const size_t INVENTORY_SIZES[] = {1000, 10000, 100000};
+    const uint64_t BUYER_LAMPORTS = 1000000ULL * 1000000000ULL;
+
+    double microsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t sales = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 300;
+
+    char scratch[] = "/tmp/sale_bench.XXXXXX";
+    if (!::mkdtemp(scratch) || ::chdir(scratch) != 0) {
+        std::cerr << "Cannot create a scratch directory" << std::endl;
+        return 1;
+    }
+
+    // buyNFT narrates every sale; only the results are wanted here
+    std::cout.setstate(std::ios::failbit);
+    Marketplace* marketplace = Marketplace::getInstance();
+    UserTable& users = userTable();
+    UserHandle buyerHandle = users.emplace(UserAccount("bench-buyer", "buyer", "buyer@bench", "", "1000000"));
+    userRegistry().add(buyerHandle);
+    UserAccount& buyer = *users.get(buyerHandle);
+
+    for (size_t inventory : INVENTORY_SIZES) {
+        std::string wallet = "bench-seller-" + std::to_string(inventory);
+        UserHandle sellerHandle = users.emplace(UserAccount(wallet, "seller", wallet + "@bench", "", "0"));
+        userRegistry().add(sellerHandle);
+        UserAccount& seller = *users.get(sellerHandle);
+
+        // Spread the listed NFTs through the inventory, not just at its end
+        seller.getCollections().push_back(Collection("Bench", seller.getName()));
+        size_t stride = std::max<size_t>(1, inventory / sales);
+        V<std::string> listed;
+        for (size_t i = 0; i < inventory; i++) {
+            NFT nft("bench-" + std::to_string(i), wallet, 0.001);
+            nft.setCollection("Bench");
+            seller.addOwnedNFT(nft);
+            seller.getCollections()[0].addNFT(nft);
+            if (i % stride == 0 && listed.size() < sales) {
+                listed.push_back(nft.getTokenId());
+            }
+        }
+        for (const auto& tokenId : listed) {
+            marketplace->listNFT(tokenId, 0.001, seller);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& tokenId : listed) {
+            balanceCache().put(buyer.getWalletAddress(), BUYER_LAMPORTS);
+            marketplace->buyNFT(tokenId, buyer);
+        }
+        double saleMicros = microsSince(start) / listed.size();
+
+        std::cout.clear();
+        std::cout << "inventory " << inventory << ": " << saleMicros << " us/sale over " << listed.size()
+                  << " sales" << std::endl;
+        std::cout.setstate(std::ios::failbit);
+    }
+    return 0;
+}
@@ -7,25 +7,115 @@
 #include <new>
 #include <cstring>
 #include <iostream>
+#include <memory>
+#include <utility>
+#include <type_traits>
 
-template<typename T>
+/*
+ * V<T> keeps its elements in raw, uninitialized storage obtained from the
+ * allocator and constructs them in place. On growth elements are moved
+ * (when T's move constructor cannot throw) instead of being default
+ * constructed and copy-assigned.
+ */
+template<typename T, typename Alloc = std::allocator<T>>
 class V {
 	private:
+		using Traits = std::allocator_traits<Alloc>;
+
+		Alloc alloc;
 		T* data;
 		size_t size_;
 		size_t capacity_;
 
+		// Move if T's move can't throw (or T can't be copied), copy otherwise
+		static constexpr bool moveOnGrow =
+			std::is_nothrow_move_constructible<T>::value || !std::is_copy_constructible<T>::value;
+
+		T* allocate(size_t n) {
+			return n ? Traits::allocate(alloc, n) : nullptr;
+		}
+
+		void deallocate(T* p, size_t n) {
+			if (p) Traits::deallocate(alloc, p, n);
+		}
+
+		void destroyRange(T* first, T* last) {
+			for (; first != last; ++first) {
+				Traits::destroy(alloc, first);
+			}
+		}
+
+		// Copies [first, last) into uninitialized storage, undoing on failure
+		void copyInto(const T* first, const T* last, T* dest) {
+			T* cur = dest;
+			try {
+				for (; first != last; ++first, ++cur) {
+					Traits::construct(alloc, cur, *first);
+				}
+			} catch (...) {
+				destroyRange(dest, cur);
+				throw;
+			}
+		}
+
+		// Relocates the current elements into new_data (moved or copied)
+		void relocateInto(T* new_data) {
+			if constexpr (moveOnGrow) {
+				for (size_t i = 0; i < size_; i++) {
+					Traits::construct(alloc, new_data + i, std::move(data[i]));
+				}
+			} else {
+				copyInto(data, data + size_, new_data);
+			}
+		}
+
+		size_t grownCapacity(size_t min_capacity) const {
+			size_t new_capacity = (capacity_ == 0) ? 1 : capacity_ * 2;
+			return new_capacity < min_capacity ? min_capacity : new_capacity;
+		}
+
+		void reallocate(size_t new_capacity) {
+			T* new_data = allocate(new_capacity);
+			try {
+				relocateInto(new_data);
+			} catch (...) {
+				deallocate(new_data, new_capacity);
+				throw;
+			}
+			destroyRange(data, data + size_);
+			deallocate(data, capacity_);
+			data = new_data;
+			capacity_ = new_capacity;
+		}
+
+		void release() {
+			destroyRange(data, data + size_);
+			deallocate(data, capacity_);
+			data = nullptr;
+			size_ = 0;
+			capacity_ = 0;
+		}
+
 	public:
 		V() : data(nullptr), size_(0), capacity_(0) {}
- 		~V() { delete[] data; }
-
-		V(const V& other) : size_(other.size_), capacity_(other.capacity_) {
-        		data = new T[capacity_];  
-        		for (size_t i = 0; i < size_; i++) {
-            			data[i] = other.data[i];  
-        		}
-    		}
-		V(V&& other) noexcept : data(other.data), size_(other.size_), capacity_(other.capacity_) {
+		~V() { release(); }
+
+		V(const V& other)
+			: alloc(Traits::select_on_container_copy_construction(other.alloc)),
+			  data(nullptr), size_(0), capacity_(0) {
+			data = allocate(other.size_);
+			try {
+				copyInto(other.data, other.data + other.size_, data);
+			} catch (...) {
+				deallocate(data, other.size_);
+				throw;
+			}
+			size_ = other.size_;
+			capacity_ = other.size_;
+		}
+
+		V(V&& other) noexcept
+			: alloc(std::move(other.alloc)), data(other.data), size_(other.size_), capacity_(other.capacity_) {
 			other.data = nullptr;
 			other.size_ = 0;
 			other.capacity_ = 0;
@@ -33,63 +123,150 @@ class V {
 
 		V& operator=(const V& other) {
 			if (this != &other) {
-				delete[] data;
+				V copy(other);
+				swap(copy);
+			}
+			return *this;
+		}
+
+		V& operator=(V&& other) noexcept {
+			if (this != &other) {
+				release();
+				alloc = std::move(other.alloc);
+				data = other.data;
 				size_ = other.size_;
 				capacity_ = other.capacity_;
-				data = new T[capacity_];
-				for (size_t i = 0; i < size_; i++) {
-					data[i] = other.data[i];
-				}
+				other.data = nullptr;
+				other.size_ = 0;
+				other.capacity_ = 0;
 			}
 			return *this;
 		}
 
+		void swap(V& other) noexcept {
+			using std::swap;
+			swap(alloc, other.alloc);
+			swap(data, other.data);
+			swap(size_, other.size_);
+			swap(capacity_, other.capacity_);
+		}
+
 		T& operator[](size_t index) {
-        		if (index >= size_) {           
-            		throw std::out_of_range("Index out of bounds");
-        		}
-        		return data[index];             
-    		}
-
-    		const T& operator[](size_t index) const {
-        		if (index >= size_) {           
-            		throw std::out_of_range("Index out of bounds");
-        		}
-        		return data[index];            
-    		}
-
-    		T* begin() { return data; }                
-    		T* end() { return data + size_; }           
-    		const T* begin() const { return data; }      
-    		const T* end() const { return data + size_; } 
-
-    		size_t size() const { return size_; }         
-    		size_t capacity() const { return capacity_; }  
-    		bool empty() const { return size_ == 0; }     
-		
-		void push_back(const T& value) {
-			if(size_ == capacity_) {
-				size_t new_capacity = (capacity_ == 0) ? 1 : capacity_ * 2;
-				T* new_data = new T[new_capacity];
-				for (size_t i = 0; i < size_; i++) {
-					new_data[i] = data[i];
-				}
+			if (index >= size_) {
+				throw std::out_of_range("Index out of bounds");
+			}
+			return data[index];
+		}
+
+		const T& operator[](size_t index) const {
+			if (index >= size_) {
+				throw std::out_of_range("Index out of bounds");
+			}
+			return data[index];
+		}
 
-				delete[] data;
+		T& back() {
+			if (size_ == 0) {
+				throw std::out_of_range("back() on empty V");
+			}
+			return data[size_ - 1];
+		}
+
+		const T& back() const {
+			if (size_ == 0) {
+				throw std::out_of_range("back() on empty V");
+			}
+			return data[size_ - 1];
+		}
+
+		T* begin() { return data; }
+		T* end() { return data + size_; }
+		const T* begin() const { return data; }
+		const T* end() const { return data + size_; }
+
+		size_t size() const { return size_; }
+		size_t capacity() const { return capacity_; }
+		bool empty() const { return size_ == 0; }
+
+		void reserve(size_t new_capacity) {
+			if (new_capacity > capacity_) {
+				reallocate(new_capacity);
+			}
+		}
+
+		template<typename... Args>
+		T& emplace_back(Args&&... args) {
+			if (size_ == capacity_) {
+				// Construct the new element first: args may refer into our own storage
+				size_t new_capacity = grownCapacity(size_ + 1);
+				T* new_data = allocate(new_capacity);
+				try {
+					Traits::construct(alloc, new_data + size_, std::forward<Args>(args)...);
+				} catch (...) {
+					deallocate(new_data, new_capacity);
+					throw;
+				}
+				try {
+					relocateInto(new_data);
+				} catch (...) {
+					Traits::destroy(alloc, new_data + size_);
+					deallocate(new_data, new_capacity);
+					throw;
+				}
+				destroyRange(data, data + size_);
+				deallocate(data, capacity_);
 				data = new_data;
 				capacity_ = new_capacity;
+			} else {
+				Traits::construct(alloc, data + size_, std::forward<Args>(args)...);
+			}
+			return data[size_++];
+		}
+
+		void push_back(const T& value) { emplace_back(value); }
+		void push_back(T&& value) { emplace_back(std::move(value)); }
+
+		void pop_back() {
+			if (size_ == 0) {
+				throw std::out_of_range("pop_back() on empty V");
+			}
+			Traits::destroy(alloc, data + --size_);
+		}
+
+		// Removes the element at index, keeping the order of the rest
+		void erase(size_t index) {
+			if (index >= size_) {
+				throw std::out_of_range("Index out of bounds");
+			}
+			for (size_t i = index + 1; i < size_; i++) {
+				data[i - 1] = std::move(data[i]);
 			}
-			data[size_] = value;
-			size_++;
+			pop_back();
 		}
 
+		// Removes every element matching pred; returns how many were removed
+		template<typename Pred>
+		size_t erase_if(Pred pred) {
+			size_t kept = 0;
+			for (size_t i = 0; i < size_; i++) {
+				if (!pred(data[i])) {
+					if (kept != i) {
+						data[kept] = std::move(data[i]);
+					}
+					kept++;
+				}
+			}
+			size_t removed = size_ - kept;
+			destroyRange(data + kept, data + size_);
+			size_ = kept;
+			return removed;
+		}
+
+		// Destroys the elements but keeps the storage for reuse
 		void clear() {
-			delete[] data;
-			data = nullptr;
+			destroyRange(data, data + size_);
 			size_ = 0;
-			capacity_ = 0;
 		}
-	
 };
 
 #endif
@@ -0,0 +1,83 @@
+#ifndef BALANCE_CACHE_HPP
+#define BALANCE_CACHE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/*
+ * Wallet balances (in lamports) keyed by address. A value is served from
+ * memory until it is older than the TTL. Concurrent lookups for the same
+ * address while a fetch is running wait for that fetch rather than
+ * issuing their own. Failed fetches are not cached.
+ */
+class BalanceCache {
+public:
+    using Fetcher = std::function<uint64_t(const std::string&)>;
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        uint64_t hits;           // served from memory
+        uint64_t misses;         // started an RPC
+        uint64_t coalesced;      // waited on another caller's RPC
+        uint64_t errors;         // RPCs that failed
+        uint64_t invalidations;
+        uint64_t entries;
+        uint64_t ttlMs;
+        double hitRate;          // (hits + coalesced) / lookups
+        double meanHitAgeMs;     // how stale the values served from memory were
+        uint64_t maxHitAgeMs;
+    };
+
+private:
+    struct Flight {
+        std::promise<uint64_t> promise;
+        std::shared_future<uint64_t> result;
+        Flight() : result(promise.get_future().share()) {}
+    };
+
+    struct Entry {
+        uint64_t lamports = 0;
+        Clock::time_point fetchedAt;
+        bool valid = false;
+        std::shared_ptr<Flight> flight;   // set while a fetch is running
+    };
+
+    Fetcher fetch;
+    Clock::duration ttl;
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, Entry> entries;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t coalesced = 0;
+    uint64_t errors = 0;
+    uint64_t invalidations = 0;
+    uint64_t hitAgeTotalMs = 0;
+    uint64_t hitAgeMaxMs = 0;
+
+public:
+    BalanceCache(Fetcher fetcher, std::chrono::milliseconds timeToLive);
+
+    BalanceCache(const BalanceCache&) = delete;
+    BalanceCache& operator=(const BalanceCache&) = delete;
+
+    // Balance in lamports; rethrows the fetch error when the RPC fails
+    uint64_t get(const std::string& address);
+    // Seeds a value fetched elsewhere (e.g. by a batch refresh)
+    void put(const std::string& address, uint64_t lamports);
+    // Drops the cached value so the next lookup goes to the node
+    void invalidate(const std::string& address);
+    void clear();
+    Stats stats() const;
+};
+
+// Process-wide cache over solanaRpc(); TTL from $BALANCE_CACHE_TTL_MS (default 5000)
+BalanceCache& balanceCache();
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef BASE58_HPP
+#define BASE58_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Bitcoin/Solana base58 alphabet (no 0, O, I or l)
+std::string base58Encode(const uint8_t* data, size_t size);
+
+inline std::string base58Encode(const std::vector<uint8_t>& bytes) {
+    return base58Encode(bytes.data(), bytes.size());
+}
+
+// False if text contains a character outside the alphabet
+bool base58Decode(std::string_view text, std::vector<uint8_t>& out);
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef BYTE_BUFFER_HPP
+#define BYTE_BUFFER_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Little-endian binary encoding for on-disk records
+class ByteWriter {
+private:
+    std::string buffer;
+
+public:
+    void putU8(uint8_t value) { buffer.push_back(static_cast<char>(value)); }
+
+    void putU32(uint32_t value) {
+        for (int i = 0; i < 4; i++) {
+            buffer.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+        }
+    }
+
+    void putU64(uint64_t value) {
+        for (int i = 0; i < 8; i++) {
+            buffer.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+        }
+    }
+
+    void putDouble(double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        putU64(bits);
+    }
+
+    void putBool(bool value) { putU8(value ? 1 : 0); }
+
+    void putString(const std::string& value) {
+        putU32(static_cast<uint32_t>(value.size()));
+        buffer.append(value);
+    }
+
+    void putBytes(const void* data, size_t length) {
+        buffer.append(static_cast<const char*>(data), length);
+    }
+
+    const std::string& str() const { return buffer; }
+    std::string& str() { return buffer; }
+    size_t size() const { return buffer.size(); }
+    void clear() { buffer.clear(); }
+};
+
+// Reads what ByteWriter wrote; ok() turns false on the first short read
+class ByteReader {
+private:
+    const unsigned char* cur;
+    const unsigned char* end;
+    bool good;
+
+    bool need(size_t n) {
+        if (!good || static_cast<size_t>(end - cur) < n) {
+            good = false;
+            return false;
+        }
+        return true;
+    }
+
+public:
+    ByteReader(const void* data, size_t length)
+        : cur(static_cast<const unsigned char*>(data)),
+          end(static_cast<const unsigned char*>(data) + length),
+          good(true) {}
+
+    uint8_t getU8() {
+        if (!need(1)) return 0;
+        return *cur++;
+    }
+
+    uint32_t getU32() {
+        if (!need(4)) return 0;
+        uint32_t value = 0;
+        for (int i = 0; i < 4; i++) {
+            value |= static_cast<uint32_t>(cur[i]) << (8 * i);
+        }
+        cur += 4;
+        return value;
+    }
+
+    uint64_t getU64() {
+        if (!need(8)) return 0;
+        uint64_t value = 0;
+        for (int i = 0; i < 8; i++) {
+            value |= static_cast<uint64_t>(cur[i]) << (8 * i);
+        }
+        cur += 8;
+        return value;
+    }
+
+    double getDouble() {
+        uint64_t bits = getU64();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    bool getBool() { return getU8() != 0; }
+
+    std::string getString() {
+        uint32_t length = getU32();
+        if (!need(length)) return std::string();
+        std::string value(reinterpret_cast<const char*>(cur), length);
+        cur += length;
+        return value;
+    }
+
+    bool ok() const { return good; }
+    size_t remaining() const { return static_cast<size_t>(end - cur); }
+};
+
+#endif
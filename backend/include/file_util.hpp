@@ -0,0 +1,13 @@
+#ifndef FILE_UTIL_HPP
+#define FILE_UTIL_HPP
+
+#include <string>
+
+// Writes contents to path via a temp file, fsync and rename, so readers
+// see either the old file or the complete new one. Throws on failure.
+void writeFileAtomic(const std::string& path, const std::string& contents, unsigned int mode = 0644);
+
+// fsyncs the directory holding path, making a rename into it durable. Throws on failure.
+void syncParentDirectory(const std::string& path);
+
+#endif
@@ -0,0 +1,142 @@
+#ifndef FLAT_HASH_INDEX_HPP
+#define FLAT_HASH_INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+/*
+ * Open-addressing (linear probing) map from a key to a slot number in some
+ * other container. Deletion uses backward shifting, so there are no
+ * tombstones and lookups never degrade after many removals.
+ */
+template<typename Key, typename Hash = std::hash<Key>>
+class FlatHashIndex {
+private:
+    struct Bucket {
+        Key key;
+        size_t value = 0;
+        bool used = false;
+    };
+
+    std::vector<Bucket> buckets;
+    size_t count = 0;
+    Hash hasher;
+
+    // std::hash is the identity for integers on common standard libraries, so spread the bits
+    static uint64_t mix(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    size_t mask() const { return buckets.size() - 1; }
+
+    size_t home(const Key& key) const {
+        return static_cast<size_t>(mix(static_cast<uint64_t>(hasher(key)))) & mask();
+    }
+
+    // Bucket holding key, or the empty bucket where it would go
+    size_t probe(const Key& key) const {
+        size_t i = home(key);
+        while (buckets[i].used && !(buckets[i].key == key)) {
+            i = (i + 1) & mask();
+        }
+        return i;
+    }
+
+    void rehash(size_t new_bucket_count) {
+        std::vector<Bucket> old;
+        old.swap(buckets);
+        buckets.resize(new_bucket_count);
+        for (auto& bucket : old) {
+            if (bucket.used) {
+                Bucket& dest = buckets[probe(bucket.key)];
+                dest.key = std::move(bucket.key);
+                dest.value = bucket.value;
+                dest.used = true;
+            }
+        }
+    }
+
+    // Keep the load factor at or below 0.7
+    void growFor(size_t n) {
+        size_t needed = 8;
+        while (needed * 7 < n * 10) {
+            needed *= 2;
+        }
+        if (needed > buckets.size()) {
+            rehash(needed);
+        }
+    }
+
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    FlatHashIndex() = default;
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    void reserve(size_t n) { growFor(n); }
+
+    void clear() {
+        buckets.clear();
+        count = 0;
+    }
+
+    bool contains(const Key& key) const { return find(key) != npos; }
+
+    // Slot stored for key, or npos
+    size_t find(const Key& key) const {
+        if (count == 0) return npos;
+        const Bucket& bucket = buckets[probe(key)];
+        return bucket.used ? bucket.value : npos;
+    }
+
+    // Inserts key or overwrites its slot; returns true if the key was new
+    bool insert(const Key& key, size_t value) {
+        growFor(count + 1);
+        Bucket& bucket = buckets[probe(key)];
+        bool inserted = !bucket.used;
+        if (inserted) {
+            bucket.key = key;
+            bucket.used = true;
+            count++;
+        }
+        bucket.value = value;
+        return inserted;
+    }
+
+    bool erase(const Key& key) {
+        if (count == 0) return false;
+        size_t hole = probe(key);
+        if (!buckets[hole].used) return false;
+
+        // Shift later members of the probe run back into the hole
+        size_t i = hole;
+        while (true) {
+            i = (i + 1) & mask();
+            if (!buckets[i].used) break;
+            size_t want = home(buckets[i].key);
+            // Move i into the hole only if the hole lies cyclically in [want, i)
+            bool movable = (hole <= i) ? (want <= hole || want > i) : (want <= hole && want > i);
+            if (movable) {
+                buckets[hole].key = std::move(buckets[i].key);
+                buckets[hole].value = buckets[i].value;
+                hole = i;
+            }
+        }
+        buckets[hole].key = Key();
+        buckets[hole].used = false;
+        count--;
+        return true;
+    }
+};
+
+#endif
@@ -15,9 +15,24 @@
 #ifndef HEADER_HPP
 #define HEADER_HPP
 #include "V.hpp"
+#include "flat_hash_index.hpp"
+#include "order_book.hpp"
+#include "listing_columns.hpp"
+#include "marketplace_journal.hpp"
+#include "kv_store.hpp"
+#include "snapshot.hpp"
 #include "solana_config.hpp"
 #include "solana_wallet.hpp"
 #include "solana_integration.hpp"
+#include "solana_keypair.hpp"
+#include "mint_queue.hpp"
+#include "thread_pool.hpp"
+#include "password_hasher.hpp"
+#include "session_manager.hpp"
+#include "user_registry.hpp"
+#include "pubkey.hpp"
+#include "token_id.hpp"
+#include "snowflake.hpp"
 #include <argon2.h>
 #include <crow.h>
 
@@ -35,6 +50,11 @@
 #include <memory>
 #include <fstream>
 #include <filesystem>
+#include <unordered_set>
+#include <unordered_map>
+#include <array>
+#include <mutex>
+#include <shared_mutex>
 
 // API Server function declaration
 void startApiServer();
@@ -47,9 +67,9 @@ class Marketplace;
 class Transaction {
 	private:
 		std::string transactionId;
-		std::string tokenId;
-		std::string seller;
-		std::string buyer;
+		TokenId tokenId;
+		Pubkey seller;
+		Pubkey buyer;
 		double price;
 		std::string timestamp;
 		std::string status;
@@ -57,29 +77,33 @@ class Transaction {
 	public:
 		  Transaction() 
         		: transactionId(""), 
-          		tokenId(""), 
-          		seller(""), 
-          		buyer(""), 
           		price(0.0), 
           		timestamp(""), 
           		status("Pending") {}
 
-    		Transaction(std::string tokenId, std::string seller, std::string buyer, 
+    		Transaction(TokenId tokenId, Pubkey seller, Pubkey buyer,
 				double price, std::string status = "Completed") : tokenId(tokenId), seller(seller), buyer(buyer), price(price), status(status) {
-        		std::random_device rd;
-        		std::mt19937 gen(rd());
-        		std::uniform_int_distribution<> dis(0, 0xFFFFFF);
-        
-        		std::stringstream ss;
-        		ss << "TX-" << std::hex << std::uppercase << std::setfill('0') 
-           		<< std::setw(6) << dis(gen);
-        		transactionId = ss.str();
+        		transactionId = SnowflakeGenerator::format("TX-", idGenerator().next());
 
         		auto now = std::chrono::system_clock::now();
         		auto in_time_t = std::chrono::system_clock::to_time_t(now);
-        		timestamp = std::ctime(&in_time_t);
+        		// ctime_r: sales are recorded from several threads at once
+        		char buffer[26];
+        		timestamp = ctime_r(&in_time_t, buffer);
     		}
 
+		// Constructor with every field (for loading from disk)
+		Transaction(std::string transactionId, std::string tokenId, std::string seller, std::string buyer,
+				double price, std::string timestamp, std::string status)
+			: transactionId(transactionId), tokenId(TokenId::parse(tokenId)), seller(Pubkey::parse(seller)),
+			  buyer(Pubkey::parse(buyer)), price(price), timestamp(timestamp), status(status) {
+			// Ids made before a restart stay unique even if the clock has gone back since
+			uint64_t id;
+			if (SnowflakeGenerator::parse(transactionId, "TX-", id)) {
+				idGenerator().observe(id);
+			}
+		}
+
  		Transaction(const Transaction& other) = default;
 
     		Transaction& operator=(const Transaction& other) = default;
@@ -89,29 +113,27 @@ class Transaction {
     		Transaction& operator=(Transaction&& other) = default;
 
     		std::string getTransactionId() const { return transactionId; }
-    		std::string getTokenId() const { return tokenId; }
-    		std::string getSeller() const { return seller; }
-    		std::string getBuyer() const { return buyer; }
+    		std::string getTokenId() const { return tokenId.toString(); }
+    		std::string getSeller() const { return seller.toString(); }
+    		std::string getBuyer() const { return buyer.toString(); }
+    		TokenId token() const { return tokenId; }
+    		const Pubkey& sellerKey() const { return seller; }
+    		const Pubkey& buyerKey() const { return buyer; }
     		double getPrice() const { return price; }
     		std::string getTimestamp() const { return timestamp; }
     		std::string getStatus() const { return status; }
 
     		void displayTransaction() const;
+
+		SnapshotTransaction toSnapshot(SnapshotBuilder& builder) const;
+		static Transaction fromSnapshot(const SnapshotImage& image, const SnapshotTransaction& record);
 };
 
 
 std::string generateTokenId();
 
 inline std::string generateTokenId() {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_int_distribution<> dis(0, 0xFFFFFF);
-    
-    std::stringstream ss;
-    ss << "NFT-" << std::hex << std::uppercase << std::setfill('0') 
-       << std::setw(6) << dis(gen);
-    
-    return ss.str();
+    return TokenId::generate().toString();
 }
 class LoginException : public std::exception {
 	private:
@@ -124,8 +146,27 @@ class LoginException : public std::exception {
     }};
 
 
+// A sale, listing or unlisting that took effect in memory but whose account
+// records could not be committed: not a rejection, and it won't survive a restart
+class PersistenceError : public std::runtime_error {
+public:
+    explicit PersistenceError(const std::string& message) : std::runtime_error(message) {}
+};
+
+// A std::mutex its owner can still be copied with: a copy gets its own, unlocked mutex
+class AccountMutex {
+	private:
+		std::mutex mutex;
+	public:
+		AccountMutex() = default;
+		AccountMutex(const AccountMutex&) {}
+		AccountMutex& operator=(const AccountMutex&) { return *this; }
+		std::mutex& get() { return mutex; }
+};
+
 class UserAccount {
     	private:
+		 friend class AccountGuard;
 		 static std::string SOLANA_PATH; 
  		 SolanaWallet wallet;
     		std::string walletAddress;
@@ -137,99 +178,57 @@ class UserAccount {
  			std::string keypairPath;
 	 		V<std::string> transactionHistory;
 			V<NFT> ownedNFTs;
+			// tokenId -> slot in ownedNFTs
+			FlatHashIndex<TokenId> ownedIndex;
 			V<Collection> collections;
+			// Net of this session's marketplace sales, which never reach the node
+			double unsettled = 0.0;
+			// Balance, NFTs, collections and history; see AccountGuard
+			mutable AccountMutex accountMutex;
 			static UserAccount* currentUser;
-			static V<UserAccount*> allUsers;
+
+	// Rebuilds ownedIndex after ownedNFTs was filled in bulk; drops repeated tokens
+	void indexOwnedNFTs();
 
 	std::string hashPassword(const std::string& password);
 	bool verifyPassword(const std::string& password, const std::string& storedHashData);
 
     void saveUserData(const std::string& dir) {
-        // Save address
-        std::string address_path = dir + std::string("/address.txt");
-        std::ofstream address_file(address_path);
-        if (address_file.is_open()) {
-            address_file << walletAddress;
-            address_file.close();
-        }
-
-        // Save balance
-        std::string balance_path = dir + std::string("/balance.txt");
-        std::ofstream balance_file(balance_path);
-        if (balance_file.is_open()) {
-            balance_file << walletBalance;
-            balance_file.close();
-        }
-
-        // Save user info
-        std::string info_path = dir + std::string("/info.json");
-        std::ofstream info_file(info_path);
-        if (info_file.is_open()) {
-            info_file << "{\n";
-            info_file << "  \"name\": \"" << name << "\",\n";
-            info_file << "  \"email\": \"" << email << "\",\n";
-            info_file << "  \"walletAddress\": \"" << walletAddress << "\",\n";
-            info_file << "  \"balance\": \"" << walletBalance << "\",\n";
-            info_file << "  \"passwordHash\": \"" << passwordHash << "\"\n";
-            info_file << "}";
-            info_file.close();
-        }
-
-        // Initialize transaction history file
-        std::string tx_path = dir + std::string("/transactions.txt");
-        std::ofstream tx_file(tx_path);
-        tx_file.close();
+        WriteBatch batch;
+        stageUserData(batch, dir);
+        accountStore().commit(batch);
     }
 
-
-
     bool loadUserData(const std::string& email) {
-        // Find the user's directory
-        std::string cmd = "ls keypairs/";
-        std::string dir_name;
-        FILE* pipe = popen(cmd.c_str(), "r");
-        if (pipe) {
-            char buffer[128];
-            while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-                std::string dir(buffer);
-                if (dir.find(email) != std::string::npos) {
-                    dir_name = dir;
-                    if (!dir_name.empty() && dir_name[dir_name.length()-1] == '\n') {
-                        dir_name.erase(dir_name.length()-1);
-                    }
+        KeyValueStore& store = accountStore();
+        std::string dir_path;
+        if (UserAccount* known = findUserByEmail(email)) {
+            dir_path = known->getKeypairDir();
+        } else {
+            // Not loaded yet: directory names end in _<sanitized email>
+            std::string safe_email = email;
+            std::replace(safe_email.begin(), safe_email.end(), '@', '_');
+            std::replace(safe_email.begin(), safe_email.end(), '.', '_');
+            const std::string suffix = "_" + safe_email + "/info.json";
+            for (const auto& key : store.keysWithPrefix("keypairs/")) {
+                if (key.size() > suffix.size() && key.compare(key.size() - suffix.size(), suffix.size(), suffix) == 0) {
+                    dir_path = key.substr(0, key.size() - std::string("/info.json").size());
                     break;
                 }
             }
-            pclose(pipe);
         }
 
-        if (dir_name.empty()) {
+        if (dir_path.empty()) {
             return false;
         }
 
-        std::string dir_path = std::string("keypairs/") + dir_name;
-        
-        // Load address
-        std::string address_path = dir_path + std::string("/address.txt");
-        std::ifstream address_file(address_path);
-        if (address_file.is_open()) {
-            std::getline(address_file, walletAddress);
-            address_file.close();
-        }
-
-        // Load balance
-        std::string balance_path = dir_path + std::string("/balance.txt");
-        std::ifstream balance_file(balance_path);
-        if (balance_file.is_open()) {
-            std::getline(balance_file, walletBalance);
-            balance_file.close();
-        }
-
+        // Load address and balance
+        store.get(dir_path + "/address.txt", walletAddress);
+        store.get(dir_path + "/balance.txt", walletBalance);
         return true;
     }
 
 
-    static bool checkSolanaInstallation();
     static void installSolanaInstructions();
 	public:
     	       UserAccount(std::string walletAddress = "", 
@@ -252,11 +251,20 @@ class UserAccount {
 		double getBalance() const { return std::stod(walletBalance); }
 		void updateBalance(double amount) {
 			walletBalance = std::to_string(std::stod(walletBalance) + amount);
+			unsettled += amount;
 		}
-
-    		void createAccount(std::vector<UserAccount>& users);
-    		static void login(std::vector<UserAccount>& users);
-    		static void loadExistingUsers(std::vector<UserAccount>& users);
+		// What a purchase can spend, given the node's balance for this wallet
+		double spendableBalance(double chainBalance) const { return chainBalance + unsettled; }
+
+    		void createAccount(UserTable& users);
+    		static void login();
+    		static void loadExistingUsers(UserTable& users);
+    		// Pulls on-chain balances for every wallet in a few batched RPCs
+    		static void reconcileBalances(UserTable& users);
+    		// Writes finished mint addresses back into their owners' NFTs
+    		static void applyCompletedMints();
+    		// Whether the solana CLI works; spawns it on the first call only
+    		static bool checkSolanaInstallation();
     		static void logout();
 
 		
@@ -289,83 +297,120 @@ class UserAccount {
         		return SolanaIntegration::getBalance(walletAddress);
     		}
 
-    		static void setAllUsers(V<UserAccount*>& users) {
-        		allUsers = users;
-    		}
-    		static const V<UserAccount*>& getAllUsers() {
-        		return allUsers;
-    		}
-
     		static UserAccount* findUserByWallet(const std::string& walletAddress) {
-        		if (allUsers.size() == 0) return nullptr;
-        
-        		for (UserAccount* user : allUsers) {
-            			if (user && user->getWalletAddress() == walletAddress) {
-                			return user;
-            			}
-        		}
-        		return nullptr;
+        		return userRegistry().findByWallet(walletAddress);
     		}
 
+		// Case-insensitive; see UserRegistry::normalizeEmail
+		static UserAccount* findUserByEmail(const std::string& email) {
+			return userRegistry().findByEmail(email);
+		}
+
+		// Full argon2 verify against the stored hash; /api/login runs it once per session
+		bool checkPassword(const std::string& candidate) const {
+			return !passwordHash.empty() && passwordHasher().verify(candidate, passwordHash);
+		}
+
 		 SolanaWallet& getWallet() { return wallet; }
 		 
-		 // Marketplace integration methods
-		 V<NFT>& getOwnedNFTs() { return ownedNFTs; }
-		 void setOwnedNFTs(const V<NFT>& nfts) { ownedNFTs = nfts; }
+		 // Marketplace integration methods. Each is a hash lookup, whatever the inventory size.
+		 const V<NFT>& getOwnedNFTs() const { return ownedNFTs; }
+		 NFT* findOwnedNFT(TokenId tokenId);
+		 // Owned, or held in one of the collections
+		 bool holdsNFT(TokenId tokenId) const;
+		 // Takes the token out of ownedNFTs and every collection holding it
+		 bool releaseNFT(TokenId tokenId);
+		 // Adds to ownedNFTs and the first collection, creating "My NFTs" if there is none
+		 void receiveNFT(const NFT& nft);
+		 void addOwnedNFT(const NFT& nft);
 		 std::string getName() const { return name; }
 		 std::string getEmail() const { return email; }
-		 void saveCollections(const std::string& dir);
-		 void loadCollections(const std::string& dir);
+		 // True if collections.json still had the NFTs inline; stageCollections moves them out
+		 bool loadCollections(const std::string& dir);
+
+		 // Account store layout mirrors the old keypairs/<name>_<email>/ tree, except that
+		 // every NFT (nfts/<tokenId>) and every purchase (transactions/<id>) is a record of
+		 // its own: a sale or listing rewrites a few small records, never the inventory.
+		 // Stage with the account locked and commit before unlocking, so writes to one
+		 // account reach the store in the order they were made.
+		 std::string getKeypairDir() const;
+		 std::string infoJson() const;
+		 // Names and creators only; the NFTs are in their own records
+		 std::string collectionsJson() const;
+		 void stageUserData(WriteBatch& batch, const std::string& dir) const;
+		 // collections.json and every NFT record
+		 void stageCollections(WriteBatch& batch, const std::string& dir) const;
+		 void stageCollectionList(WriteBatch& batch, const std::string& dir) const;
+		 // The token's record as this account now holds it, or its removal if it holds it no more
+		 void stageNFT(WriteBatch& batch, const std::string& dir, TokenId tokenId) const;
+		 void stageTransaction(WriteBatch& batch, const std::string& dir, const std::string& transactionId) const;
+
+		 // Binary startup image (see snapshot.hpp)
+		 void addToSnapshot(SnapshotBuilder& builder) const;
+		 static void loadFromSnapshot(UserTable& users, const SnapshotImage& image);
+};
+
+
+/*
+ * Holds the locks of one or two accounts across a check-and-update that
+ * must not interleave with another thread's: a sale, a listing, a mint
+ * landing, a flush staging the account. The menu, the API server's
+ * threads and the mint results all reach the same accounts. Two accounts
+ * are locked in address order, so threads locking the same pair from
+ * either side can't deadlock. Never held across user input or an RPC.
+ *
+ * Lock order: token lock, then account locks, then the marketplace's
+ * stateMutex.
+ */
+class AccountGuard {
+	private:
+		std::unique_lock<std::mutex> first;
+		std::unique_lock<std::mutex> second;
+	public:
+		explicit AccountGuard(const UserAccount& account);
+		// other may be null or the same account
+		AccountGuard(const UserAccount& account, const UserAccount* other);
 };
 
 
 class NFT {
 	private:
-		std::string tokenId;
+		TokenId tokenId;
 		std::string name;
-		std::string owner;
+		Pubkey owner;
 		double price;
 		bool isListed;
 
 		std::string mintAddress;
 		std::string metadataUri;
+		std::string collection;
 	public:
-		NFT() : tokenId(""), name(""), owner(""), price(0.0), isListed(false) {}
+		NFT() : name(""), price(0.0), isListed(false) {}
 
 		NFT(std::string name, std::string owner, double price, bool isListed = false, std::string metadata = "") 
-        		: tokenId(generateTokenId()), name(name), owner(owner), price(price), isListed(isListed), metadataUri(metadata) {}
+        		: tokenId(TokenId::generate()), name(name), owner(Pubkey::parse(owner)), price(price), isListed(isListed), metadataUri(metadata) {}
 
 		// Constructor with explicit tokenId (for loading from file)
 		NFT(std::string tokenId, std::string name, std::string owner, double price, bool isListed = false, std::string metadata = "") 
-        		: tokenId(tokenId), name(name), owner(owner), price(price), isListed(isListed), metadataUri(metadata) {}
-
-		// Copy constructor to preserve all data
-		NFT(const NFT& other) : tokenId(other.tokenId), name(other.name), owner(other.owner), 
-			price(other.price), isListed(other.isListed), mintAddress(other.mintAddress), metadataUri(other.metadataUri) {}
-
-		// Assignment operator
-		NFT& operator=(const NFT& other) {
-			if (this != &other) {
-				tokenId = other.tokenId;
-				name = other.name;
-				owner = other.owner;
-				price = other.price;
-				isListed = other.isListed;
-				mintAddress = other.mintAddress;
-				metadataUri = other.metadataUri;
-			}
-			return *this;
-		}
+        		: tokenId(TokenId::parse(tokenId)), name(name), owner(Pubkey::parse(owner)), price(price), isListed(isListed), metadataUri(metadata) {}
+
+		// Memberwise copy/move: moves let V<NFT> relocate without deep-copying strings
+		NFT(const NFT& other) = default;
+		NFT(NFT&& other) noexcept = default;
+		NFT& operator=(const NFT& other) = default;
+		NFT& operator=(NFT&& other) noexcept = default;
 
  		~NFT() = default;
 
+		// Mints through mintQueue() and waits for the result
 		bool mintOnSolana() {
 			 try {
-            			std::string newMintAddress = SolanaIntegration::mintNFT(metadataUri);
-            			if (!newMintAddress.empty()) {
-                			mintAddress = newMintAddress;
+            			MintResult result = mintQueue().submit(MintRequest{tokenId.toString(), owner.toString(), metadataUri}).result.get();
+            			if (result.succeeded()) {
+                			mintAddress = result.mintAddress;
                 			return true;
             			}
+            			std::cerr << "Mint failed: " << result.error << std::endl;
             			return false;
         		} catch (...) {
             			return false;	
@@ -377,6 +422,9 @@ class NFT {
 		}
 
 		std::string getTokenId() const {
+			return tokenId.toString();
+		}
+		TokenId id() const {
 			return tokenId;
 		}
 
@@ -385,6 +433,9 @@ class NFT {
 		}
 
 		std::string getOwner() const {
+			return owner.toString();
+		}
+		const Pubkey& ownerKey() const {
 			return owner;
 		}
 
@@ -400,7 +451,10 @@ class NFT {
 		       	price = newPrice; 
 		}
     		void setOwner(const std::string& newOwner) { 
-			owner = newOwner; 
+			owner = Pubkey::parse(newOwner); 
+		}
+		void setOwner(const Pubkey& newOwner) {
+			owner = newOwner;
 		}
     		void setIsListed(bool listed) { 
 			isListed = listed; 
@@ -414,12 +468,21 @@ class NFT {
 		void setMintAddress(const std::string& address) {
 			mintAddress = address;
 		}	
+		std::string getCollection() const {
+			return collection;
+		}
+		void setCollection(const std::string& collectionName) {
+			collection = collectionName;
+		}
 
 		void listForSale(double newPrice);
 		void unlist();
 
 		void displayDetails() const;
 
+		SnapshotNFT toSnapshot(SnapshotBuilder& builder) const;
+		static NFT fromSnapshot(const SnapshotImage& image, const SnapshotNFT& record);
+
 
 };
 
@@ -429,6 +492,8 @@ class Collection {
 		std::string name;
     		std::string creator;
     		V<NFT> nfts;
+		// tokenId -> slot in nfts
+		FlatHashIndex<TokenId> slots;
 
 	public:
 		Collection() = default;
@@ -436,55 +501,215 @@ class Collection {
     		Collection(std::string name, std::string creator)
         		: name(name),  creator(creator) {}
 
-		Collection(const Collection& other) : name(other.name), creator(other.creator), nfts(other.nfts) {}
+		Collection(const Collection& other) = default;
+		Collection(Collection&& other) noexcept = default;
+		Collection& operator=(const Collection& other) = default;
+		Collection& operator=(Collection&& other) noexcept = default;
 
-		Collection& operator=(const Collection& other) {
-        		if (this != &other) {
-            			name = other.name;
-            			creator = other.creator;
-            			nfts = other.nfts;
-        		}
-        	return *this;
-    		}	    
     		std::string getName() const { return name; }
     		std::string getCreator() const { return creator; }
     
-    		void addNFT(const NFT& nft) { nfts.push_back(nft); }
+    		// Replaces the collection's copy if the token is already in it
+    		void addNFT(const NFT& nft);
+		// Swap-and-pop, so the last NFT takes the removed one's place
+		bool removeNFT(TokenId tokenId);
+		NFT* findNFT(TokenId tokenId);
+		const NFT* findNFT(TokenId tokenId) const;
+		bool contains(TokenId tokenId) const { return slots.contains(tokenId); }
     		void displayCollection() const;
 
-		V<NFT>& getNFTs() { return nfts; }
+		// Read-only: adding or removing goes through addNFT/removeNFT so slots stays right
 		const V<NFT>& getNFTs() const {return nfts; }
+
+		// Adds the collection's NFTs, then the collection record itself
+		void addToSnapshot(SnapshotBuilder& builder) const;
+		static Collection fromSnapshot(const SnapshotImage& image, const SnapshotCollection& record);
+};
+
+// One page of a TransactionStore query. nextCursor is set when more follow;
+// passing it back continues after the last item of this page.
+struct TransactionPage {
+    V<Transaction> items;
+    std::optional<uint64_t> nextCursor;
+};
+
+/*
+ * Completed sales in the order they were recorded, with indexes by
+ * transaction id, by wallet (as buyer or seller) and by token id. Each
+ * wallet and token keeps the sequence numbers of its transactions in
+ * ascending order, so a page is a binary search for the cursor and then
+ * a walk of at most `limit` entries: O(log n + page) however many sales
+ * there are in total. Cursors are sequence numbers, stable across appends.
+ *
+ * Append-only and not synchronized; the marketplace guards it with its
+ * state lock.
+ */
+class TransactionStore {
+public:
+    enum class Order { NEWEST_FIRST, OLDEST_FIRST };
+
+private:
+    V<Transaction> records;     // position is the sequence number
+    FlatHashIndex<std::string> byId;
+    std::unordered_map<Pubkey, V<uint64_t>> byWallet;
+    std::unordered_map<TokenId, V<uint64_t>> byToken;
+
+    TransactionPage page(const V<uint64_t>& sequences, std::optional<uint64_t> cursor, size_t limit, Order order) const;
+
+public:
+    // False (and nothing stored) if a transaction with the same id is already here
+    bool append(const Transaction& transaction);
+    void reserve(size_t n);
+
+    size_t size() const { return records.size(); }
+    bool empty() const { return records.empty(); }
+    bool contains(const std::string& transactionId) const { return byId.contains(transactionId); }
+    const Transaction* find(const std::string& transactionId) const;
+
+    // Every transaction
+    TransactionPage all(std::optional<uint64_t> cursor, size_t limit, Order order = Order::NEWEST_FIRST) const;
+    // Sales the wallet bought or sold
+    TransactionPage forWallet(const Pubkey& wallet, std::optional<uint64_t> cursor, size_t limit,
+                              Order order = Order::NEWEST_FIRST) const;
+    // Provenance: every sale of the token
+    TransactionPage forToken(TokenId tokenId, std::optional<uint64_t> cursor, size_t limit,
+                             Order order = Order::OLDEST_FIRST) const;
+
+    const Transaction* begin() const { return records.begin(); }
+    const Transaction* end() const { return records.end(); }
 };
 
+// Read-only summary of one collection's listings. Each change to the
+// collection publishes a new one; published views are never modified.
+struct CollectionListingsView {
+    std::optional<double> floorPrice;
+    size_t listingCount = 0;
+    V<OrderBookEntry> cheapest;     // first VIEW_DEPTH entries of the order book
+};
+using ListingsView = std::unordered_map<std::string, std::shared_ptr<const CollectionListingsView>>;
+
+// One page of Marketplace::getListingsPage. next is set when more may follow;
+// passing it back as `after` continues where this page ended.
+struct ListingPage {
+    V<NFT> items;
+    std::optional<OrderBookEntry> next;
+};
+
+/*
+ * Shared between the menu thread and the API server's threads.
+ *
+ * stateMutex guards listings, index, order books and transactions. Readers
+ * share it; writers hold it only for the in-memory change itself. Per-token
+ * striped locks make list/unlist/buy of one token run one at a time, which
+ * is what stops a listing being sold twice, while other tokens proceed in
+ * parallel. Floor prices and cheapest listings are served from an
+ * immutable ListingsView swapped in after every change, so those reads
+ * take no lock at all.
+ *
+ * Lock order: token lock, then compactionMutex, then stateMutex.
+ */
 class Marketplace {
 private:
     V<NFT> listedNFTs;
-    V<Transaction> transactionHistory;
+    // tokenId -> slot in listedNFTs, kept in step with every insert/remove
+    FlatHashIndex<TokenId> listingIndex;
+    // Price, token, owner, collection and listing order of listedNFTs, slot for slot, for scans
+    ListingColumns listingColumns;
+    // collection name -> listings ordered by price, then listing time
+    std::unordered_map<std::string, OrderBook> collectionBooks;
+    // Every listing, whatever its collection, for pages that don't filter on one
+    OrderBook allListings;
+    uint64_t nextListingSeq = 1;
+    TransactionStore transactions;
+    // List/unlist/buy events since the last snapshot (listings.json + transactions.json)
+    MarketplaceJournal journal;
+    std::once_flag journalOpened;
+
+    mutable std::shared_mutex stateMutex;
+    static constexpr size_t TOKEN_LOCK_STRIPES = 64;
+    std::array<std::mutex, TOKEN_LOCK_STRIPES> tokenLocks;
+    // Held while listings.json/transactions.json are rewritten and the journal truncated
+    std::mutex compactionMutex;
+    // Set from the moment a compaction is queued until it has run, so only one waits at a time
+    std::atomic<bool> compactionQueued{false};
+    // One thread that compacts the journal off the request path
+    ThreadPool compactor{1};
+    // Read with std::atomic_load, replaced with std::atomic_store
+    std::shared_ptr<const ListingsView> listingsView;
+    static constexpr size_t VIEW_DEPTH = 32;
+
     static Marketplace* instance;
+    static std::once_flag instanceCreated;
     static constexpr double PLATFORM_FEE = 0.025;
-
-    Marketplace() {} 
+    static constexpr uint64_t JOURNAL_COMPACT_RECORDS = 1000;
+    // Transactions compact() writes per hold of the state lock
+    static constexpr size_t COMPACT_CHUNK = 4096;
+
+    Marketplace() : listingsView(std::make_shared<const ListingsView>()) {}
+
+    std::mutex& tokenLock(TokenId tokenId);
+    // The next four expect stateMutex held exclusively
+    void addListing(const NFT& nft);
+    // Returns the listing, moved out of listedNFTs
+    NFT removeListingAt(size_t slot);
+    void appendTransaction(const Transaction& transaction);
+    void publishView(const std::string& collection);
+    void publishAllViews();
+    void openJournal();
+    void journalEvent(const ByteWriter& record);
+    void applyJournalRecord(ByteReader& reader);
+    void compact();
 
 public:
+    static constexpr size_t MAX_PAGE_SIZE = 100;
+
     Marketplace(const Marketplace&) = delete;
     Marketplace& operator=(const Marketplace&) = delete;
 
     static Marketplace* getInstance();
-    void unlistNFT(const std::string& tokenId);
-    void buyNFT(const std::string& tokenId, UserAccount& buyer);
+    // Only the listing's owner can take it down. Throws PersistenceError if the listing
+    // came down but the seller's record could not be saved.
+    void unlistNFT(const std::string& tokenId, UserAccount& seller);
+    // Throws PersistenceError if the sale went through but could not be saved; any
+    // other exception means it was refused and nothing changed
+    Transaction buyNFT(const std::string& tokenId, UserAccount& buyer);
     void recordTransaction(const Transaction& transaction);
-    const Transaction* getTransaction(const std::string& transactionId) const;
+    std::optional<Transaction> getTransaction(const std::string& transactionId) const;
+    // Newest first; limit is capped at MAX_PAGE_SIZE
+    TransactionPage getTransactions(std::optional<uint64_t> cursor, size_t limit) const;
+    TransactionPage getWalletTransactions(const std::string& walletAddress, std::optional<uint64_t> cursor, size_t limit) const;
+    // Oldest first: the token's chain of owners
+    TransactionPage getProvenance(const std::string& tokenId, std::optional<uint64_t> cursor, size_t limit) const;
     void displayListedNFTs() const;
     void displayTransactionHistory() const;
-    NFT* findNFTByTokenId(const std::string& tokenId);
+    std::optional<NFT> findNFTByTokenId(const std::string& tokenId) const;
     double calculateFee(double price) const { return price * PLATFORM_FEE; }
-    bool hasListedNFTs() const { return !listedNFTs.empty(); }
-    bool listNFT(NFT& nft, double price);
+    bool hasListedNFTs() const { return !getListingsView()->empty(); }
+    // Finds the seller's own copy in their collections; false (and why, on cerr) if it can't be
+    // listed. Throws PersistenceError if it was listed but the seller's record could not be saved.
+    bool listNFT(const std::string& tokenId, double price, UserAccount& seller);
+    std::shared_ptr<const ListingsView> getListingsView() const { return std::atomic_load(&listingsView); }
+    std::optional<double> getFloorPrice(const std::string& collection) const;
+    V<OrderBookEntry> getCheapestListings(const std::string& collection, size_t count) const;
+    // Listings priced within [minPrice, maxPrice]; an empty collection means all of them
+    ListingStats getListingStats(double minPrice, double maxPrice, const std::string& collection = "") const;
+    ListingStats getOwnerListingStats(const std::string& ownerAddress) const;
+    // Stable order: price ties go to the earlier listing. An empty collection means all
+    // of them; limit is capped at MAX_PAGE_SIZE. A recency page with a price range may come
+    // back short, even empty, with next set (see OrderBook::page)
+    ListingPage getListingsPage(const std::string& collection, double minPrice, double maxPrice,
+                                ListingSort sort, const std::optional<OrderBookEntry>& after, size_t limit) const;
     void saveMarketplaceData();
     void loadMarketplaceData();
+    // Sales and listings commit their account records before the journal append, so a
+    // crash between the two leaves the accounts ahead. Brings listings and history back
+    // in line with them; call once users and marketplace data are both loaded.
+    void reconcileWithAccounts();
+    void addToSnapshot(SnapshotBuilder& builder) const;
+    void loadFromSnapshot(const SnapshotImage& image);
 };
 
-void menu(std::vector<UserAccount>& users, std::vector<NFT>& nfts, std::vector<Collection>& collections);
+void menu(UserTable& users, std::vector<NFT>& nfts, std::vector<Collection>& collections);
 
 
 
@@ -0,0 +1,170 @@
+#ifndef JSON_READER_HPP
+#define JSON_READER_HPP
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Callbacks for JsonReader. Views are only valid during the call.
+class JsonHandler {
+public:
+    virtual ~JsonHandler() = default;
+
+    virtual void startObject() {}
+    virtual void endObject() {}
+    virtual void startArray() {}
+    virtual void endArray() {}
+    virtual void key(std::string_view) {}
+    virtual void string(std::string_view) {}
+    virtual void number(double) {}
+    virtual void boolean(bool) {}
+    virtual void null() {}
+};
+
+/*
+ * Streaming (SAX-style) JSON parser over text already in memory. String
+ * tokens are views into the input unless they contain escapes, in which
+ * case they are decoded into a reused scratch buffer, so parsing a
+ * document does no per-token allocation.
+ *
+ * Raw control characters inside strings are accepted: older snapshots
+ * wrote ctime() timestamps with their trailing newline unescaped.
+ * Malformed input throws std::runtime_error naming the byte offset.
+ */
+class JsonReader {
+private:
+    std::string_view text;
+    size_t pos = 0;
+    std::string scratch;
+
+    static constexpr int MAX_DEPTH = 64;
+
+    [[noreturn]] void fail(const char* message) const;
+    void skipWhitespace();
+    void expect(char c);
+    void expectLiteral(std::string_view literal);
+    void parseValue(JsonHandler& handler, int depth);
+    void parseObject(JsonHandler& handler, int depth);
+    void parseArray(JsonHandler& handler, int depth);
+    std::string_view parseString();
+    void decodeEscape();
+    double parseNumber();
+
+public:
+    explicit JsonReader(std::string_view input) : text(input) {}
+
+    // Parses one document, reporting every token to handler in order
+    void parse(JsonHandler& handler);
+};
+
+// Binds the keys of one JSON object to variables, so a handler can fill
+// a record without comparing key names itself
+class JsonFields {
+private:
+    struct Binding {
+        std::string_view key;
+        std::string* text;
+        double* number;
+        bool* flag;
+    };
+    std::vector<Binding> bindings;
+    const Binding* selected = nullptr;
+
+public:
+    void bind(std::string_view key, std::string& target) { bindings.push_back(Binding{key, &target, nullptr, nullptr}); }
+    void bind(std::string_view key, double& target) { bindings.push_back(Binding{key, nullptr, &target, nullptr}); }
+    void bind(std::string_view key, bool& target) { bindings.push_back(Binding{key, nullptr, nullptr, &target}); }
+
+    // Empties every bound variable before the next object
+    void reset() {
+        for (const auto& b : bindings) {
+            if (b.text) b.text->clear();
+            if (b.number) *b.number = 0.0;
+            if (b.flag) *b.flag = false;
+        }
+        selected = nullptr;
+    }
+
+    // Picks the variable the next value goes to; unknown keys are ignored
+    void key(std::string_view name) {
+        selected = nullptr;
+        for (const auto& b : bindings) {
+            if (b.key == name) {
+                selected = &b;
+                break;
+            }
+        }
+    }
+
+    void string(std::string_view value) {
+        if (selected && selected->text) selected->text->assign(value.data(), value.size());
+        selected = nullptr;
+    }
+    void number(double value) {
+        if (selected && selected->number) *selected->number = value;
+        selected = nullptr;
+    }
+    void boolean(bool value) {
+        if (selected && selected->flag) *selected->flag = value;
+        selected = nullptr;
+    }
+};
+
+// Tracks how deeply the current token is nested: the top-level object is
+// depth 1, an array inside it depth 2, and so on
+class JsonDepthHandler : public JsonHandler {
+protected:
+    int depth = 0;
+
+    virtual void objectStart(int) {}
+    virtual void objectEnd(int) {}
+
+public:
+    void startObject() override { objectStart(++depth); }
+    void endObject() override { objectEnd(depth--); }
+    void startArray() override { ++depth; }
+    void endArray() override { --depth; }
+};
+
+// Fills fields from every object at recordDepth and calls onRecord as each
+// one closes. Depth 1 is a single top-level object; depth 3 is each element
+// of {"items": [ {...}, ... ]}, the layout of every list this backend saves.
+class JsonRecordHandler : public JsonDepthHandler {
+private:
+    JsonFields& fields;
+    int recordDepth;
+    std::function<void()> onRecord;
+
+protected:
+    void objectStart(int d) override {
+        if (d == recordDepth) fields.reset();
+    }
+    void objectEnd(int d) override {
+        if (d == recordDepth) onRecord();
+    }
+
+public:
+    JsonRecordHandler(JsonFields& recordFields, int depthOfRecords, std::function<void()> recordDone)
+        : fields(recordFields), recordDepth(depthOfRecords), onRecord(std::move(recordDone)) {}
+
+    void key(std::string_view name) override {
+        if (depth == recordDepth) fields.key(name);
+    }
+    void string(std::string_view value) override {
+        if (depth == recordDepth) fields.string(value);
+    }
+    void number(double value) override {
+        if (depth == recordDepth) fields.number(value);
+    }
+    void boolean(bool value) override {
+        if (depth == recordDepth) fields.boolean(value);
+    }
+};
+
+// Reads a whole file and parses it. Returns false if the file can't be opened.
+bool parseJsonFile(const std::string& path, JsonHandler& handler);
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef JSON_WRITER_HPP
+#define JSON_WRITER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Builds a JSON document into one growable buffer. clear() keeps the
+ * buffer's capacity, so a writer that is reused (e.g. thread_local) stops
+ * allocating once it has seen its largest document. Strings are escaped;
+ * doubles are written in their shortest round-trip form.
+ *
+ *   JsonWriter json;
+ *   json.beginObject().field("name", name).field("price", price).endObject();
+ *   writeFileAtomic(path, json.str());
+ */
+class JsonWriter {
+private:
+    std::string buffer;
+    // One entry per open container: true once it holds a value
+    std::vector<bool> hasValue;
+    bool afterKey = false;
+    bool pretty;
+
+    void newline();
+    void beforeValue();
+    void open(char bracket);
+    void close(char bracket);
+    void appendEscaped(std::string_view text);
+    JsonWriter& integer(int64_t number);
+    JsonWriter& unsignedInteger(uint64_t number);
+
+public:
+    explicit JsonWriter(bool prettyPrint = false, size_t initialCapacity = 4096);
+
+    void clear();
+
+    JsonWriter& beginObject() { open('{'); return *this; }
+    JsonWriter& endObject() { close('}'); return *this; }
+    JsonWriter& beginArray() { open('['); return *this; }
+    JsonWriter& endArray() { close(']'); return *this; }
+
+    JsonWriter& key(std::string_view name);
+
+    JsonWriter& value(std::string_view text);
+    JsonWriter& value(const std::string& text) { return value(std::string_view(text)); }
+    JsonWriter& value(const char* text) { return value(std::string_view(text)); }
+    JsonWriter& value(double number);
+    JsonWriter& value(bool flag);
+
+    template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+    JsonWriter& value(T number) {
+        if (std::is_signed<T>::value) {
+            return integer(static_cast<int64_t>(number));
+        }
+        return unsignedInteger(static_cast<uint64_t>(number));
+    }
+    JsonWriter& null();
+
+    template<typename T>
+    JsonWriter& field(std::string_view name, const T& v) {
+        key(name);
+        return value(v);
+    }
+
+    const std::string& str() const { return buffer; }
+    size_t size() const { return buffer.size(); }
+};
+
+// Appends the shortest decimal form of value that reads back exactly
+void appendShortestDouble(std::string& out, double value);
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef KV_STORE_HPP
+#define KV_STORE_HPP
+
+#include "V.hpp"
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+// A group of puts/removes that a KeyValueStore applies all-or-nothing
+class WriteBatch {
+public:
+    struct Op {
+        bool remove;
+        std::string key;
+        std::string value;
+    };
+
+    void put(const std::string& key, const std::string& value) { ops.push_back(Op{false, key, value}); }
+    void remove(const std::string& key) { ops.push_back(Op{true, key, std::string()}); }
+
+    const V<Op>& operations() const { return ops; }
+    bool empty() const { return ops.empty(); }
+    void clear() { ops.clear(); }
+
+private:
+    V<Op> ops;
+};
+
+// Storage interface that user accounts persist through. Marketplace trades commit
+// their account records here too, but listings and the sale history live in
+// marketplace/ (snapshot files plus MarketplaceJournal), not in this store.
+class KeyValueStore {
+public:
+    virtual ~KeyValueStore() = default;
+
+    virtual bool get(const std::string& key, std::string& value) const = 0;
+    virtual V<std::string> keysWithPrefix(const std::string& prefix) const = 0;
+    // Applies every operation in batch atomically and durably
+    virtual void commit(const WriteBatch& batch) = 0;
+
+    void put(const std::string& key, const std::string& value) {
+        WriteBatch batch;
+        batch.put(key, value);
+        commit(batch);
+    }
+};
+
+/*
+ * Log-structured store in a single file. Every commit appends one
+ * checksummed frame holding the whole batch, so a batch is either fully
+ * replayed on open or (torn write) dropped. The live data is kept in
+ * memory; the file is rewritten when dead records outweigh live ones.
+ *
+ * File layout: 8-byte header, then frames of
+ *   [u32 payload length][u32 crc32][u32 op count][op...]
+ *   op = [u8 remove][u32 key length][key][u32 value length][value]
+ */
+class LogStructuredStore : public KeyValueStore {
+private:
+    std::string path;
+    int fd = -1;
+    mutable std::mutex mutex;
+    std::map<std::string, std::string> data;
+    uint64_t fileBytes = 0;
+    uint64_t liveBytes = 0;
+    // Set while the last compaction's rename may not have reached the disk
+    bool renameUnsynced = false;
+
+    void load();
+    void appendFrame(const std::string& payload);
+    void compactLocked();
+
+public:
+    explicit LogStructuredStore(const std::string& storePath);
+    ~LogStructuredStore() override;
+
+    LogStructuredStore(const LogStructuredStore&) = delete;
+    LogStructuredStore& operator=(const LogStructuredStore&) = delete;
+
+    bool get(const std::string& key, std::string& value) const override;
+    V<std::string> keysWithPrefix(const std::string& prefix) const override;
+    void commit(const WriteBatch& batch) override;
+
+    size_t keyCount() const;
+    // Rewrites the file with only live records
+    void compact();
+};
+
+// Process-wide account store (data/accounts.db)
+KeyValueStore& accountStore();
+
+#endif
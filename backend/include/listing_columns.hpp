@@ -0,0 +1,77 @@
+#ifndef LISTING_COLUMNS_HPP
+#define LISTING_COLUMNS_HPP
+
+#include "pubkey.hpp"
+#include "token_id.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Aggregates over the listings a scan matched; minPrice is meaningless when count is 0
+struct ListingStats {
+    size_t count = 0;
+    double totalPrice = 0.0;
+    double minPrice = std::numeric_limits<double>::infinity();
+};
+
+/*
+ * Live listings one column per field: price, token id, owner, collection
+ * and listing order, each in its own contiguous array. Slot i of every
+ * column describes the same listing, and the owner keeps the slots in step
+ * with its own list (append on insert, swap-and-pop on remove).
+ *
+ * Scans read only the columns they filter on, 8 bytes of price plus 4 of
+ * owner or collection per listing, instead of walking NFT objects and
+ * their strings. The price kernels use SSE2 or NEON where the target has
+ * them (both are baseline on x86-64 and AArch64) and plain loops
+ * otherwise.
+ *
+ * Owners and collections are numbered by the first listing that uses them;
+ * the numbers are not reused. Not synchronized: the marketplace guards it
+ * with the same lock as its listings.
+ */
+class ListingColumns {
+public:
+    static constexpr uint32_t NO_KEY = UINT32_MAX;
+    static constexpr double ANY_PRICE = std::numeric_limits<double>::infinity();
+
+private:
+    std::vector<double> prices;
+    std::vector<uint64_t> tokenIds;     // TokenId::raw()
+    std::vector<uint32_t> ownerIds;
+    std::vector<uint32_t> collectionIds;
+    std::vector<uint64_t> listedSeqs;   // marketplace listing order, as in OrderBookEntry
+
+    std::unordered_map<Pubkey, uint32_t> ownerNumbers;
+    std::unordered_map<std::string, uint32_t> collectionNumbers;
+
+    static uint32_t number(std::unordered_map<Pubkey, uint32_t>& numbers, const Pubkey& key);
+    static uint32_t number(std::unordered_map<std::string, uint32_t>& numbers, const std::string& key);
+
+public:
+    void append(TokenId tokenId, double price, const Pubkey& owner, const std::string& collection, uint64_t listedSeq);
+    // Moves the last slot into slot, then drops the last slot
+    void removeAt(size_t slot);
+    void reserve(size_t n);
+
+    size_t size() const { return prices.size(); }
+    bool empty() const { return prices.empty(); }
+
+    double price(size_t slot) const { return prices[slot]; }
+    TokenId tokenId(size_t slot) const;
+    uint64_t listedSeq(size_t slot) const { return listedSeqs[slot]; }
+
+    // Column keys for filters; NO_KEY if nothing listed has ever used them
+    uint32_t ownerKey(const Pubkey& owner) const;
+    uint32_t collectionKey(const std::string& collection) const;
+
+    // Listings priced within [minPrice, maxPrice]
+    ListingStats stats(double minPrice = 0.0, double maxPrice = ANY_PRICE) const;
+    ListingStats ownerStats(uint32_t ownerKey, double minPrice = 0.0, double maxPrice = ANY_PRICE) const;
+    ListingStats collectionStats(uint32_t collectionKey, double minPrice = 0.0, double maxPrice = ANY_PRICE) const;
+};
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef MARKETPLACE_JOURNAL_HPP
+#define MARKETPLACE_JOURNAL_HPP
+
+#include "byte_buffer.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+
+/*
+ * Append-only, checksummed log of marketplace events.
+ *
+ * File layout: an 8-byte header, then frames of
+ *   [u32 payload length][u32 crc32 of payload][payload]
+ *
+ * append() returns once the record is on disk. Records appended while
+ * another thread is flushing are written and fsynced together in the next
+ * batch (group commit), so concurrent writers share one fsync.
+ */
+class MarketplaceJournal {
+public:
+    // How far the durable records reach at one moment; see mark()
+    struct Mark {
+        uint64_t bytes = 0;
+        uint64_t records = 0;
+    };
+
+private:
+    std::string path;
+    int fd = -1;
+
+    mutable std::mutex mutex;
+    std::condition_variable flushed;
+    std::string pending;            // framed records not yet written
+    uint64_t appendedSeq = 0;       // records handed to append()
+    uint64_t durableSeq = 0;        // records known to be on disk
+    uint64_t failedSeq = 0;         // records up to here were in a failed batch
+    bool flushing = false;
+    uint64_t recordCount = 0;       // records in the file since the last reset
+    uint64_t fileBytes = 0;
+
+    void openLocked();
+    void writeAll(const std::string& data);
+
+public:
+    MarketplaceJournal() = default;
+    ~MarketplaceJournal();
+
+    MarketplaceJournal(const MarketplaceJournal&) = delete;
+    MarketplaceJournal& operator=(const MarketplaceJournal&) = delete;
+
+    // Opens (creating if needed) the journal file at journalPath
+    void open(const std::string& journalPath);
+    bool isOpen() const { return fd >= 0; }
+
+    // Feeds every intact record to apply, then truncates any torn or corrupt tail.
+    // Returns the number of records replayed.
+    size_t replay(const std::function<void(ByteReader&)>& apply);
+
+    // Durably appends one record (blocks until fsynced)
+    void append(const ByteWriter& record);
+
+    // The end of the records already on disk. Taken together with a copy of the
+    // state, it says which records that copy covers.
+    Mark mark() const;
+
+    // Drops the records before upTo once a snapshot covering them is on disk.
+    // Records appended since are kept; they are rewritten into a fresh file,
+    // so only what was appended during the snapshot is copied.
+    void truncate(const Mark& upTo);
+
+    uint64_t records() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return recordCount;
+    }
+    uint64_t bytes() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return fileBytes;
+    }
+};
+
+#endif
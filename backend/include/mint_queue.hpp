@@ -0,0 +1,76 @@
+#ifndef MINT_QUEUE_HPP
+#define MINT_QUEUE_HPP
+
+#include "thread_pool.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct MintRequest {
+    std::string tokenId;
+    std::string owner;      // wallet address the NFT belongs to
+    std::string metadata;
+};
+
+struct MintResult {
+    uint64_t jobId = 0;
+    std::string tokenId;
+    std::string owner;
+    std::string mintAddress;   // empty when the job failed
+    std::string error;
+
+    bool succeeded() const { return !mintAddress.empty(); }
+};
+
+/*
+ * Runs NFT mints on a fixed set of workers. Each job gets its own
+ * directory under the work dir for its keypair and metadata, so jobs never
+ * share files. submit() blocks once `capacity` jobs are outstanding.
+ * Results are both returned through the ticket's future and kept until
+ * takeCompleted() collects them, so the owning thread can write mint
+ * addresses back into its own data.
+ */
+class MintQueue {
+public:
+    struct Ticket {
+        uint64_t jobId;
+        std::shared_future<MintResult> result;
+    };
+
+private:
+    std::string workDir;
+    std::string runId;          // keeps job directories unique across restarts
+    size_t capacity;
+
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+    size_t outstanding = 0;
+    std::vector<MintResult> completed;
+    std::atomic<uint64_t> nextJobId{1};
+
+    // Last member: destroyed first, so queued jobs finish while the rest is alive
+    ThreadPool workers;
+
+    MintResult run(uint64_t jobId, const MintRequest& request);
+
+public:
+    MintQueue(size_t workerCount, size_t maxOutstanding, const std::string& directory = "mints");
+
+    MintQueue(const MintQueue&) = delete;
+    MintQueue& operator=(const MintQueue&) = delete;
+
+    Ticket submit(MintRequest request);
+    // Finished jobs not yet collected, in completion order
+    std::vector<MintResult> takeCompleted();
+    size_t pending() const;
+    void waitIdle();
+};
+
+// Process-wide queue; worker count from $MINT_WORKERS (default 4)
+MintQueue& mintQueue();
+
+#endif
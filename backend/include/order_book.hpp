@@ -0,0 +1,75 @@
+#ifndef ORDER_BOOK_HPP
+#define ORDER_BOOK_HPP
+
+#include "V.hpp"
+#include "token_id.hpp"
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+struct OrderBookEntry {
+    double price;
+    uint64_t listedSeq;     // marketplace-wide listing order, breaks price ties
+    TokenId tokenId;
+};
+
+// Orders for OrderBook::page
+enum class ListingSort { PRICE_ASC, PRICE_DESC, NEWEST, OLDEST };
+
+// One OrderBook::page. next is set when the walk may not be finished; passing
+// it back as `after` continues from there.
+struct OrderBookPage {
+    V<OrderBookEntry> entries;
+    std::optional<OrderBookEntry> next;
+};
+
+/*
+ * Listings of one collection ordered by price, then by listing time, and
+ * separately by listing time alone. Floor price is O(1); cheapest-N,
+ * price-range scans and pages are O(log n + k).
+ */
+class OrderBook {
+private:
+    struct ByPriceThenSeq {
+        bool operator()(const OrderBookEntry& a, const OrderBookEntry& b) const {
+            if (a.price != b.price) return a.price < b.price;
+            return a.listedSeq < b.listedSeq;
+        }
+    };
+
+    using Book = std::set<OrderBookEntry, ByPriceThenSeq>;
+    Book entries;
+    std::unordered_map<TokenId, Book::iterator> byToken;
+    std::map<uint64_t, Book::iterator> bySeq;
+
+public:
+    void add(TokenId tokenId, double price, uint64_t listedSeq);
+    bool remove(TokenId tokenId);
+
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+
+    std::optional<double> floorPrice() const;
+    V<OrderBookEntry> cheapest(size_t n) const;
+    V<OrderBookEntry> priceRange(double minPrice, double maxPrice,
+                                 size_t limit = std::numeric_limits<size_t>::max()) const;
+    // Recency pages look at no more than this many listings per entry they may return
+    static constexpr size_t RECENCY_SCAN_FACTOR = 16;
+
+    // Up to limit entries priced within [minPrice, maxPrice] in sort order, starting
+    // after `after` (where the previous page stopped, which needn't still be here).
+    // Price orders seek straight to the range. Recency orders filter bySeq as they
+    // walk it and stop after limit * RECENCY_SCAN_FACTOR listings, so a narrow range
+    // can give short or empty pages that still carry a next.
+    OrderBookPage page(ListingSort sort, double minPrice, double maxPrice,
+                       const std::optional<OrderBookEntry>& after, size_t limit) const;
+
+    Book::const_iterator begin() const { return entries.begin(); }
+    Book::const_iterator end() const { return entries.end(); }
+};
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef PASSWORD_HASHER_HPP
+#define PASSWORD_HASHER_HPP
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The hasher's queue is full, or a job waited past its deadline
+class PasswordHasherBusy : public std::runtime_error {
+public:
+    explicit PasswordHasherBusy(const std::string& message) : std::runtime_error(message) {}
+};
+
+// Counts per latency bucket; bucket i holds samples up to BOUNDS_MS[i], the last one the rest
+struct LatencyHistogram {
+    static constexpr std::array<uint32_t, 11> BOUNDS_MS = {1, 2, 5, 10, 25, 50, 100, 250, 500, 1000, 2500};
+    std::array<uint64_t, BOUNDS_MS.size() + 1> counts{};
+    uint64_t totalMs = 0;
+
+    void record(std::chrono::steady_clock::duration elapsed);
+};
+
+/*
+ * Runs argon2id on a fixed number of lanes so a burst of logins can't
+ * allocate more than lanes x memory cost at once. Lanes are sized from the
+ * core count and a memory budget. Jobs beyond the queue limit are rejected
+ * and jobs that waited past the timeout are dropped, both with
+ * PasswordHasherBusy.
+ *
+ * New hashes use the argon2 encoded form ($argon2id$v=19$m=..,t=..,p=..$..),
+ * which records its own parameters; that lets a hash use parallelism > 1
+ * when cores are idle and still verify later. The older salt+hash hex
+ * form (p=1) is still accepted by verify().
+ */
+class PasswordHasher {
+public:
+    struct Options {
+        size_t lanes = 1;
+        size_t maxQueued = 64;
+        std::chrono::milliseconds timeout{5000};
+        uint32_t timeCost = 2;
+        uint32_t memoryCostKiB = 1 << 16;   // 64 MiB
+        uint32_t maxParallelism = 4;
+    };
+
+    struct Stats {
+        size_t lanes;
+        size_t queued;
+        size_t active;
+        uint64_t completed;
+        uint64_t rejected;
+        uint64_t timedOut;
+        LatencyHistogram queueWait;
+        LatencyHistogram hashTime;
+    };
+
+private:
+    struct Job {
+        std::function<void(uint32_t parallelism)> run;
+        std::function<void(std::exception_ptr)> fail;
+        std::chrono::steady_clock::time_point enqueuedAt;
+        bool adaptive = false;   // may use spare cores (new hashes only)
+    };
+
+    Options options;
+    size_t cores;
+
+    mutable std::mutex mutex;
+    std::condition_variable available;
+    std::deque<Job> queue;
+    bool stopping = false;
+    size_t active = 0;
+    size_t busyThreads = 0;
+    uint64_t completed = 0;
+    uint64_t rejected = 0;
+    uint64_t timedOut = 0;
+    LatencyHistogram queueWait;
+    LatencyHistogram hashTime;
+
+    std::vector<std::thread> workers;
+
+    void workerLoop();
+    void enqueue(Job job);
+
+    std::string hashNow(const std::string& password, uint32_t parallelism) const;
+    bool verifyNow(const std::string& password, const std::string& stored) const;
+
+public:
+    explicit PasswordHasher(const Options& options);
+    ~PasswordHasher();
+
+    PasswordHasher(const PasswordHasher&) = delete;
+    PasswordHasher& operator=(const PasswordHasher&) = delete;
+
+    // Both block until their job has run. Throw PasswordHasherBusy or std::runtime_error.
+    std::string hash(const std::string& password);
+    bool verify(const std::string& password, const std::string& stored);
+
+    // True for hashes in the old hex form, which should be replaced on next login
+    static bool needsRehash(const std::string& stored);
+
+    Stats stats() const;
+};
+
+// Process-wide hasher. Lanes = min(cores, $PASSWORD_HASH_MEMORY_MB / 64), default budget 512 MB;
+// $PASSWORD_HASH_QUEUE and $PASSWORD_HASH_TIMEOUT_MS override the queue limit and timeout.
+PasswordHasher& passwordHasher();
+
+#endif
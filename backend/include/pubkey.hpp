@@ -0,0 +1,75 @@
+#ifndef PUBKEY_HPP
+#define PUBKEY_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+/*
+ * A wallet address held as the 32 decoded key bytes rather than ~44 base58
+ * characters, so comparing two is a memcmp and copying one never
+ * allocates. Owners that aren't real keys ("MARKETPLACE", placeholders
+ * from old data) are interned and kept as a small number instead; either
+ * way toString() gives back exactly the text that was parsed.
+ */
+class Pubkey {
+public:
+    static constexpr size_t SIZE = 32;
+
+private:
+    enum Kind : uint8_t { EMPTY = 0, KEY = 1, NAME = 2 };
+
+    std::array<uint8_t, SIZE> bytes{};
+    Kind kind = EMPTY;
+
+    static bool decodeKey(std::string_view text, std::array<uint8_t, SIZE>& out);
+    static Pubkey named(uint32_t id);
+
+public:
+    Pubkey() = default;
+    explicit Pubkey(const std::array<uint8_t, SIZE>& key) : bytes(key), kind(KEY) {}
+
+    // Any text; base58 32-byte keys are decoded, anything else is interned
+    static Pubkey parse(std::string_view text);
+    // Like parse, but never interns: text that was never seen gives an empty Pubkey.
+    // For lookups with untrusted input.
+    static Pubkey lookup(std::string_view text);
+
+    std::string toString() const;
+    bool empty() const { return kind == EMPTY; }
+    bool isKey() const { return kind == KEY; }
+    const std::array<uint8_t, SIZE>& keyBytes() const { return bytes; }
+
+    bool operator==(const Pubkey& other) const {
+        return kind == other.kind && std::memcmp(bytes.data(), other.bytes.data(), SIZE) == 0;
+    }
+    bool operator!=(const Pubkey& other) const { return !(*this == other); }
+    bool operator<(const Pubkey& other) const {
+        if (kind != other.kind) return kind < other.kind;
+        return std::memcmp(bytes.data(), other.bytes.data(), SIZE) < 0;
+    }
+
+    size_t hash() const {
+        // Keys are uniformly random already; names differ in their first bytes
+        uint64_t word;
+        std::memcpy(&word, bytes.data(), sizeof(word));
+        return static_cast<size_t>(word ^ kind);
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& out, const Pubkey& key) {
+    return out << key.toString();
+}
+
+namespace std {
+    template<> struct hash<Pubkey> {
+        size_t operator()(const Pubkey& key) const { return key.hash(); }
+    };
+}
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef SESSION_MANAGER_HPP
+#define SESSION_MANAGER_HPP
+
+#include <array>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+struct Session {
+    std::string email;
+    std::array<uint8_t, 16> id;   // random per login; what revocation refers to
+    std::time_t expiresAt;
+};
+
+/*
+ * Stateless session tokens: base64url(payload) "." base64url(HMAC-SHA256).
+ * The payload carries the email, expiry and a random session id, so
+ * validating a token is one HMAC and a revocation lookup, with no argon2
+ * and no per-session state on the server. Only revoked sessions are
+ * remembered, and only until they would have expired anyway.
+ */
+class SessionManager {
+private:
+    std::string key;
+    long ttlSeconds;
+
+    struct IdHash {
+        size_t operator()(const std::array<uint8_t, 16>& id) const;
+    };
+    mutable std::mutex mutex;
+    std::unordered_map<std::array<uint8_t, 16>, std::time_t, IdHash> revoked;   // id -> expiry
+    std::time_t nextPurge = 0;
+
+    std::string sign(std::string_view payload) const;
+    void purgeExpired(std::time_t now);
+
+public:
+    // secret signs the tokens; tokens from one secret are valid for any process sharing it
+    SessionManager(std::string secret, long timeToLiveSeconds);
+
+    std::string issue(const std::string& email);
+    // The session if the token is authentic, unexpired and not revoked
+    std::optional<Session> validate(std::string_view token) const;
+    // Revokes the token's session; false if the token wasn't valid to begin with
+    bool revoke(std::string_view token);
+
+    size_t revokedCount() const;
+};
+
+// Process-wide manager. Secret from $SESSION_SECRET, else random per process
+// (sessions then end on restart); TTL from $SESSION_TTL_SECONDS (default 12h).
+SessionManager& sessionManager();
+
+#endif
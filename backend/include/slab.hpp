@@ -0,0 +1,183 @@
+#ifndef SLAB_HPP
+#define SLAB_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+// Reference to a slab element: slot number plus the generation it was created in
+struct SlabHandle {
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    uint32_t index = NONE;
+    uint32_t generation = 0;
+
+    bool valid() const { return index != NONE; }
+    bool operator==(const SlabHandle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const SlabHandle& other) const { return !(*this == other); }
+};
+
+/*
+ * Objects in fixed-size chunks that are never moved or freed until the slab
+ * is, so a T* stays valid for as long as the element lives, however many
+ * elements are added after it. Erased slots are reused; each reuse bumps
+ * the slot's generation, so a handle to an erased element resolves to
+ * nullptr rather than to whatever took its place.
+ *
+ * emplace/erase/get may be called from any thread. Iteration is not
+ * synchronized: only the thread that adds and erases elements may iterate.
+ */
+template<typename T, size_t CHUNK = 256>
+class Slab {
+private:
+    struct Slot {
+        alignas(T) unsigned char storage[sizeof(T)];
+        uint32_t generation = 0;
+        bool live = false;
+
+        T* object() { return std::launder(reinterpret_cast<T*>(storage)); }
+        const T* object() const { return std::launder(reinterpret_cast<const T*>(storage)); }
+    };
+
+    std::vector<std::unique_ptr<Slot[]>> chunks;
+    std::vector<uint32_t> freeSlots;
+    uint32_t slotCount = 0;     // slots ever handed out
+    size_t liveCount = 0;
+    mutable std::shared_mutex mutex;
+
+    Slot& slot(uint32_t index) { return chunks[index / CHUNK][index % CHUNK]; }
+    const Slot& slot(uint32_t index) const { return chunks[index / CHUNK][index % CHUNK]; }
+
+    template<typename SlabType, typename Value>
+    class Iter {
+    private:
+        SlabType* slab;
+        uint32_t index;
+
+        void skipDead() {
+            while (index < slab->slotCount && !slab->slot(index).live) index++;
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Value*;
+        using reference = Value&;
+
+        Iter(SlabType* owner, uint32_t start) : slab(owner), index(start) { skipDead(); }
+
+        Value& operator*() const { return *slab->slot(index).object(); }
+        Value* operator->() const { return slab->slot(index).object(); }
+        SlabHandle handle() const { return SlabHandle{index, slab->slot(index).generation}; }
+
+        Iter& operator++() {
+            index++;
+            skipDead();
+            return *this;
+        }
+        bool operator==(const Iter& other) const { return index == other.index; }
+        bool operator!=(const Iter& other) const { return index != other.index; }
+    };
+
+public:
+    using iterator = Iter<Slab, T>;
+    using const_iterator = Iter<const Slab, const T>;
+
+    Slab() = default;
+    Slab(const Slab&) = delete;
+    Slab& operator=(const Slab&) = delete;
+
+    ~Slab() {
+        for (uint32_t i = 0; i < slotCount; i++) {
+            if (slot(i).live) slot(i).object()->~T();
+        }
+    }
+
+    template<typename... Args>
+    SlabHandle emplace(Args&&... args) {
+        std::unique_lock<std::shared_mutex> write(mutex);
+        uint32_t index;
+        if (!freeSlots.empty()) {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            if (slotCount % CHUNK == 0) {
+                chunks.push_back(std::make_unique<Slot[]>(CHUNK));
+            }
+            index = slotCount++;
+        }
+
+        Slot& target = slot(index);
+        try {
+            new (target.storage) T(std::forward<Args>(args)...);
+        } catch (...) {
+            freeSlots.push_back(index);
+            throw;
+        }
+        target.live = true;
+        liveCount++;
+        return SlabHandle{index, target.generation};
+    }
+
+    // False if the handle was already stale
+    bool erase(SlabHandle handle) {
+        std::unique_lock<std::shared_mutex> write(mutex);
+        if (handle.index >= slotCount) return false;
+        Slot& target = slot(handle.index);
+        if (!target.live || target.generation != handle.generation) return false;
+        target.object()->~T();
+        target.live = false;
+        target.generation++;
+        freeSlots.push_back(handle.index);
+        liveCount--;
+        return true;
+    }
+
+    // The element, or nullptr if it has been erased since the handle was made
+    T* get(SlabHandle handle) {
+        std::shared_lock<std::shared_mutex> read(mutex);
+        if (handle.index >= slotCount) return nullptr;
+        Slot& target = slot(handle.index);
+        return target.live && target.generation == handle.generation ? target.object() : nullptr;
+    }
+    const T* get(SlabHandle handle) const {
+        return const_cast<Slab*>(this)->get(handle);
+    }
+
+    // Erases everything; outstanding handles all become stale
+    void clear() {
+        std::unique_lock<std::shared_mutex> write(mutex);
+        freeSlots.clear();
+        // Pushed high to low so refilling reuses slots in their original order
+        for (uint32_t i = slotCount; i-- > 0;) {
+            Slot& target = slot(i);
+            if (target.live) {
+                target.object()->~T();
+                target.live = false;
+                target.generation++;
+            }
+            freeSlots.push_back(i);
+        }
+        liveCount = 0;
+    }
+
+    size_t size() const {
+        std::shared_lock<std::shared_mutex> read(mutex);
+        return liveCount;
+    }
+    bool empty() const { return size() == 0; }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, slotCount); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, slotCount); }
+};
+
+#endif
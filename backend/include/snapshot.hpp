@@ -0,0 +1,235 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Binary image of the whole in-memory state (users, collections, NFTs,
+ * listings, transactions). It is written at exit and mapped read-only at
+ * startup, so a restart needs no parsing at all.
+ *
+ * Records are fixed-size and refer to each other by index, never by
+ * pointer. Every string is stored once in the string table and records
+ * hold its id. The header carries the size and mtime of each file the
+ * image was built from; if any of them changed since, the image is stale
+ * and the JSON/store loaders are used instead.
+ *
+ * File layout: SnapshotHeader, then each section at the offset the
+ * header gives (8-byte aligned). Integers are in the writer's byte order,
+ * which the header records.
+ */
+
+const char* const SNAPSHOT_PATH = "data/state.snap";
+
+struct SnapshotSource {
+    uint64_t size;
+    int64_t mtime;
+};
+
+// account store, marketplace journal, listings.json, transactions.json
+const size_t SNAPSHOT_SOURCE_COUNT = 4;
+
+struct SnapshotStamp {
+    SnapshotSource sources[SNAPSHOT_SOURCE_COUNT];
+
+    bool operator==(const SnapshotStamp& other) const {
+        for (size_t i = 0; i < SNAPSHOT_SOURCE_COUNT; i++) {
+            if (sources[i].size != other.sources[i].size || sources[i].mtime != other.sources[i].mtime) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// Stamp of the source files as they are on disk right now
+SnapshotStamp currentSnapshotStamp();
+
+struct SnapshotString {
+    uint64_t offset;     // into the string data section
+    uint32_t length;
+    uint32_t pad;
+};
+
+struct SnapshotNFT {
+    uint32_t tokenId;
+    uint32_t name;
+    uint32_t owner;
+    uint32_t mintAddress;
+    uint32_t metadataUri;
+    uint32_t collection;
+    uint32_t isListed;
+    uint32_t pad;
+    double price;
+};
+
+struct SnapshotCollection {
+    uint32_t name;
+    uint32_t creator;
+    uint32_t firstNFT;
+    uint32_t nftCount;
+};
+
+struct SnapshotTransaction {
+    uint32_t transactionId;
+    uint32_t tokenId;
+    uint32_t seller;
+    uint32_t buyer;
+    uint32_t timestamp;
+    uint32_t status;
+    double price;
+};
+
+struct SnapshotUser {
+    uint32_t name;
+    uint32_t email;
+    uint32_t walletAddress;
+    uint32_t balance;
+    uint32_t passwordHash;
+    uint32_t keypairPath;
+    uint32_t firstCollection;
+    uint32_t collectionCount;
+    uint32_t firstOwnedNFT;     // owned NFTs live in the NFT section too
+    uint32_t ownedNFTCount;
+    uint32_t firstHistory;      // string ids in the history section
+    uint32_t historyCount;
+};
+
+enum SnapshotSectionId : uint32_t {
+    SECTION_STRINGS,
+    SECTION_STRING_DATA,
+    SECTION_USERS,
+    SECTION_COLLECTIONS,
+    SECTION_NFTS,
+    SECTION_HISTORY,
+    SECTION_LISTINGS,
+    SECTION_TRANSACTIONS,
+    SECTION_COUNT
+};
+
+struct SnapshotSection {
+    uint64_t offset;
+    uint64_t count;
+};
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t fileSize;
+    uint32_t crc;        // crc32 of everything after the header
+    uint32_t pad;
+    SnapshotStamp stamp;
+    SnapshotSection sections[SECTION_COUNT];
+};
+
+// Bounds-checked view of one section of a mapped image
+template<typename T>
+class SnapshotRange {
+private:
+    const T* first;
+    size_t count;
+
+public:
+    SnapshotRange(const T* data = nullptr, size_t size = 0) : first(data), count(size) {}
+
+    size_t size() const { return count; }
+    const T* begin() const { return first; }
+    const T* end() const { return first + count; }
+
+    const T& operator[](size_t index) const {
+        if (index >= count) {
+            throw std::out_of_range("Snapshot record index out of range");
+        }
+        return first[index];
+    }
+
+    // count records starting at index
+    SnapshotRange slice(size_t index, size_t length) const {
+        if (index > count || length > count - index) {
+            throw std::out_of_range("Snapshot record range out of range");
+        }
+        return SnapshotRange(first + index, length);
+    }
+};
+
+// Collects records and interned strings, then writes them as one image
+class SnapshotBuilder {
+private:
+    std::unordered_map<std::string, uint32_t> stringIds;
+    std::vector<SnapshotString> strings;
+    std::string stringData;
+    std::vector<SnapshotUser> users;
+    std::vector<SnapshotCollection> collections;
+    std::vector<SnapshotNFT> nfts;
+    std::vector<uint32_t> history;
+    std::vector<SnapshotNFT> listings;
+    std::vector<SnapshotTransaction> transactions;
+
+public:
+    uint32_t intern(const std::string& value);
+
+    uint32_t nftCount() const { return static_cast<uint32_t>(nfts.size()); }
+    uint32_t collectionCount() const { return static_cast<uint32_t>(collections.size()); }
+    uint32_t historyCount() const { return static_cast<uint32_t>(history.size()); }
+
+    void addUser(const SnapshotUser& user) { users.push_back(user); }
+    void addCollection(const SnapshotCollection& collection) { collections.push_back(collection); }
+    void addNFT(const SnapshotNFT& nft) { nfts.push_back(nft); }
+    void addHistory(uint32_t stringId) { history.push_back(stringId); }
+    void addListing(const SnapshotNFT& nft) { listings.push_back(nft); }
+    void addTransaction(const SnapshotTransaction& tx) { transactions.push_back(tx); }
+
+    // Writes the image atomically; throws on failure
+    void write(const std::string& path, const SnapshotStamp& stamp) const;
+};
+
+// A read-only mapping of an image written by SnapshotBuilder
+class SnapshotImage {
+private:
+    void* base = nullptr;
+    size_t length = 0;
+
+    const SnapshotHeader& header() const { return *static_cast<const SnapshotHeader*>(base); }
+
+    template<typename T>
+    SnapshotRange<T> section(SnapshotSectionId id) const {
+        const SnapshotSection& s = header().sections[id];
+        return SnapshotRange<T>(reinterpret_cast<const T*>(static_cast<const char*>(base) + s.offset),
+                                static_cast<size_t>(s.count));
+    }
+
+    bool validate() const;
+    void close();
+
+public:
+    SnapshotImage() = default;
+    ~SnapshotImage() { close(); }
+
+    SnapshotImage(const SnapshotImage&) = delete;
+    SnapshotImage& operator=(const SnapshotImage&) = delete;
+
+    // Maps path. Returns false if it is missing, damaged, or was built
+    // from source files that no longer match expected.
+    bool open(const std::string& path, const SnapshotStamp& expected);
+    bool isOpen() const { return base != nullptr; }
+    size_t bytes() const { return length; }
+
+    std::string_view string(uint32_t id) const;
+    std::string text(uint32_t id) const { return std::string(string(id)); }
+
+    SnapshotRange<SnapshotUser> users() const { return section<SnapshotUser>(SECTION_USERS); }
+    SnapshotRange<SnapshotCollection> collections() const { return section<SnapshotCollection>(SECTION_COLLECTIONS); }
+    SnapshotRange<SnapshotNFT> nfts() const { return section<SnapshotNFT>(SECTION_NFTS); }
+    SnapshotRange<uint32_t> history() const { return section<uint32_t>(SECTION_HISTORY); }
+    SnapshotRange<SnapshotNFT> listings() const { return section<SnapshotNFT>(SECTION_LISTINGS); }
+    SnapshotRange<SnapshotTransaction> transactions() const { return section<SnapshotTransaction>(SECTION_TRANSACTIONS); }
+};
+
+#endif
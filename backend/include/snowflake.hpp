@@ -0,0 +1,66 @@
+#ifndef SNOWFLAKE_HPP
+#define SNOWFLAKE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/*
+ * 62-bit ids: 40 bits of milliseconds since 2024-01-01 UTC, 10 bits of node
+ * id and a 12-bit sequence within the millisecond. Ids from one node are
+ * strictly increasing; ids from nodes with different node ids never
+ * collide; and they sort by creation time.
+ *
+ * The (millisecond, sequence) pair lives in one atomic word advanced with
+ * compare-and-swap, so next() never blocks. When the 4096 ids of a
+ * millisecond run out, or the clock steps backwards, the generator moves
+ * on to the next millisecond rather than waiting. observe() moves it past
+ * ids loaded from disk, which keeps ids unique across restarts even if the
+ * clock was set back in between.
+ */
+class SnowflakeGenerator {
+public:
+    static constexpr int TIME_BITS = 40;
+    static constexpr int NODE_BITS = 10;
+    static constexpr int SEQUENCE_BITS = 12;
+    static constexpr uint64_t EPOCH_MS = 1704067200000ULL;     // 2024-01-01T00:00:00Z
+    static constexpr uint32_t MAX_NODE = (1U << NODE_BITS) - 1;
+    static constexpr size_t HEX_DIGITS = 16;
+
+private:
+    static constexpr uint64_t SEQUENCE_MASK = (1ULL << SEQUENCE_BITS) - 1;
+    static constexpr uint64_t MAX_OBSERVED_LEAD_MS = 24ULL * 60 * 60 * 1000;
+
+    uint32_t nodeId;
+    std::atomic<uint64_t> state{0};     // (ms since EPOCH_MS << SEQUENCE_BITS) | last sequence used
+
+    static uint64_t nowMs();
+
+public:
+    // Throws std::invalid_argument if nodeId > MAX_NODE
+    explicit SnowflakeGenerator(uint32_t nodeId);
+
+    SnowflakeGenerator(const SnowflakeGenerator&) = delete;
+    SnowflakeGenerator& operator=(const SnowflakeGenerator&) = delete;
+
+    uint64_t next();
+    // Makes every later id from this generator sort after id (ignored if id is
+    // more than a day ahead of the clock)
+    void observe(uint64_t id);
+    uint32_t node() const { return nodeId; }
+
+    // Unix time in milliseconds at which id was generated
+    static uint64_t timestampMs(uint64_t id) { return (id >> (NODE_BITS + SEQUENCE_BITS)) + EPOCH_MS; }
+
+    // prefix followed by the id as 16 upper-case hex digits
+    static std::string format(std::string_view prefix, uint64_t id);
+    // Inverse of format; false unless text is exactly that shape
+    static bool parse(std::string_view text, std::string_view prefix, uint64_t& id);
+};
+
+// Process-wide generator; node id from $NODE_ID (0-1023, default 0).
+// Each process sharing data files must run with its own node id.
+SnowflakeGenerator& idGenerator();
+
+#endif
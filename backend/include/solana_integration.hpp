@@ -12,7 +12,10 @@
 #include <iostream>
 #include <memory>
 #include <fstream>
+#include <unordered_map>
 #include "solana_config.hpp"
+#include "solana_rpc.hpp"
+#include "balance_cache.hpp"
 
 class SolanaIntegration {
 public:
@@ -44,39 +47,9 @@ public:
         return result;
     }
     
-    static std::string mintNFT(const std::string& metadata) {
-        // Create keypair for the NFT
-        std::string cmd = "solana-keygen new --no-bip39-passphrase -o nft-keypair.json";
-        if (system(cmd.c_str()) != 0) return "";
-        
-        // Get mint address
-        FILE* pipe = popen("solana address -k nft-keypair.json", "r");
-        char buffer[128];
-        std::string mintAddress;
-        if (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-            mintAddress = buffer;
-            if (!mintAddress.empty() && mintAddress[mintAddress.length()-1] == '\n') {
-                mintAddress.erase(mintAddress.length()-1);
-            }
-        }
-        pclose(pipe);
-        
-        // Create metadata JSON file if metadata is provided
-        if (!metadata.empty()) {
-            std::string metadataFile = "nft-metadata.json";
-            std::ofstream file(metadataFile);
-            if (file.is_open()) {
-                file << metadata;
-                file.close();
-                
-                // TODO: Upload metadata to IPFS or similar service
-                // TODO: Use the metadata URI in the actual minting command
-                std::cout << "Metadata saved to " << metadataFile << std::endl;
-            }
-        }
-        
-        return mintAddress;
-    }
+    // Creates the mint keypair and metadata file in jobDir (one directory per
+    // mint, see MintQueue) and returns the mint address. Throws on failure.
+    static std::string mintNFT(const std::string& metadata, const std::string& jobDir);
     
     static bool transferNFT(const std::string& to, const std::string& mint) {
         std::string cmd = "spl-token transfer " + mint + " 1 " + to + " --url devnet";
@@ -87,20 +60,32 @@ public:
         return system(("solana confirm " + signature).c_str()) == 0;
     }
 
+    // Balance in SOL, or false (with the reason printed) if the RPC node can't be reached.
+    // Served from balanceCache(), so repeated lookups within the TTL cost nothing.
+    static bool tryGetBalance(const std::string& address, double& balance) {
+        try {
+            balance = static_cast<double>(balanceCache().get(address)) / LAMPORTS_PER_SOL;
+            return true;
+        } catch (const std::exception& e) {
+            std::cerr << "Balance lookup for " << address << " failed: " << e.what() << std::endl;
+            return false;
+        }
+    }
+
     static double getBalance(const std::string& address) {
-        std::string cmd = "solana balance " + address;
-        FILE* pipe = popen(cmd.c_str(), "r");
-        if (!pipe) return 0.0;
-        
-        char buffer[128];
         double balance = 0.0;
-        if (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-            balance = std::stod(buffer);
-        }
-        pclose(pipe);
+        tryGetBalance(address, balance);
         return balance;
     }
 
+    // getMultipleAccounts accepts at most this many addresses per call
+    static constexpr size_t MAX_ACCOUNTS_PER_REQUEST = 100;
+
+    // Balances in SOL for many wallets at once: chunked getMultipleAccounts
+    // calls issued concurrently. Wallets that don't exist on chain read 0;
+    // addresses in a chunk that failed are left out of the result.
+    static std::unordered_map<std::string, double> getBalances(const V<std::string>& addresses);
+
     static void airdropDevnet(const std::string& address) {
         // Use devnet as primary (current configuration)
         std::string cmd = "solana airdrop 1 " + address + " --url https://api.devnet.solana.com 2>&1";
@@ -112,6 +97,7 @@ public:
                 result += buffer;
             }
             pclose(pipe);
+            balanceCache().invalidate(address);
             
             if (result.find("Signature: ") != std::string::npos) {
                 std::cout << "Airdrop successful on devnet!" << std::endl;
@@ -127,6 +113,7 @@ public:
                         result += buffer;
                     }
                     pclose(pipe);
+                    balanceCache().invalidate(address);
                     
                     if (result.find("Signature: ") != std::string::npos) {
                         std::cout << "Airdrop successful on testnet!" << std::endl;
@@ -0,0 +1,39 @@
+#ifndef SOLANA_KEYPAIR_HPP
+#define SOLANA_KEYPAIR_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+/*
+ * ed25519 keypair in the layout solana-keygen uses: id.json holds a JSON
+ * array of 64 byte values, the 32-byte secret seed followed by the 32-byte
+ * public key. The wallet address is the base58 public key.
+ */
+class SolanaKeypair {
+private:
+    std::array<uint8_t, 32> seed{};
+    std::array<uint8_t, 32> publicKey{};
+
+    SolanaKeypair() = default;
+
+public:
+    SolanaKeypair(const SolanaKeypair&) = default;
+    SolanaKeypair& operator=(const SolanaKeypair&) = default;
+    ~SolanaKeypair();   // wipes the secret seed
+
+    // Fresh keypair from the system CSPRNG. Throws std::runtime_error.
+    static SolanaKeypair generate();
+    // Reads an id.json written by solana-keygen or save(). Throws std::runtime_error.
+    static SolanaKeypair load(const std::string& path);
+
+    std::string address() const;
+    std::string toJson() const;
+    // Writes id.json readable by the owner only; refuses to replace an
+    // existing file unless overwrite is set
+    void save(const std::string& path, bool overwrite = false) const;
+
+    const std::array<uint8_t, 32>& publicKeyBytes() const { return publicKey; }
+};
+
+#endif
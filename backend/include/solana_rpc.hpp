@@ -0,0 +1,117 @@
+#ifndef SOLANA_RPC_HPP
+#define SOLANA_RPC_HPP
+
+#include "V.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+typedef struct ssl_ctx_st SSL_CTX;
+class HttpConnection;
+class JsonWriter;
+
+// Error from the RPC node (JSON-RPC error code), an HTTP error status, or
+// a transport failure (code 0)
+class SolanaRpcError : public std::runtime_error {
+private:
+    int errorCode;
+
+public:
+    SolanaRpcError(int code, const std::string& message) : std::runtime_error(message), errorCode(code) {}
+    int code() const { return errorCode; }
+};
+
+struct RpcAccountInfo {
+    uint64_t lamports = 0;
+    std::string owner;
+    bool executable = false;
+    uint64_t space = 0;
+};
+
+struct RpcSignatureStatus {
+    uint64_t slot = 0;
+    std::optional<uint64_t> confirmations;   // empty once the block is finalized
+    std::string confirmationStatus;          // processed, confirmed or finalized
+    bool failed = false;                     // the transaction itself errored
+};
+
+/*
+ * Persistent HTTP/1.1 connections to one endpoint (http:// or https://).
+ * Connections go back to the pool after each response unless the server
+ * asked to close, so steady-state requests skip TCP and TLS handshakes.
+ * A pooled connection the server already dropped is retried once on a
+ * fresh one.
+ */
+class HttpConnectionPool {
+public:
+    struct Stats {
+        uint64_t requests;
+        uint64_t connectionsOpened;
+        uint64_t connectionsReused;
+    };
+
+private:
+    bool tls = false;
+    std::string host;
+    std::string port;
+    std::string path;
+    SSL_CTX* sslContext = nullptr;
+    size_t maxIdle;
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<HttpConnection>> idle;
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> opened{0};
+    std::atomic<uint64_t> reused{0};
+
+    std::unique_ptr<HttpConnection> acquire(bool& wasReused);
+    void release(std::unique_ptr<HttpConnection> connection);
+
+public:
+    explicit HttpConnectionPool(const std::string& url, size_t maxIdleConnections = 8);
+    ~HttpConnectionPool();
+
+    HttpConnectionPool(const HttpConnectionPool&) = delete;
+    HttpConnectionPool& operator=(const HttpConnectionPool&) = delete;
+
+    // POSTs a JSON body and returns the response body. Throws SolanaRpcError.
+    std::string post(const std::string& body);
+    Stats stats() const;
+};
+
+// In-process Solana JSON-RPC client; safe to share between threads
+class SolanaRpcClient {
+private:
+    std::string endpoint;
+    HttpConnectionPool pool;
+    std::atomic<uint64_t> nextId{1};
+
+    std::string call(const char* method, const std::function<void(JsonWriter&)>& params);
+
+public:
+    explicit SolanaRpcClient(const std::string& url);
+
+    const std::string& url() const { return endpoint; }
+    HttpConnectionPool::Stats stats() const { return pool.stats(); }
+
+    uint64_t getBalance(const std::string& address);
+    // One entry per address, empty where the account does not exist
+    V<std::optional<RpcAccountInfo>> getMultipleAccounts(const V<std::string>& addresses);
+    // Returns the airdrop transaction signature
+    std::string requestAirdrop(const std::string& address, uint64_t lamports);
+    // Submits a signed, base64-encoded transaction; returns its signature
+    std::string sendTransaction(const std::string& base64Transaction);
+    // One entry per signature, empty where the node has no record of it
+    V<std::optional<RpcSignatureStatus>> getSignatureStatuses(const V<std::string>& signatures);
+};
+
+// Process-wide client for $SOLANA_RPC_URL, or SolanaConfig::NETWORK_URL when unset
+SolanaRpcClient& solanaRpc();
+
+#endif
@@ -30,28 +30,8 @@ public:
     double getBalance() const;
     bool requestAirdrop();
     void setBalance(double newBalance) {balance = newBalance; }
-	bool updateBalance() {
-    try {
-        std::string cmd = "solana balance";
-        FILE* pipe = popen(cmd.c_str(), "r");
-        if (!pipe) return false;
-        
-        char buffer[128];
-        if (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-            std::string balance_str(buffer);
-            if (!balance_str.empty() && balance_str[balance_str.length()-1] == '\n') {
-                balance_str.erase(balance_str.length()-1);
-            }
-            balance = std::stod(balance_str);
-            pclose(pipe);
-            return true;
-        }
-        pclose(pipe);
-        return false;
-    } catch (...) {
-        return false;
-    }
-}
+	// Refreshes balance for publicKey from the RPC node
+	bool updateBalance();
 
 };
 
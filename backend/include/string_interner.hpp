@@ -0,0 +1,37 @@
+#ifndef STRING_INTERNER_HPP
+#define STRING_INTERNER_HPP
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/*
+ * Append-only table giving each distinct string a small number. Entries are
+ * never removed, so only values that are rare by construction (legacy
+ * placeholders, hand-entered ids) should be interned.
+ */
+class StringInterner {
+private:
+    mutable std::shared_mutex mutex;
+    std::deque<std::string> strings;    // deque: references survive growth
+    std::unordered_map<std::string_view, uint32_t> ids;
+
+public:
+    StringInterner() = default;
+    StringInterner(const StringInterner&) = delete;
+    StringInterner& operator=(const StringInterner&) = delete;
+
+    uint32_t intern(std::string_view text);
+    // The existing number for text, without adding it
+    std::optional<uint32_t> find(std::string_view text) const;
+    const std::string& text(uint32_t id) const;
+};
+
+// Shared by Pubkey and TokenId for values that don't have the compact form
+StringInterner& identifierInterner();
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads pulling tasks from a shared queue
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable available;
+    bool stopping = false;
+
+    void workerLoop() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                available.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (stopping && tasks.empty()) return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+public:
+    static size_t defaultThreadCount() {
+        unsigned int cores = std::thread::hardware_concurrency();
+        return cores == 0 ? 4 : cores;
+    }
+
+    explicit ThreadPool(size_t threadCount = defaultThreadCount()) {
+        if (threadCount == 0) threadCount = 1;
+        workers.reserve(threadCount);
+        for (size_t i = 0; i < threadCount; i++) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        available.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size(); }
+
+    template<typename F>
+    auto submit(F&& fn) -> std::future<decltype(fn())> {
+        using Result = decltype(fn());
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(fn));
+        std::future<Result> result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.emplace_back([task] { (*task)(); });
+        }
+        available.notify_one();
+        return result;
+    }
+
+    // Runs fn(i) for every i in [0, count) across the pool and waits for all of them.
+    // The first exception thrown by fn is rethrown here.
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn) {
+        if (count == 0) return;
+        auto next = std::make_shared<std::atomic<size_t>>(0);
+        size_t runners = std::min(count, workers.size());
+        std::vector<std::future<void>> done;
+        done.reserve(runners);
+        for (size_t r = 0; r < runners; r++) {
+            done.push_back(submit([next, count, &fn] {
+                for (size_t i = (*next)++; i < count; i = (*next)++) {
+                    fn(i);
+                }
+            }));
+        }
+        for (auto& d : done) {
+            d.get();
+        }
+    }
+};
+
+#endif
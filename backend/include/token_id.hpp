@@ -0,0 +1,63 @@
+#ifndef TOKEN_ID_HPP
+#define TOKEN_ID_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+/*
+ * NFT token id in 64 bits. New ids are snowflakes, "NFT-" + 16 upper-case
+ * hex digits; ids from before that, "NFT-" + 6 hex digits, keep their
+ * number too. Any other id is interned and keeps its table index. A 2-bit
+ * tag keeps the three kinds apart, and toString() reproduces the original
+ * text either way.
+ */
+class TokenId {
+private:
+    static constexpr int TAG_SHIFT = 62;
+    static constexpr uint64_t LEGACY = 1;       // "NFT-" + 6 hex digits
+    static constexpr uint64_t INTERNED = 2;
+    static constexpr uint64_t SNOWFLAKE = 3;    // sorts after the others, then by creation time
+    static constexpr uint64_t PAYLOAD = (1ULL << TAG_SHIFT) - 1;
+
+    uint64_t value = 0;     // 0 is the empty id
+
+    explicit TokenId(uint64_t tag, uint64_t payload) : value((tag << TAG_SHIFT) | payload) {}
+    static bool parseLegacy(std::string_view text, uint64_t& number);
+    static bool parseCompact(std::string_view text, TokenId& id);
+
+public:
+    TokenId() = default;
+
+    // Any text; the compact forms are decoded, anything else is interned
+    static TokenId parse(std::string_view text);
+    // Like parse, but never interns: unknown text gives an empty id. For lookups with untrusted input.
+    static TokenId lookup(std::string_view text);
+    // A fresh id from idGenerator()
+    static TokenId generate();
+
+    std::string toString() const;
+    bool empty() const { return value == 0; }
+    uint64_t raw() const { return value; }
+    // Inverse of raw(), for ids kept as plain integers
+    static TokenId fromRaw(uint64_t raw) { TokenId id; id.value = raw; return id; }
+
+    bool operator==(const TokenId& other) const { return value == other.value; }
+    bool operator!=(const TokenId& other) const { return value != other.value; }
+    bool operator<(const TokenId& other) const { return value < other.value; }
+};
+
+inline std::ostream& operator<<(std::ostream& out, const TokenId& id) {
+    return out << id.toString();
+}
+
+namespace std {
+    template<> struct hash<TokenId> {
+        size_t operator()(const TokenId& id) const { return std::hash<uint64_t>{}(id.raw()); }
+    };
+}
+
+#endif
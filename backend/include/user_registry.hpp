@@ -0,0 +1,65 @@
+#ifndef USER_REGISTRY_HPP
+#define USER_REGISTRY_HPP
+
+#include "slab.hpp"
+#include <array>
+#include <cstddef>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+class UserAccount;
+
+// Every loaded account lives here, at a fixed address, for the life of the process
+using UserTable = Slab<UserAccount>;
+using UserHandle = SlabHandle;
+
+/*
+ * Hash indexes from wallet address and from normalized email to handles
+ * into the user table, so lookups don't scan it. Each index is split into
+ * shards with their own shared_mutex: lookups from the API threads only
+ * contend with a writer touching the same shard. Handles are generation
+ * checked, so an erased account is reported as missing, never as whatever
+ * reused its slot.
+ */
+class UserRegistry {
+private:
+    static constexpr size_t SHARDS = 16;
+
+    struct Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, UserHandle> users;
+    };
+
+    UserTable& table;
+    std::array<Shard, SHARDS> byWallet;
+    std::array<Shard, SHARDS> byEmail;
+
+    static Shard& shardFor(std::array<Shard, SHARDS>& index, const std::string& key);
+    static const Shard& shardFor(const std::array<Shard, SHARDS>& index, const std::string& key);
+    UserAccount* find(const std::array<Shard, SHARDS>& index, const std::string& key) const;
+    void clear();
+
+public:
+    explicit UserRegistry(UserTable& users) : table(users) {}
+    UserRegistry(const UserRegistry&) = delete;
+    UserRegistry& operator=(const UserRegistry&) = delete;
+
+    // Lower-cased with surrounding whitespace removed
+    static std::string normalizeEmail(const std::string& email);
+
+    // False (and nothing indexed) if the email is already registered
+    bool add(UserHandle handle);
+    // Re-indexes the whole table; the first account wins when two share an email
+    void rebuild();
+
+    UserAccount* findByWallet(const std::string& walletAddress) const;
+    UserAccount* findByEmail(const std::string& email) const;
+    size_t size() const;
+};
+
+// Process-wide user table and the registry over it
+UserTable& userTable();
+UserRegistry& userRegistry();
+
+#endif
@@ -1,11 +1,14 @@
 #include "../include/header.hpp"
+#include "../include/json_reader.hpp"
+#include "../include/json_writer.hpp"
+#include "../include/thread_pool.hpp"
+#include <atomic>
 #include <fstream>
 #include <string>
 #include <sstream>
 #include <iomanip>
 
 UserAccount* UserAccount::currentUser = nullptr;
-V<UserAccount*> UserAccount::allUsers;
 std::string UserAccount::SOLANA_PATH = "";
 
 UserAccount::UserAccount(std::string walletAddress, std::string name, std::string email,
@@ -22,134 +25,320 @@ UserAccount::~UserAccount() {
 
 }
 
-/*
- * hashPassword(); veryfyPassword() was made using Argon2.
- */
-std::string UserAccount::hashPassword(const std::string& password) {
-    const uint32_t t_cost = 2;            // 2 iterations
-    const uint32_t m_cost = 1 << 16;      // 64 MiB memory cost
-    const uint32_t parallelism = 1;       // 1 thread
-    const uint32_t hash_length = 32;      // 32-byte hash
-    const uint32_t salt_length = 16;      // 16-byte salt
-
-    // Generate random salt
-    std::vector<uint8_t> salt(salt_length);
-    std::random_device rd;
-    std::generate(salt.begin(), salt.end(), std::ref(rd));
-
-    // Allocate memory for the hash
-    std::vector<uint8_t> hash(hash_length);
-
-    // Perform the hash
-    int result = argon2id_hash_raw(
-        t_cost,
-        m_cost,
-        parallelism,
-        password.c_str(),
-        password.length(),
-        salt.data(),
-        salt_length,
-        hash.data(),
-        hash_length
-    );
-
-    if (result != ARGON2_OK) {
-        throw std::runtime_error("Error hashing password: " + std::string(argon2_error_message(result)));
+AccountGuard::AccountGuard(const UserAccount& account) : first(account.accountMutex.get()) {}
+
+AccountGuard::AccountGuard(const UserAccount& account, const UserAccount* other) {
+    const UserAccount* low = &account;
+    const UserAccount* high = other;
+    if (high && std::less<const UserAccount*>()(high, low)) {
+        std::swap(low, high);
+    }
+    first = std::unique_lock<std::mutex>(low->accountMutex.get());
+    if (high && high != low) {
+        second = std::unique_lock<std::mutex>(high->accountMutex.get());
+    }
+}
+
+void UserAccount::indexOwnedNFTs() {
+    ownedIndex.clear();
+    ownedIndex.reserve(ownedNFTs.size());
+    size_t kept = 0;
+    for (size_t i = 0; i < ownedNFTs.size(); i++) {
+        if (ownedIndex.insert(ownedNFTs[i].id(), kept)) {
+            if (kept != i) ownedNFTs[kept] = std::move(ownedNFTs[i]);
+            kept++;
+        }
+    }
+    while (ownedNFTs.size() > kept) {
+        ownedNFTs.pop_back();
+    }
+}
+
+NFT* UserAccount::findOwnedNFT(TokenId tokenId) {
+    size_t slot = ownedIndex.find(tokenId);
+    return slot == FlatHashIndex<TokenId>::npos ? nullptr : &ownedNFTs[slot];
+}
+
+bool UserAccount::holdsNFT(TokenId tokenId) const {
+    if (ownedIndex.contains(tokenId)) return true;
+    for (const auto& collection : collections) {
+        if (collection.contains(tokenId)) return true;
     }
+    return false;
+}
 
-    // Combine salt and hash into a single vector
-    std::vector<uint8_t> combined(salt_length + hash_length);
-    std::copy(salt.begin(), salt.end(), combined.begin());
-    std::copy(hash.begin(), hash.end(), combined.begin() + salt_length);
+void UserAccount::addOwnedNFT(const NFT& nft) {
+    size_t slot = ownedIndex.find(nft.id());
+    if (slot == FlatHashIndex<TokenId>::npos) {
+        ownedIndex.insert(nft.id(), ownedNFTs.size());
+        ownedNFTs.push_back(nft);
+    } else {
+        ownedNFTs[slot] = nft;
+    }
+}
+
+// Swap-and-pop in ownedNFTs and in each collection: a few index updates, no copying of the rest
+bool UserAccount::releaseNFT(TokenId tokenId) {
+    bool released = false;
+    size_t slot = ownedIndex.find(tokenId);
+    if (slot != FlatHashIndex<TokenId>::npos) {
+        ownedIndex.erase(tokenId);
+        size_t last = ownedNFTs.size() - 1;
+        if (slot != last) {
+            ownedNFTs[slot] = std::move(ownedNFTs[last]);
+            ownedIndex.insert(ownedNFTs[slot].id(), slot);
+        }
+        ownedNFTs.pop_back();
+        released = true;
+    }
+    for (auto& collection : collections) {
+        released = collection.removeNFT(tokenId) || released;
+    }
+    return released;
+}
 
-    // Convert to hex string for storage
-    std::stringstream ss;
-    ss << std::hex << std::setfill('0');
-    for (uint8_t byte : combined) {
-        ss << std::setw(2) << static_cast<int>(byte);
+void UserAccount::receiveNFT(const NFT& nft) {
+    addOwnedNFT(nft);
+    if (collections.empty()) {
+        collections.push_back(Collection("My NFTs", name));
     }
-    return ss.str();
+    collections[0].addNFT(nft);
 }
 
-bool UserAccount::verifyPassword(const std::string& password, const std::string& stored_hex) {
-    const uint32_t t_cost = 2;
-    const uint32_t m_cost = 1 << 16;
-    const uint32_t parallelism = 1;
-    const uint32_t hash_length = 32;
-    const uint32_t salt_length = 16;
+namespace {
+    // Files each keypairs/<name>_<email>/ directory used to hold, now records in the account store
+    const char* USER_RECORD_FILES[] = {"address.txt", "balance.txt", "info.json", "collections.json", "transactions.txt"};
 
-    // Convert hex string back to binary
-    std::vector<uint8_t> stored;
-    try {
-        for (size_t i = 0; i < stored_hex.length(); i += 2) {
-            if (i + 1 >= stored_hex.length()) {
-                throw std::runtime_error("Invalid hex string length");
+    // Local balances carry off-chain marketplace trades, so the chain only wins
+    // when it is ahead by more than this (an airdrop the app didn't see)
+    constexpr double CHAIN_SYNC_THRESHOLD = 0.1;
+
+    // One-time import of the old per-user directories. Directories are read
+    // in parallel; everything lands in the store as a single batch.
+    size_t importKeypairDirectories(KeyValueStore& store, ThreadPool& pool) {
+        std::error_code ec;
+        if (!std::filesystem::is_directory("keypairs", ec)) {
+            return 0;
+        }
+
+        std::vector<std::string> dirs;
+        for (const auto& entry : std::filesystem::directory_iterator("keypairs", ec)) {
+            if (entry.is_directory(ec)) {
+                dirs.push_back("keypairs/" + entry.path().filename().string());
+            }
+        }
+
+        std::vector<WriteBatch> perDir(dirs.size());
+        pool.parallelFor(dirs.size(), [&](size_t i) {
+            for (const char* file : USER_RECORD_FILES) {
+                std::ifstream in(dirs[i] + "/" + file, std::ios::binary);
+                if (!in.is_open()) continue;
+                std::ostringstream contents;
+                contents << in.rdbuf();
+                perDir[i].put(dirs[i] + "/" + file, contents.str());
             }
-            std::string byte_string = stored_hex.substr(i, 2);
-            // Check if the string contains valid hex characters
-            if (byte_string.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos) {
-                throw std::runtime_error("Invalid hex characters in password hash");
+        });
+
+        WriteBatch batch;
+        size_t imported = 0;
+        for (const auto& dirBatch : perDir) {
+            if (dirBatch.empty()) continue;
+            for (const auto& op : dirBatch.operations()) {
+                batch.put(op.key, op.value);
             }
-            uint8_t byte = static_cast<uint8_t>(std::stoi(byte_string, nullptr, 16));
-            stored.push_back(byte);
+            imported++;
         }
-    } catch (const std::exception& e) {
-        // If hex conversion fails, the password hash is corrupted
-        std::cout << "WARNING: Corrupted password hash detected. Please reset password." << std::endl;
-        return false;
+        store.commit(batch);
+        return imported;
     }
 
-    // Extract salt from stored binary data
-    std::vector<uint8_t> salt(salt_length);
-    std::copy_n(stored.begin(), salt_length, salt.begin());
-
-    // Compute hash with same parameters
-    std::vector<uint8_t> computed_hash(hash_length);
-    int result = argon2id_hash_raw(
-        t_cost,
-        m_cost,
-        parallelism,
-        password.c_str(),
-        password.length(),
-        salt.data(),
-        salt_length,
-        computed_hash.data(),
-        hash_length
-    );
-
-    if (result != ARGON2_OK) {
-        throw std::runtime_error("Error verifying password: " + std::string(argon2_error_message(result)));
+    // Pulls the fields out of an info.json record
+    void parseUserInfo(const std::string& text, std::string& name, std::string& email,
+                       std::string& walletAddress, std::string& balance, std::string& passwordHash) {
+        JsonFields fields;
+        fields.bind("name", name);
+        fields.bind("email", email);
+        fields.bind("walletAddress", walletAddress);
+        fields.bind("balance", balance);
+        fields.bind("passwordHash", passwordHash);
+        JsonRecordHandler info(fields, 1, []() {});
+        JsonReader(text).parse(info);
+    }
+
+    // collections.json: {"collections": [{name, creator}, ...]}. Older stores have
+    // each collection's NFTs inline as "nfts": [{...}, ...]; those are read too.
+    class CollectionsHandler : public JsonDepthHandler {
+    private:
+        static constexpr int COLLECTION_DEPTH = 3;
+        static constexpr int NFT_DEPTH = 5;
+
+        V<Collection>& collections;
+        V<NFT>& ownedNFTs;
+        JsonFields collectionFields;
+        JsonFields nftFields;
+        std::string collectionName, collectionCreator;
+        std::string nftName, nftTokenId, nftOwner, nftMintAddress, nftMetadataUri;
+        double nftPrice = 0.0;
+        bool nftIsListed = false;
+        V<NFT> currentNFTs;
+        bool inlineNFTs = false;
+
+        JsonFields* fieldsHere() {
+            if (depth == COLLECTION_DEPTH) return &collectionFields;
+            if (depth == NFT_DEPTH) return &nftFields;
+            return nullptr;
+        }
+
+    protected:
+        void objectStart(int d) override {
+            if (d == COLLECTION_DEPTH) {
+                collectionFields.reset();
+                currentNFTs.clear();
+            } else if (d == NFT_DEPTH) {
+                nftFields.reset();
+            }
+        }
+
+        void objectEnd(int d) override {
+            if (d == NFT_DEPTH) {
+                // Complete NFT - use constructor with explicit tokenId
+                NFT nft(nftTokenId, nftName, nftOwner, nftPrice, nftIsListed, nftMetadataUri);
+                nft.setMintAddress(nftMintAddress);
+                currentNFTs.push_back(std::move(nft));
+                inlineNFTs = true;
+            } else if (d == COLLECTION_DEPTH) {
+                Collection collection(collectionName, collectionCreator);
+                for (const auto& nft : currentNFTs) {
+                    collection.addNFT(nft);
+                    // Only add to ownedNFTs list if NFT has valid data
+                    if (!nft.getTokenId().empty() && !nft.getName().empty()) {
+                        ownedNFTs.push_back(nft);
+                    }
+                }
+                collections.push_back(std::move(collection));
+            }
+        }
+
+    public:
+        CollectionsHandler(V<Collection>& userCollections, V<NFT>& userNFTs)
+            : collections(userCollections), ownedNFTs(userNFTs) {
+            collectionFields.bind("name", collectionName);
+            collectionFields.bind("creator", collectionCreator);
+            nftFields.bind("name", nftName);
+            nftFields.bind("tokenId", nftTokenId);
+            nftFields.bind("owner", nftOwner);
+            nftFields.bind("price", nftPrice);
+            nftFields.bind("isListed", nftIsListed);
+            nftFields.bind("mintAddress", nftMintAddress);
+            nftFields.bind("metadataUri", nftMetadataUri);
+        }
+
+        bool hadInlineNFTs() const { return inlineNFTs; }
+
+        void key(std::string_view name) override {
+            if (JsonFields* fields = fieldsHere()) fields->key(name);
+        }
+        void string(std::string_view value) override {
+            if (JsonFields* fields = fieldsHere()) fields->string(value);
+        }
+        void number(double value) override {
+            if (JsonFields* fields = fieldsHere()) fields->number(value);
+        }
+        void boolean(bool value) override {
+            if (JsonFields* fields = fieldsHere()) fields->boolean(value);
+        }
+    };
+
+    // nfts/<tokenId>: the NFT and the collection its account keeps it in
+    std::string nftRecord(const NFT& nft, const std::string& collection) {
+        thread_local JsonWriter json(true);
+        json.clear();
+        json.beginObject()
+            .field("collection", collection)
+            .field("name", nft.getName())
+            .field("tokenId", nft.getTokenId())
+            .field("owner", nft.getOwner())
+            .field("price", nft.getPrice())
+            .field("isListed", nft.getIsListed())
+            .field("mintAddress", nft.getMintAddress())
+            .field("metadataUri", nft.getMetadataUri())
+            .endObject();
+        return json.str();
     }
 
-    // Compare computed hash with stored hash
-    return std::equal(
-        computed_hash.begin(),
-        computed_hash.end(),
-        stored.begin() + salt_length
-    );
+    NFT parseNFTRecord(const std::string& text, std::string& collection) {
+        std::string name, tokenId, owner, mintAddress, metadataUri;
+        double price = 0.0;
+        bool isListed = false;
+        JsonFields fields;
+        fields.bind("collection", collection);
+        fields.bind("name", name);
+        fields.bind("tokenId", tokenId);
+        fields.bind("owner", owner);
+        fields.bind("price", price);
+        fields.bind("isListed", isListed);
+        fields.bind("mintAddress", mintAddress);
+        fields.bind("metadataUri", metadataUri);
+        JsonRecordHandler record(fields, 1, []() {});
+        JsonReader(text).parse(record);
+
+        NFT nft(tokenId, name, owner, price, isListed, metadataUri);
+        nft.setMintAddress(mintAddress);
+        return nft;
+    }
 }
 
+std::string UserAccount::getKeypairDir() const {
+    std::string safe_email = email;
+    std::replace(safe_email.begin(), safe_email.end(), '@', '_');
+    std::replace(safe_email.begin(), safe_email.end(), '.', '_');
+    return "keypairs/" + name + "_" + safe_email;
+}
 
+std::string UserAccount::infoJson() const {
+    thread_local JsonWriter json(true);
+    json.clear();
+    json.beginObject()
+        .field("name", name)
+        .field("email", email)
+        .field("walletAddress", walletAddress)
+        .field("balance", walletBalance)
+        .field("passwordHash", passwordHash)
+        .endObject();
+    return json.str();
+}
 
-void UserAccount::createAccount(std::vector<UserAccount>& users) {
-    try {
+void UserAccount::stageUserData(WriteBatch& batch, const std::string& dir) const {
+    batch.put(dir + "/address.txt", walletAddress);
+    batch.put(dir + "/balance.txt", walletBalance);
+    batch.put(dir + "/info.json", infoJson());
+}
 
- 	if (!checkSolanaInstallation()) {
-            installSolanaInstructions();
-            throw std::runtime_error("Solana CLI tools not installed");
-        }        
-	
-	std::cout << "Enter name: ";
+/*
+ * hashPassword(); veryfyPassword() was made using Argon2. Both run on the
+ * shared passwordHasher() lanes (see password_hasher.hpp).
+ */
+std::string UserAccount::hashPassword(const std::string& password) {
+    return passwordHasher().hash(password);
+}
+
+bool UserAccount::verifyPassword(const std::string& password, const std::string& storedHashData) {
+    return passwordHasher().verify(password, storedHashData);
+}
+
+
+
+void UserAccount::createAccount(UserTable& users) {
+    try {
+        std::cout << "Enter name: ";
         std::cin >> name;
         std::cout << "Enter email: ";
         std::cin >> email;
         std::cout << "Enter password: ";
         std::cin >> password;
 
-        for(const auto& user : users) {
-            if(user.email == email) {
-                throw std::runtime_error("Email already exists\n");
-            }
+        if (findUserByEmail(email)) {
+            throw std::runtime_error("Email already exists\n");
         }
 
         walletBalance = "0";
@@ -157,50 +346,23 @@ void UserAccount::createAccount(std::vector<UserAccount>& users) {
 
     	passwordHash = hashPassword(password);
 
-        // Sanitize both name and email for directory name
-        std::string safe_name = name;
-        std::string safe_email = email;
-        std::replace(safe_email.begin(), safe_email.end(), '@', '_');
-        std::replace(safe_email.begin(), safe_email.end(), '.', '_');
-        std::string keypair_dir = "keypairs/" + safe_name + "_" + safe_email;
+        // Directory name is built from the name and sanitized email
+        std::string keypair_dir = getKeypairDir();
 
         // Create fresh directory
-        std::string mkdir_cmd = "mkdir -p " + keypair_dir;
-        system(mkdir_cmd.c_str());
+        std::filesystem::create_directories(keypair_dir);
 
-        // Create a valid Solana keypair file
+        // Create a valid Solana keypair file; the address is its base58 public key
         std::string keypair_path = keypair_dir + "/id.json";
-
-        // Generate new keypair
-        std::string keygen_cmd = "solana-keygen new --no-bip39-passphrase --force -o " + keypair_path;
-        if (system(keygen_cmd.c_str()) != 0) {
-            throw std::runtime_error("Failed to generate keypair");
-        }
-
-        // Set Solana configuration
-        std::string config_cmd = "solana config set --url https://api.testnet.solana.com --keypair " + keypair_path;
-        system(config_cmd.c_str());
-
-        // Get the actual wallet address from the keypair
-        std::string address_cmd = "solana address -k " + keypair_path;
-        FILE* pipe = popen(address_cmd.c_str(), "r");
-		if (pipe) {
-            char buffer[128];
-            if (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-                walletAddress = std::string(buffer);
-					if (!walletAddress.empty() && walletAddress[walletAddress.length()-1] == '\n') {
-						walletAddress.erase(walletAddress.length()-1);
-					}
-            }
-            pclose(pipe);
-        }
+        SolanaKeypair keypair = SolanaKeypair::generate();
+        keypair.save(keypair_path, true);
+        walletAddress = keypair.address();
 
         // Save user data
         saveUserData(keypair_dir);
 
-        users.push_back(*this);
-        // Add to static allUsers vector for marketplace lookups
-        allUsers.push_back(&users.back());
+        // Slab slots never move, so nobody else's pointer is disturbed
+        userRegistry().add(users.emplace(*this));
         std::cout << "Account created successfully!" << std::endl;
         std::cout << "Wallet Address: " << walletAddress << std::endl;
 
@@ -209,117 +371,251 @@ void UserAccount::createAccount(std::vector<UserAccount>& users) {
     }
 }
 
-void UserAccount::loadExistingUsers(std::vector<UserAccount>& users) {
+void UserAccount::loadExistingUsers(UserTable& users) {
     try {
-        std::cout << "Loading existing users from keypairs directory..." << std::endl;
-        
-        // Check if keypairs directory exists
-        std::string cmd = "ls keypairs/ 2>/dev/null";
-        FILE* pipe = popen(cmd.c_str(), "r");
-        if (!pipe) {
-            std::cout << "No keypairs directory found." << std::endl;
-            return;
+        using Clock = std::chrono::steady_clock;
+        auto elapsedMs = [](Clock::time_point from, Clock::time_point to) {
+            return std::chrono::duration<double, std::milli>(to - from).count();
+        };
+
+        std::cout << "Loading existing users from the account store..." << std::endl;
+        Clock::time_point loadStart = Clock::now();
+        ThreadPool pool;
+
+        KeyValueStore& store = accountStore();
+        V<std::string> keys = store.keysWithPrefix("keypairs/");
+        if (keys.empty()) {
+            // First run on this store: bring in the per-user directories
+            size_t imported = importKeypairDirectories(store, pool);
+            std::cout << "Imported " << imported << " user directories from keypairs/ in "
+                      << elapsedMs(loadStart, Clock::now()) << " ms" << std::endl;
+            keys = store.keysWithPrefix("keypairs/");
         }
-        
-        char buffer[128];
-        while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-            std::string dir_name(buffer);
-            if (!dir_name.empty() && dir_name[dir_name.length()-1] == '\n') {
-                dir_name.erase(dir_name.length()-1);
+
+        // Phase 1: find every user's info record
+        Clock::time_point enumerateStart = Clock::now();
+        const std::string info_suffix = "/info.json";
+        V<std::string> userDirs;
+        for (const auto& key : keys) {
+            if (key.size() > info_suffix.size() &&
+                key.compare(key.size() - info_suffix.size(), info_suffix.size(), info_suffix) == 0) {
+                userDirs.push_back(key.substr(0, key.size() - info_suffix.size()));
             }
-            
-            // Try to load user data from this directory
-            std::string info_path = "keypairs/" + dir_name + "/info.json";
-            std::ifstream info_file(info_path);
-            if (info_file.is_open()) {
-                // Parse basic info (simplified - in real app you'd use JSON parser)
-                std::string line;
-                std::string name, email, walletAddress, balance, passwordHash;
-                
-                while (std::getline(info_file, line)) {
-                    // Clean the line
-                    line.erase(0, line.find_first_not_of(" \t"));
-                    if (line.empty()) continue;
-                    
-                    if (line.find("\"name\":") != std::string::npos) {
-                        size_t colonPos = line.find(":");
-                        if (colonPos != std::string::npos) {
-                            size_t start = line.find("\"", colonPos);
-                            size_t end = line.find("\"", start + 1);
-                            if (start != std::string::npos && end != std::string::npos) {
-                                name = line.substr(start + 1, end - start - 1);
-                            }
-                        }
-                    } else if (line.find("\"email\":") != std::string::npos) {
-                        size_t colonPos = line.find(":");
-                        if (colonPos != std::string::npos) {
-                            size_t start = line.find("\"", colonPos);
-                            size_t end = line.find("\"", start + 1);
-                            if (start != std::string::npos && end != std::string::npos) {
-                                email = line.substr(start + 1, end - start - 1);
-                            }
-                        }
-                    } else if (line.find("\"walletAddress\":") != std::string::npos) {
-                        size_t colonPos = line.find(":");
-                        if (colonPos != std::string::npos) {
-                            size_t start = line.find("\"", colonPos);
-                            size_t end = line.find("\"", start + 1);
-                            if (start != std::string::npos && end != std::string::npos) {
-                                walletAddress = line.substr(start + 1, end - start - 1);
-                            }
-                        }
-                    } else if (line.find("\"balance\":") != std::string::npos) {
-                        size_t colonPos = line.find(":");
-                        if (colonPos != std::string::npos) {
-                            size_t start = line.find("\"", colonPos);
-                            size_t end = line.find("\"", start + 1);
-                            if (start != std::string::npos && end != std::string::npos) {
-                                balance = line.substr(start + 1, end - start - 1);
-                            }
-                        }
-                    } else if (line.find("\"passwordHash\":") != std::string::npos) {
-                        size_t colonPos = line.find(":");
-                        if (colonPos != std::string::npos) {
-                            size_t start = line.find("\"", colonPos);
-                            size_t end = line.find("\"", start + 1);
-                            if (start != std::string::npos && end != std::string::npos) {
-                                passwordHash = line.substr(start + 1, end - start - 1);
-                            }
-                        }
-                    }
-                }
-                
-                if (!name.empty() && !email.empty()) {
-                    UserAccount user(walletAddress, name, email, "", balance);
-                    // Set the password hash if it was loaded
-                    if (!passwordHash.empty()) {
-                        user.passwordHash = passwordHash;
-                    }
-                    
-                    // Load collections for this user
-                    std::string user_dir = "keypairs/" + dir_name;
-                    user.loadCollections(user_dir);
-                    
-                    users.push_back(user);
-                    // Add to static allUsers vector for marketplace lookups
-                    allUsers.push_back(&users.back());
-                    std::cout << "Loaded existing user: " << name << " (" << email << ")" << std::endl;
-                    std::cout << "  Collections loaded: " << user.getCollections().size() << std::endl;
-                } else {
-                    std::cout << "Failed to parse user data from " << info_path << std::endl;
-                    std::cout << "Parsed values - Name: '" << name << "', Email: '" << email << "'" << std::endl;
-                }
-                
-                info_file.close();
+        }
+
+        // Phase 2: parse users in parallel, each worker filling its own slot
+        Clock::time_point parseStart = Clock::now();
+        std::vector<std::unique_ptr<UserAccount>> parsed(userDirs.size());
+        std::vector<char> inlineNFTs(userDirs.size(), 0);
+        std::atomic<size_t> failed{0};
+        pool.parallelFor(userDirs.size(), [&](size_t i) {
+            std::string info_text;
+            if (!store.get(userDirs[i] + info_suffix, info_text)) {
+                failed++;
+                return;
+            }
+
+            std::string name, email, walletAddress, balance, passwordHash;
+            try {
+                parseUserInfo(info_text, name, email, walletAddress, balance, passwordHash);
+            } catch (const std::exception&) {
+                failed++;
+                return;
             }
+            if (name.empty() || email.empty()) {
+                failed++;
+                return;
+            }
+
+            auto user = std::make_unique<UserAccount>(walletAddress, name, email, "", balance);
+            user->passwordHash = passwordHash;
+            inlineNFTs[i] = user->loadCollections(userDirs[i]);
+            parsed[i] = std::move(user);
+        });
+
+        // Phase 3: merge into the user table in store order
+        Clock::time_point mergeStart = Clock::now();
+        size_t loaded = 0, collectionCount = 0, nftCount = 0, migrated = 0;
+        WriteBatch migration;
+        for (size_t i = 0; i < parsed.size(); i++) {
+            std::unique_ptr<UserAccount>& user = parsed[i];
+            if (!user) continue;
+            if (inlineNFTs[i]) {
+                // Old layout: one record per NFT from now on
+                user->stageCollections(migration, userDirs[i]);
+                migrated++;
+            }
+            collectionCount += user->collections.size();
+            nftCount += user->ownedNFTs.size();
+            users.emplace(std::move(*user));
+            loaded++;
         }
-        pclose(pipe);
+        userRegistry().rebuild();
+        if (migrated > 0) {
+            try {
+                store.commit(migration);
+                std::cout << "Moved " << migrated << " accounts' NFTs into per-token records" << std::endl;
+            } catch (const std::exception& e) {
+                // Still readable as they are; tried again at the next start
+                std::cerr << "Error moving NFTs into per-token records: " << e.what() << std::endl;
+            }
+        }
+        Clock::time_point loadEnd = Clock::now();
+
+        std::cout << "Loaded " << loaded << " users (" << collectionCount << " collections, "
+                  << nftCount << " NFTs, " << failed.load() << " unreadable) in "
+                  << elapsedMs(loadStart, loadEnd) << " ms" << std::endl;
+        std::cout << "  enumerate: " << elapsedMs(enumerateStart, parseStart) << " ms, "
+                  << "parse: " << elapsedMs(parseStart, mergeStart) << " ms on " << pool.size() << " threads, "
+                  << "merge: " << elapsedMs(mergeStart, loadEnd) << " ms" << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "Error loading existing users: " << e.what() << std::endl;
     }
 }
 
-void UserAccount::login(std::vector<UserAccount>& users) {
+void UserAccount::reconcileBalances(UserTable& users) {
+    try {
+        auto start = std::chrono::steady_clock::now();
+        V<std::string> addresses;
+        for (const auto& user : users) {
+            addresses.push_back(user.walletAddress);
+        }
+        std::unordered_map<std::string, double> chain = SolanaIntegration::getBalances(addresses);
+
+        // Runs before the menu and the API server start, so nothing else is writing these
+        // accounts yet and one batch for all of them can't overtake a newer write
+        WriteBatch batch;
+        size_t updated = 0;
+        for (auto& user : users) {
+            auto it = chain.find(user.walletAddress);
+            if (it == chain.end()) continue;
+            AccountGuard account(user);
+            bool adopt;
+            try {
+                adopt = it->second - std::stod(user.walletBalance) > CHAIN_SYNC_THRESHOLD;
+            } catch (const std::exception&) {
+                adopt = true; // unparseable balance.txt
+            }
+            if (adopt) {
+                user.walletBalance = std::to_string(it->second);
+                // info.json carries the balance too
+                user.stageUserData(batch, user.getKeypairDir());
+                updated++;
+            }
+        }
+        if (updated > 0) {
+            accountStore().commit(batch);
+        }
+
+        auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+        std::cout << "Reconciled balances: " << chain.size() << "/" << users.size() << " wallets checked, "
+                  << updated << " updated from chain in " << elapsed.count() << " ms" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error reconciling balances: " << e.what() << std::endl;
+    }
+}
+
+void UserAccount::applyCompletedMints() {
+    std::vector<MintResult> results = mintQueue().takeCompleted();
+    if (results.empty()) return;
+
+    for (const auto& result : results) {
+        if (!result.succeeded()) {
+            std::cerr << "Mint job " << result.jobId << " for " << result.tokenId << " failed: " << result.error << std::endl;
+            continue;
+        }
+        UserAccount* owner = findUserByWallet(result.owner);
+        if (!owner) continue;
+        TokenId minted = TokenId::lookup(result.tokenId);
+
+        // The owner may be buying or listing through the API meanwhile; the record is
+        // committed before the lock is released, so it can't overwrite a later sale's
+        AccountGuard account(*owner);
+        bool changed = false;
+        for (auto& collection : owner->collections) {
+            if (NFT* nft = collection.findNFT(minted)) {
+                nft->setMintAddress(result.mintAddress);
+                changed = true;
+            }
+        }
+        if (NFT* nft = owner->findOwnedNFT(minted)) {
+            nft->setMintAddress(result.mintAddress);
+            changed = true;
+        }
+        if (changed) {
+            try {
+                WriteBatch batch;
+                owner->stageNFT(batch, owner->getKeypairDir(), minted);
+                accountStore().commit(batch);
+            } catch (const std::exception& e) {
+                std::cerr << "Error saving mint address of " << result.tokenId << ": " << e.what() << std::endl;
+            }
+        }
+        std::cout << "NFT " << result.tokenId << " minted at " << result.mintAddress << std::endl;
+    }
+}
+
+void UserAccount::addToSnapshot(SnapshotBuilder& builder) const {
+    SnapshotUser record{};
+    record.name = builder.intern(name);
+    record.email = builder.intern(email);
+    record.walletAddress = builder.intern(walletAddress);
+    record.balance = builder.intern(walletBalance);
+    record.passwordHash = builder.intern(passwordHash);
+    record.keypairPath = builder.intern(keypairPath);
+
+    record.firstCollection = builder.collectionCount();
+    for (const auto& collection : collections) {
+        collection.addToSnapshot(builder);
+    }
+    record.collectionCount = builder.collectionCount() - record.firstCollection;
+
+    // Collections add their NFTs first, so the owned NFTs follow them
+    record.firstOwnedNFT = builder.nftCount();
+    for (const auto& nft : ownedNFTs) {
+        builder.addNFT(nft.toSnapshot(builder));
+    }
+    record.ownedNFTCount = builder.nftCount() - record.firstOwnedNFT;
+
+    record.firstHistory = builder.historyCount();
+    for (const auto& transactionId : transactionHistory) {
+        builder.addHistory(builder.intern(transactionId));
+    }
+    record.historyCount = builder.historyCount() - record.firstHistory;
+
+    builder.addUser(record);
+}
+
+// Rebuilds the user table from a mapped image. Throws if the image refers
+// outside itself, in which case users is left untouched.
+void UserAccount::loadFromSnapshot(UserTable& users, const SnapshotImage& image) {
+    std::vector<UserAccount> loaded;
+    loaded.reserve(image.users().size());
+    for (const auto& record : image.users()) {
+        UserAccount user(image.text(record.walletAddress), image.text(record.name), image.text(record.email),
+                         "", image.text(record.balance));
+        user.passwordHash = image.text(record.passwordHash);
+        user.keypairPath = image.text(record.keypairPath);
+
+        for (const auto& collectionRecord : image.collections().slice(record.firstCollection, record.collectionCount)) {
+            user.collections.push_back(Collection::fromSnapshot(image, collectionRecord));
+        }
+        for (const auto& nftRecord : image.nfts().slice(record.firstOwnedNFT, record.ownedNFTCount)) {
+            user.addOwnedNFT(NFT::fromSnapshot(image, nftRecord));
+        }
+        for (uint32_t transactionId : image.history().slice(record.firstHistory, record.historyCount)) {
+            user.transactionHistory.push_back(image.text(transactionId));
+        }
+        loaded.push_back(std::move(user));
+    }
+
+    for (auto& user : loaded) {
+        users.emplace(std::move(user));
+    }
+    userRegistry().rebuild();
+}
+
+void UserAccount::login() {
 	try {
 		std::string inputEmail, inputPassword;
 		std::cout << "Enter email: ";
@@ -331,101 +627,91 @@ void UserAccount::login(std::vector<UserAccount>& users) {
 			throw LoginException("The field cannot be empty");
 		}
 
-		for(auto& user : users) {
-			if(user.email == inputEmail) {
-				// Check if user has a password hash (new users) or empty hash (existing users)
-				if (user.passwordHash.empty()) {
-					// Temporary workaround for existing users without password hashes
-					// For now, allow login and update the password hash
-					std::cout << "Updating password hash for existing user..." << std::endl;
-					user.passwordHash = user.hashPassword(inputPassword);
-					
-					// Save updated user data with password hash
-					std::string safe_email = user.email;
-					std::replace(safe_email.begin(), safe_email.end(), '@', '_');
-					std::replace(safe_email.begin(), safe_email.end(), '.', '_');
-					std::string keypair_dir = "keypairs/" + user.name + "_" + safe_email;
-					
-					// Update info.json with password hash
-					std::string info_path = keypair_dir + "/info.json";
-					std::ofstream info_file(info_path);
-					if (info_file.is_open()) {
-						info_file << "{\n";
-						info_file << "  \"name\": \"" << user.name << "\",\n";
-						info_file << "  \"email\": \"" << user.email << "\",\n";
-						info_file << "  \"walletAddress\": \"" << user.walletAddress << "\",\n";
-						info_file << "  \"balance\": \"" << user.walletBalance << "\",\n";
-						info_file << "  \"passwordHash\": \"" << user.passwordHash << "\"\n";
-						info_file << "}";
-						info_file.close();
+		UserAccount* found = findUserByEmail(inputEmail);
+		if (!found) {
+			throw LoginException("Invalid email");
+		}
+		UserAccount& user = *found;
+
+		// Check if user has a password hash (new users) or empty hash (existing users)
+		if (user.passwordHash.empty()) {
+			// Temporary workaround for existing users without password hashes
+			// For now, allow login and update the password hash
+			std::cout << "Updating password hash for existing user..." << std::endl;
+			std::string newHash = user.hashPassword(inputPassword);
+			{
+				// Update info.json with password hash
+				AccountGuard account(user);
+				user.passwordHash = newHash;
+				accountStore().put(user.getKeypairDir() + "/info.json", user.infoJson());
+			}
+			
+			// Set the currentUser pointer when login is successful
+			currentUser = &user;
+			std::cout << "Login successful! Welcome, " << user.name << std::endl;
+			std::cout << "Password hash updated and saved." << std::endl;
+			return;
+		} else {
+			// Verify password for users with existing password hashes
+			if (user.verifyPassword(inputPassword, user.passwordHash)) {
+				// Move hashes from the old hex form to the self-describing encoded form
+				if (PasswordHasher::needsRehash(user.passwordHash)) {
+					std::string newHash = user.hashPassword(inputPassword);
+					AccountGuard account(user);
+					user.passwordHash = newHash;
+					accountStore().put(user.getKeypairDir() + "/info.json", user.infoJson());
+				}
+
+				// Set the currentUser pointer when login is successful
+				currentUser = &user;
+				std::cout << "Login successful! Welcome, " << user.name << std::endl;
+				return;
+			} else {
+				// Check if this is the admin user and the password hash is corrupted
+				if (user.email == "admin@test") {
+					std::cout << "Admin password hash appears to be corrupted. Resetting to '123'..." << std::endl;
+					std::string newHash = user.hashPassword("123");
+					{
+						// Save updated admin data with new password hash
+						AccountGuard account(user);
+						user.passwordHash = newHash;
+						accountStore().put(user.getKeypairDir() + "/info.json", user.infoJson());
 					}
 					
 					// Set the currentUser pointer when login is successful
 					currentUser = &user;
-					std::cout << "Login successful! Welcome, " << user.name << std::endl;
-					std::cout << "Password hash updated and saved." << std::endl;
+					std::cout << "Admin password reset to '123'. Login successful! Welcome, " << user.name << std::endl;
 					return;
-				} else {
-					// Verify password for users with existing password hashes
-					if (user.verifyPassword(inputPassword, user.passwordHash)) {
-						// Set the currentUser pointer when login is successful
-						currentUser = &user;
-						std::cout << "Login successful! Welcome, " << user.name << std::endl;
-						return;
-					} else {
-						// Check if this is the admin user and the password hash is corrupted
-						if (user.email == "admin@test") {
-							std::cout << "Admin password hash appears to be corrupted. Resetting to '123'..." << std::endl;
-							user.passwordHash = user.hashPassword("123");
-							
-							// Save updated admin data with new password hash
-							std::string keypair_dir = "keypairs/admin_admin_test";
-							std::string info_path = keypair_dir + "/info.json";
-							std::ofstream info_file(info_path);
-							if (info_file.is_open()) {
-								info_file << "{\n";
-								info_file << "  \"name\": \"" << user.name << "\",\n";
-								info_file << "  \"email\": \"" << user.email << "\",\n";
-								info_file << "  \"walletAddress\": \"" << user.walletAddress << "\",\n";
-								info_file << "  \"balance\": \"" << user.walletBalance << "\",\n";
-								info_file << "  \"passwordHash\": \"" << user.passwordHash << "\"\n";
-								info_file << "}";
-								info_file.close();
-							}
-							
-							// Set the currentUser pointer when login is successful
-							currentUser = &user;
-							std::cout << "Admin password reset to '123'. Login successful! Welcome, " << user.name << std::endl;
-							return;
-						}
-						throw LoginException("Invalid password");
-					}
 				}
+				throw LoginException("Invalid password");
 			}
 		}
-		throw LoginException("Invalid email");
 	} catch (LoginException& e) {
 		std::cerr << "Login Error: " << e.what() << std::endl;
+	} catch (const std::exception& e) {
+		// Hasher overloaded or argon2 failure
+		std::cerr << "Login Error: " << e.what() << std::endl;
 	}
 }
 
 /*
  * added the code below to trace if the blockchain Solana is working correctly:
+ * the CLI is looked for on the first call only, and the answer kept for the
+ * rest of the run.
  */
 bool UserAccount::checkSolanaInstallation() {
-    // Check for solana CLI only
-    std::string solana_check = "which solana";
-    if (system(solana_check.c_str()) != 0) {
-        return false;
-    }
-
-    // Verify it's working by checking version
-    std::string version_check = "solana --version";
-    if (system(version_check.c_str()) != 0) {
-        return false;
-    }
+    static const bool installed = [] {
+        // Check for solana CLI only
+        std::string solana_check = "which solana";
+        if (system(solana_check.c_str()) != 0) {
+            return false;
+        }
 
-    return true;
+        // Verify it's working by checking version
+        std::string version_check = "solana --version";
+        return system(version_check.c_str()) == 0;
+    }();
+    return installed;
 }
 
 void UserAccount::installSolanaInstructions() {
@@ -454,28 +740,15 @@ void UserAccount::viewProfile() {
 	std::cout<<"Name: " <<currentUser->name<<std::endl;
 	std::cout<<"Email: " <<currentUser->email<<std::endl;
 	
-	// Get current devnet balance
-	std::string balance_cmd = "solana balance " + currentUser->getWalletAddress() + " --url https://api.devnet.solana.com";
-	FILE* balance_pipe = popen(balance_cmd.c_str(), "r");
-	if (balance_pipe) {
-		char buffer[128];
-		if (fgets(buffer, sizeof(buffer), balance_pipe) != nullptr) {
-			std::string balance_str(buffer);
-			// Remove " SOL" suffix and newline
-			size_t sol_pos = balance_str.find(" SOL");
-			if (sol_pos != std::string::npos) {
-				balance_str = balance_str.substr(0, sol_pos);
-			}
-			if (!balance_str.empty() && balance_str.back() == '\n') {
-				balance_str.pop_back();
-			}
-			double currentBalance = std::stod(balance_str);
-			std::cout<<"Current Devnet Balance: "<<currentBalance<<" SOL"<<std::endl;
-			// Update stored balance
-			currentUser->walletBalance = std::to_string(currentBalance);
-		}
-		pclose(balance_pipe);
+	// Get current on-chain balance
+	double currentBalance = 0.0;
+	if (SolanaIntegration::tryGetBalance(currentUser->getWalletAddress(), currentBalance)) {
+		std::cout<<"Current Devnet Balance: "<<currentBalance<<" SOL"<<std::endl;
+		// Update stored balance
+		AccountGuard account(*currentUser);
+		currentUser->walletBalance = std::to_string(currentBalance);
 	} else {
+		AccountGuard account(*currentUser);
 		std::cout<<"Wallet Balance: "<<currentUser->walletBalance<<" SOL"<<std::endl;
 	}
 }
@@ -489,28 +762,15 @@ void UserAccount::checkWalletBalance() {
 	}
 	std::cout<<"Address: "<<currentUser->walletAddress<<std::endl;
 	
-	// Get current devnet balance
-	std::string balance_cmd = "solana balance " + currentUser->getWalletAddress() + " --url https://api.devnet.solana.com";
-	FILE* balance_pipe = popen(balance_cmd.c_str(), "r");
-	if (balance_pipe) {
-		char buffer[128];
-		if (fgets(buffer, sizeof(buffer), balance_pipe) != nullptr) {
-			std::string balance_str(buffer);
-			// Remove " SOL" suffix and newline
-			size_t sol_pos = balance_str.find(" SOL");
-			if (sol_pos != std::string::npos) {
-				balance_str = balance_str.substr(0, sol_pos);
-			}
-			if (!balance_str.empty() && balance_str.back() == '\n') {
-				balance_str.pop_back();
-			}
-			double currentBalance = std::stod(balance_str);
-			std::cout<<"Current Devnet Balance: "<<currentBalance<<" SOL"<<std::endl;
-			// Update stored balance
-			currentUser->walletBalance = std::to_string(currentBalance);
-		}
-		pclose(balance_pipe);
+	// Get current on-chain balance
+	double currentBalance = 0.0;
+	if (SolanaIntegration::tryGetBalance(currentUser->getWalletAddress(), currentBalance)) {
+		std::cout<<"Current Devnet Balance: "<<currentBalance<<" SOL"<<std::endl;
+		// Update stored balance
+		AccountGuard account(*currentUser);
+		currentUser->walletBalance = std::to_string(currentBalance);
 	} else {
+		AccountGuard account(*currentUser);
 		std::cout<<"Balance: "<<currentUser->walletBalance<<" SOL"<<std::endl;
 	}
 
@@ -540,6 +800,21 @@ void UserAccount::viewTransactionHistory() {
 		return;
 	}
 
+	constexpr size_t HISTORY_PAGE_SIZE = 20;
+	// Most recent sales first, straight from the marketplace's wallet index
+	TransactionPage recent = Marketplace::getInstance()->getWalletTransactions(
+		currentUser->getWalletAddress(), std::nullopt, HISTORY_PAGE_SIZE);
+	if (!recent.items.empty()) {
+		for (const auto& tx : recent.items) {
+			tx.displayTransaction();
+		}
+		if (recent.nextCursor) {
+			std::cout<<"Showing the "<<recent.items.size()<<" most recent transactions"<<std::endl;
+		}
+		return;
+	}
+
+	AccountGuard account(*currentUser);
 	if (currentUser->transactionHistory.empty()) {
 		std::cout<<"No transaction found"<<std::endl;
 		return;
@@ -566,15 +841,16 @@ void UserAccount::createNFTCollection(std::vector<Collection>& collections) {
 
 		Collection newCollection(collectionName, currentUser->name);
 
-		currentUser->collections.push_back(newCollection);
-		collections.push_back(newCollection);
+		{
+			AccountGuard account(*currentUser);
+			currentUser->collections.push_back(newCollection);
 
-		// Save collections to disk
-		std::string safe_email = currentUser->email;
-		std::replace(safe_email.begin(), safe_email.end(), '@', '_');
-		std::replace(safe_email.begin(), safe_email.end(), '.', '_');
-		std::string keypair_dir = "keypairs/" + currentUser->name + "_" + safe_email;
-		currentUser->saveCollections(keypair_dir);
+			// Save the collection list to the account store; it has no NFTs yet
+			WriteBatch batch;
+			currentUser->stageCollectionList(batch, currentUser->getKeypairDir());
+			accountStore().commit(batch);
+		}
+		collections.push_back(newCollection);
 
 		std::cout<<"NFT collection created successfully!"<< std::endl;
 		std::cout <<"Collection Name: "<< collectionName<< std::endl;
@@ -594,22 +870,16 @@ void UserAccount::addNFTToCollection(std::vector<NFT>& nfts) {
 		return;
 	}
 
-	if (currentUser->collections.empty()) {
-		std::cout<<"Create a collection first\n"<<std::endl;
-		return;
+	{
+		AccountGuard account(*currentUser);
+		if (currentUser->collections.empty()) {
+			std::cout<<"Create a collection first\n"<<std::endl;
+			return;
+		}
 	}
 
-// Add Solana balance check (devnet)
-        std::string balance_cmd = "solana balance " + currentUser->getWalletAddress() + " --url https://api.devnet.solana.com";
-        FILE* balance_pipe = popen(balance_cmd.c_str(), "r");
-        double currentBalance = 0.0;
-        if (balance_pipe) {
-            char buffer[128];
-            if (fgets(buffer, sizeof(buffer), balance_pipe) != nullptr) {
-                currentBalance = std::stod(buffer);
-            }
-            pclose(balance_pipe);
-        }
+// Add Solana balance check
+        double currentBalance = SolanaIntegration::getBalance(currentUser->getWalletAddress());
         
         if (currentBalance < 0.05) {
         std::cout << "Insufficient SOL for minting. Need at least 0.05 SOL" << std::endl;
@@ -625,34 +895,37 @@ void UserAccount::addNFTToCollection(std::vector<NFT>& nfts) {
     }
 
 	try {
-		std::cout << "DEBUG: Available collections for user '" << currentUser->name << "':" << std::endl;
-		std::cout << "DEBUG: Collections vector size: " << currentUser->collections.size() << std::endl;
-		if (currentUser->collections.empty()) {
-			std::cout << "  No collections found in currentUser->collections" << std::endl;
-			std::cout << "DEBUG: This might mean collections weren't loaded properly" << std::endl;
-		} else {
-			for (const auto& collection : currentUser->collections) {
-				std::cout << "  - '" << collection.getName() << "' (creator: " << collection.getCreator() << ")" << std::endl;
+		{
+			AccountGuard account(*currentUser);
+			std::cout << "Available collections:" << std::endl;
+			if (currentUser->collections.empty()) {
+				std::cout << "  No collections found in currentUser->collections" << std::endl;
+			} else {
+				for (const auto& collection : currentUser->collections) {
+					std::cout << "  - '" << collection.getName() << "' (creator: " << collection.getCreator() << ")" << std::endl;
+				}
 			}
 		}
 
 		std::string collectionName;
 		std::cout<<"\nEnter collection name to add NFT: ";
 		std::getline(std::cin, collectionName);
-		std::cout << "DEBUG: Looking for collection: '" << collectionName << "'" << std::endl;
-		
-		Collection* targetCollection = nullptr;
-        	for (auto& collection : currentUser->collections) {
-            		if (collection.getName() == collectionName) {
-                		targetCollection = &collection;
-                		break;
-            		}
-       		}
 
-        
-        	if (!targetCollection) {
-            		throw std::runtime_error("Collection not found");
-        	}	
+		// Looked up again under the account lock below; a sale may add a collection while we wait for input
+		auto findCollection = [&] {
+			for (auto& collection : currentUser->collections) {
+				if (collection.getName() == collectionName) {
+					return &collection;
+				}
+			}
+			return static_cast<Collection*>(nullptr);
+		};
+		{
+			AccountGuard account(*currentUser);
+			if (!findCollection()) {
+				throw std::runtime_error("Collection not found");
+			}
+		}
 
 		std::string nftName;
         	double price;
@@ -668,30 +941,26 @@ void UserAccount::addNFTToCollection(std::vector<NFT>& nfts) {
         	}
 		
 		NFT newNFT(nftName, currentUser->walletAddress, price);
-		std::cout << "DEBUG: Created NFT with name: '" << nftName << "', owner: '" << currentUser->walletAddress << "', price: " << price << std::endl;
-		std::cout << "DEBUG: NFT tokenId: '" << newNFT.getTokenId() << "'" << std::endl;
 
- // Add Solana minting
-        	if (newNFT.mintOnSolana()) {
-            		std::cout << "NFT minted on Solana devnet" << std::endl;
-			std::cout << "DEBUG: NFT mintAddress: '" << newNFT.getMintAddress() << "'" << std::endl;
-			targetCollection->addNFT(newNFT);
-			nfts.push_back(newNFT);
-			currentUser->ownedNFTs.push_back(newNFT);
-		} else {
-           		 std::cout << "DEBUG: mintOnSolana() failed - adding NFT without Solana minting" << std::endl;
-			// Add NFT even if Solana minting fails
+		{
+			AccountGuard account(*currentUser);
+			Collection* targetCollection = findCollection();
+			if (!targetCollection) {
+				throw std::runtime_error("Collection not found");
+			}
 			targetCollection->addNFT(newNFT);
-			nfts.push_back(newNFT);
-			currentUser->ownedNFTs.push_back(newNFT);
-        	}			
-		
-		// Save updated collections to disk
-		std::string safe_email = currentUser->email;
-		std::replace(safe_email.begin(), safe_email.end(), '@', '_');
-		std::replace(safe_email.begin(), safe_email.end(), '.', '_');
-		std::string keypair_dir = "keypairs/" + currentUser->name + "_" + safe_email;
-		currentUser->saveCollections(keypair_dir);
+			currentUser->addOwnedNFT(newNFT);
+
+			// Save the new NFT's record to the account store
+			WriteBatch batch;
+			currentUser->stageNFT(batch, currentUser->getKeypairDir(), newNFT.id());
+			accountStore().commit(batch);
+		}
+		nfts.push_back(newNFT);
+
+		// Mint in the background; applyCompletedMints() records the address when it's done
+		MintQueue::Ticket ticket = mintQueue().submit(MintRequest{newNFT.getTokenId(), newNFT.getOwner(), newNFT.getMetadataUri()});
+		std::cout << "Mint job " << ticket.jobId << " queued (" << mintQueue().pending() << " pending)" << std::endl;
 
  		std::cout<<"\nNFT added successfully!" << std::endl;
         	std::cout<<"Token ID: " << newNFT.getTokenId() << std::endl;
@@ -709,16 +978,17 @@ void UserAccount::viewNFTsCollection() {
         return;
     }
 
-    if (currentUser->collections.empty()) {
-        std::cout << "\nNo collections found. Create a collection first!\n" << std::endl;
-        return;
-    }
-
     try {
-        // First for loop was not properly closed
-        for (const auto& collection : currentUser->collections) {
-            std::cout << collection.getName() << std::endl;
-        }  // Added missing closing brace here
+        {
+            AccountGuard account(*currentUser);
+            if (currentUser->collections.empty()) {
+                std::cout << "\nNo collections found. Create a collection first!\n" << std::endl;
+                return;
+            }
+            for (const auto& collection : currentUser->collections) {
+                std::cout << collection.getName() << std::endl;
+            }
+        }
 
         std::string collectionName;
         std::cout << "\nEnter collection name to view: ";
@@ -726,6 +996,7 @@ void UserAccount::viewNFTsCollection() {
         std::getline(std::cin, collectionName);
 
         bool found = false;
+        AccountGuard account(*currentUser);
         for (const auto& collection : currentUser->collections) {
             if (collection.getName() == collectionName) {
                 collection.displayCollection();
@@ -797,44 +1068,27 @@ void UserAccount::checkSolBalance() {
         std::cout << "  Wallet Address: " << currentUser->walletAddress << std::endl;
         std::cout << "Checking SOL balance for wallet: " << currentUser->walletAddress << std::endl;
         
-        // Check devnet balance (primary)
-        std::string devnet_cmd = "solana balance " + currentUser->walletAddress + " --url https://api.devnet.solana.com";
-        FILE* pipe = popen(devnet_cmd.c_str(), "r");
-        if (pipe) {
-            char buffer[128];
-                          if (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-                 std::cout << "Raw buffer: '" << buffer << "'" << std::endl; // DEBUG
-                 std::string balance_str(buffer);
-                 // Remove " SOL" suffix and newline
-                 size_t sol_pos = balance_str.find(" SOL");
-                 if (sol_pos != std::string::npos) {
-                     balance_str = balance_str.substr(0, sol_pos);
-                 }
-                 if (!balance_str.empty() && balance_str.back() == '\n') {
-                     balance_str.pop_back();
-                 }
-                 std::cout << "Parsed balance string: '" << balance_str << "'" << std::endl; // DEBUG
-                 
-                 try {
-                     double devnetBalance = std::stod(balance_str);
-                     double currentLocalBalance = std::stod(currentUser->walletBalance);
-                     std::cout << "Devnet Balance: " << devnetBalance << " SOL" << std::endl;
-                     std::cout << "Local Balance: " << currentLocalBalance << " SOL" << std::endl;
-                     
-                     // For marketplace operations, prioritize local balance
-                     // Only update from devnet if the difference is significant (airdrops)
-                     double difference = devnetBalance - currentLocalBalance;
-                     if (difference > 0.1) { // Only update if devnet has significantly more (likely airdrop)
-                         currentUser->walletBalance = std::to_string(devnetBalance);
-                         std::cout << "Updated walletBalance to: " << currentUser->walletBalance << " SOL (devnet had significant airdrop)" << std::endl;
-                     } else {
-                         std::cout << "Keeping local balance: " << currentUser->walletBalance << " SOL (preserving marketplace transactions)" << std::endl;
-                     }
-                 } catch (const std::exception& e) {
-                     std::cout << "Failed to parse balance: " << e.what() << std::endl;
-                 }
-             }
-            pclose(pipe);
+        // Check on-chain balance (primary)
+        double devnetBalance = 0.0;
+        if (SolanaIntegration::tryGetBalance(currentUser->walletAddress, devnetBalance)) {
+            try {
+                AccountGuard account(*currentUser);
+                double currentLocalBalance = std::stod(currentUser->walletBalance);
+                std::cout << "Devnet Balance: " << devnetBalance << " SOL" << std::endl;
+                std::cout << "Local Balance: " << currentLocalBalance << " SOL" << std::endl;
+
+                // For marketplace operations, prioritize local balance
+                // Only update from devnet if the difference is significant (airdrops)
+                double difference = devnetBalance - currentLocalBalance;
+                if (difference > CHAIN_SYNC_THRESHOLD) { // Only update if devnet has significantly more (likely airdrop)
+                    currentUser->walletBalance = std::to_string(devnetBalance);
+                    std::cout << "Updated walletBalance to: " << currentUser->walletBalance << " SOL (devnet had significant airdrop)" << std::endl;
+                } else {
+                    std::cout << "Keeping local balance: " << currentUser->walletBalance << " SOL (preserving marketplace transactions)" << std::endl;
+                }
+            } catch (const std::exception& e) {
+                std::cout << "Failed to parse balance: " << e.what() << std::endl;
+            }
         } else {
             std::cout << "Failed to fetch devnet balance" << std::endl;
         }
@@ -860,29 +1114,11 @@ void UserAccount::requestTestSol() {
         SolanaIntegration::airdropDevnet(currentUser->getWalletAddress());
         
         // Update the user's balance
-        std::string balance_cmd = "solana balance " + currentUser->getWalletAddress() + " --url https://api.devnet.solana.com";
-        FILE* balance_pipe = popen(balance_cmd.c_str(), "r");
-        if (balance_pipe) {
-            char buffer[128];
-            if (fgets(buffer, sizeof(buffer), balance_pipe) != nullptr) {
-                std::string balance_str(buffer);
-                // Remove " SOL" suffix and newline
-                size_t sol_pos = balance_str.find(" SOL");
-                if (sol_pos != std::string::npos) {
-                    balance_str = balance_str.substr(0, sol_pos);
-                }
-                if (!balance_str.empty() && balance_str.back() == '\n') {
-                    balance_str.pop_back();
-                }
-                try {
-                    double newBalance = std::stod(balance_str);
-                    currentUser->walletBalance = std::to_string(newBalance);
-                    std::cout << "Updated balance: " << currentUser->walletBalance << " SOL" << std::endl;
-                } catch (const std::exception& e) {
-                    std::cout << "Failed to parse balance: " << e.what() << std::endl;
-                }
-            }
-            pclose(balance_pipe);
+        double newBalance = 0.0;
+        if (SolanaIntegration::tryGetBalance(currentUser->getWalletAddress(), newBalance)) {
+            AccountGuard account(*currentUser);
+            currentUser->walletBalance = std::to_string(newBalance);
+            std::cout << "Updated balance: " << currentUser->walletBalance << " SOL" << std::endl;
         }
         
     } catch(const std::exception& e) {
@@ -893,189 +1129,90 @@ void UserAccount::requestTestSol() {
 
 
 
-    void UserAccount::saveCollections(const std::string& dir) {
-        std::string collections_path = dir + "/collections.json";
-        std::cout << "DEBUG: Saving collections to: " << collections_path << std::endl;
-        std::cout << "DEBUG: Number of collections: " << collections.size() << std::endl;
-        std::ofstream collections_file(collections_path);
-        if (collections_file.is_open()) {
-            collections_file << "{\n";
-            collections_file << "  \"collections\": [\n";
-            
-            for (size_t i = 0; i < collections.size(); i++) {
-                const auto& collection = collections[i];
-                collections_file << "    {\n";
-                collections_file << "      \"name\": \"" << collection.getName() << "\",\n";
-                collections_file << "      \"creator\": \"" << collection.getCreator() << "\",\n";
-                collections_file << "      \"nfts\": [\n";
-                
-                const auto& nfts = collection.getNFTs();
-                for (size_t j = 0; j < nfts.size(); j++) {
-                    const auto& nft = nfts[j];
-                    std::cout << "DEBUG: Saving NFT " << j << ": name='" << nft.getName() << "', tokenId='" << nft.getTokenId() << "', owner='" << nft.getOwner() << "', price=" << nft.getPrice() << std::endl;
-                    collections_file << "        {\n";
-                    collections_file << "          \"name\": \"" << nft.getName() << "\",\n";
-                    collections_file << "          \"tokenId\": \"" << nft.getTokenId() << "\",\n";
-                    collections_file << "          \"owner\": \"" << nft.getOwner() << "\",\n";
-                    collections_file << "          \"price\": " << nft.getPrice() << ",\n";
-                    collections_file << "          \"isListed\": " << (nft.getIsListed() ? "true" : "false") << ",\n";
-                    collections_file << "          \"mintAddress\": \"" << nft.getMintAddress() << "\",\n";
-                    collections_file << "          \"metadataUri\": \"" << nft.getMetadataUri() << "\"\n";
-                    collections_file << "        }";
-                    if (j < nfts.size() - 1) collections_file << ",";
-                    collections_file << "\n";
-                }
-                
-                collections_file << "      ]\n";
-                collections_file << "    }";
-                if (i < collections.size() - 1) collections_file << ",";
-                collections_file << "\n";
+    std::string UserAccount::collectionsJson() const {
+        thread_local JsonWriter json(true);
+        json.clear();
+        json.beginObject().key("collections").beginArray();
+        for (const auto& collection : collections) {
+            json.beginObject()
+                .field("name", collection.getName())
+                .field("creator", collection.getCreator())
+                .endObject();
+        }
+        json.endArray().endObject();
+        return json.str();
+    }
+
+    void UserAccount::stageCollections(WriteBatch& batch, const std::string& dir) const {
+        stageCollectionList(batch, dir);
+        for (const auto& collection : collections) {
+            for (const auto& nft : collection.getNFTs()) {
+                batch.put(dir + "/nfts/" + nft.getTokenId(), nftRecord(nft, collection.getName()));
             }
-            
-            collections_file << "  ]\n";
-            collections_file << "}";
-            collections_file.close();
         }
     }
 
-    void UserAccount::loadCollections(const std::string& dir) {
-        std::string collections_path = dir + "/collections.json";
-        std::cout << "DEBUG: Loading collections from: " << collections_path << std::endl;
-        std::ifstream collections_file(collections_path);
-        if (!collections_file.is_open()) {
-            std::cout << "DEBUG: No collections file found at: " << collections_path << std::endl;
-            return; // No collections file exists yet
+    void UserAccount::stageCollectionList(WriteBatch& batch, const std::string& dir) const {
+        batch.put(dir + "/collections.json", collectionsJson());
+    }
+
+    void UserAccount::stageNFT(WriteBatch& batch, const std::string& dir, TokenId tokenId) const {
+        std::string key = dir + "/nfts/" + tokenId.toString();
+        for (const auto& collection : collections) {
+            if (const NFT* nft = collection.findNFT(tokenId)) {
+                batch.put(key, nftRecord(*nft, collection.getName()));
+                return;
+            }
         }
-        std::cout << "DEBUG: Collections file opened successfully" << std::endl;
-
-        try {
-            std::string line;
-            std::string currentCollection;
-            std::string currentNFT;
-            bool inCollections = false;
-            bool inCollection = false;
-            bool inNFTs = false;
-            bool inNFT = false;
-            
-            std::string collectionName, collectionCreator;
-            std::string nftName, nftTokenId, nftOwner, nftMintAddress, nftMetadataUri;
-            double nftPrice = 0.0;
-            bool nftIsListed = false;
-            V<NFT> currentNFTs;
-
-            while (std::getline(collections_file, line)) {
-                // Remove whitespace
-                line.erase(0, line.find_first_not_of(" \t"));
-                if (line.empty()) continue;
-
-                if (line.find("\"collections\":") != std::string::npos) {
-                    inCollections = true;
-                } else if (line.find("\"name\":") != std::string::npos && inCollections) {
-                    size_t start = line.find("\"", line.find(":"));
-                    size_t end = line.find("\"", start + 1);
-                    if (start != std::string::npos && end != std::string::npos) {
-                        if (inCollection && !inNFTs) {
-                            collectionName = line.substr(start + 1, end - start - 1);
-                            std::cout << "DEBUG: Parsed collection name: '" << collectionName << "'" << std::endl;
-                        } else if (inNFT) {
-                            nftName = line.substr(start + 1, end - start - 1);
-                            std::cout << "DEBUG: Parsed NFT name: '" << nftName << "'" << std::endl;
-                        }
-                    }
-                } else if (line.find("\"creator\":") != std::string::npos && inCollection) {
-                    size_t start = line.find("\"", line.find(":"));
-                    size_t end = line.find("\"", start + 1);
-                    if (start != std::string::npos && end != std::string::npos) {
-                        collectionCreator = line.substr(start + 1, end - start - 1);
-                    }
-                } else if (line.find("\"tokenId\":") != std::string::npos && inNFT) {
-                    size_t start = line.find("\"", line.find(":"));
-                    size_t end = line.find("\"", start + 1);
-                    if (start != std::string::npos && end != std::string::npos) {
-                        nftTokenId = line.substr(start + 1, end - start - 1);
-                    }
-                } else if (line.find("\"owner\":") != std::string::npos && inNFT) {
-                    size_t start = line.find("\"", line.find(":"));
-                    size_t end = line.find("\"", start + 1);
-                    if (start != std::string::npos && end != std::string::npos) {
-                        nftOwner = line.substr(start + 1, end - start - 1);
-                    }
-                } else if (line.find("\"price\":") != std::string::npos && inNFT) {
-                    size_t colonPos = line.find(":");
-                    if (colonPos != std::string::npos) {
-                        std::string priceStr = line.substr(colonPos + 1);
-                        // Remove trailing comma if present
-                        if (!priceStr.empty() && priceStr.back() == ',') {
-                            priceStr.pop_back();
-                        }
-                        nftPrice = std::stod(priceStr);
-                    }
-                } else if (line.find("\"isListed\":") != std::string::npos && inNFT) {
-                    if (line.find("true") != std::string::npos) {
-                        nftIsListed = true;
-                    }
-                } else if (line.find("\"mintAddress\":") != std::string::npos && inNFT) {
-                    size_t start = line.find("\"", line.find(":"));
-                    size_t end = line.find("\"", start + 1);
-                    if (start != std::string::npos && end != std::string::npos) {
-                        nftMintAddress = line.substr(start + 1, end - start - 1);
-                    }
-                } else if (line.find("\"metadataUri\":") != std::string::npos && inNFT) {
-                    size_t start = line.find("\"", line.find(":"));
-                    size_t end = line.find("\"", start + 1);
-                    if (start != std::string::npos && end != std::string::npos) {
-                        nftMetadataUri = line.substr(start + 1, end - start - 1);
-                    }
-                } else if (line.find("\"nfts\":") != std::string::npos && inCollection) {
-                    inNFTs = true;
-                    std::cout << "DEBUG: Entered NFTs section for collection: '" << collectionName << "'" << std::endl;
-                } else if (line.find("{") != std::string::npos) {
-                    if (inCollections && !inCollection) {
-                        inCollection = true;
-                        collectionName = "";
-                        collectionCreator = "";
-                        currentNFTs.clear();
-                    } else if (inNFTs && !inNFT) {
-                        inNFT = true;
-                        nftName = "";
-                        nftTokenId = "";
-                        nftOwner = "";
-                        nftPrice = 0.0;
-                        nftIsListed = false;
-                        nftMintAddress = "";
-                        nftMetadataUri = "";
-                    }
-                } else if (line.find("}") != std::string::npos) {
-                    if (inNFT) {
-                        // Complete NFT - use constructor with explicit tokenId
-                        NFT nft(nftTokenId, nftName, nftOwner, nftPrice, nftIsListed, nftMetadataUri);
-                        // Set mint address separately since constructor doesn't handle it
-                        nft.setMintAddress(nftMintAddress);
-                        currentNFTs.push_back(nft);
-                        inNFT = false;
-                    } else if (inCollection) {
-                        // Complete collection
-                        std::cout << "DEBUG: Completing collection: '" << collectionName << "' (creator: " << collectionCreator << ")" << std::endl;
-                        Collection collection(collectionName, collectionCreator);
-                        for (const auto& nft : currentNFTs) {
-                            collection.addNFT(nft);
-                            // Only add to ownedNFTs list if NFT has valid data
-                            if (!nft.getTokenId().empty() && !nft.getName().empty()) {
-                                ownedNFTs.push_back(nft);
-                            }
-                        }
-                        collections.push_back(collection);
-                        inCollection = false;
-                        inNFTs = false;
-                    }
-                }
+        batch.remove(key);
+    }
+
+    void UserAccount::stageTransaction(WriteBatch& batch, const std::string& dir, const std::string& transactionId) const {
+        batch.put(dir + "/transactions/" + transactionId, "");
+    }
+
+    bool UserAccount::loadCollections(const std::string& dir) {
+        KeyValueStore& store = accountStore();
+        bool inlineNFTs = false;
+        std::string collections_text;
+        if (store.get(dir + "/collections.json", collections_text)) {
+            try {
+                CollectionsHandler handler(collections, ownedNFTs);
+                JsonReader(collections_text).parse(handler);
+                inlineNFTs = handler.hadInlineNFTs();
+            } catch (const std::exception& e) {
+                std::cerr << "Error loading collections: " << e.what() << std::endl;
             }
-        } catch (const std::exception& e) {
-            std::cerr << "Error loading collections: " << e.what() << std::endl;
         }
-        
-        collections_file.close();
-        std::cout << "DEBUG: Loaded " << collections.size() << " collections" << std::endl;
+
+        // Each NFT record goes into the collection it names
+        std::unordered_map<std::string, size_t> byName;
+        for (size_t i = 0; i < collections.size(); i++) {
+            byName.emplace(collections[i].getName(), i);
+        }
+        std::string record;
+        for (const auto& key : store.keysWithPrefix(dir + "/nfts/")) {
+            if (!store.get(key, record)) continue;
+            std::string collectionName;
+            NFT nft;
+            try {
+                nft = parseNFTRecord(record, collectionName);
+            } catch (const std::exception& e) {
+                std::cerr << "Error loading " << key << ": " << e.what() << std::endl;
+                continue;
+            }
+            auto slot = byName.emplace(collectionName, collections.size());
+            if (slot.second) {
+                collections.push_back(Collection(collectionName, name));
+            }
+            collections[slot.first->second].addNFT(nft);
+            // Only add to ownedNFTs list if NFT has valid data
+            if (!nft.getTokenId().empty() && !nft.getName().empty()) {
+                ownedNFTs.push_back(std::move(nft));
+            }
+        }
+        indexOwnedNFTs();
+        return inlineNFTs;
     }
 
 
@@ -1,6 +1,180 @@
 #include <crow.h>
 #include "../include/header.hpp"
+#include "../include/json_writer.hpp"
+#include "../include/solana_keypair.hpp"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <optional>
 #include <string>
+#include <string_view>
+
+namespace {
+    // Sends a JsonWriter document as the response body, skipping crow's wvalue tree
+    crow::response jsonResponse(int code, const JsonWriter& json) {
+        crow::response res(code, json.str());
+        res.set_header("Content-Type", "application/json");
+        return res;
+    }
+
+    // {"boundsMs": [...], "counts": [...], "totalMs": n}; the last count is the overflow bucket
+    void writeHistogram(JsonWriter& json, const LatencyHistogram& histogram) {
+        json.beginObject().key("boundsMs").beginArray();
+        for (uint32_t bound : LatencyHistogram::BOUNDS_MS) {
+            json.value(bound);
+        }
+        json.endArray().key("counts").beginArray();
+        for (uint64_t count : histogram.counts) {
+            json.value(count);
+        }
+        json.endArray().field("totalMs", histogram.totalMs).endObject();
+    }
+
+    // Session from an "Authorization: Bearer <token>" header; HMAC only, no argon2
+    std::optional<Session> authenticate(const crow::request& req) {
+        const std::string header = req.get_header_value("Authorization");
+        const std::string prefix = "Bearer ";
+        if (header.compare(0, prefix.size(), prefix) != 0) {
+            return std::nullopt;
+        }
+        return sessionManager().validate(std::string_view(header).substr(prefix.size()));
+    }
+
+    // Each server thread keeps one buffer for the responses it builds
+    JsonWriter& responseWriter() {
+        thread_local JsonWriter json;
+        json.clear();
+        return json;
+    }
+
+    // The account behind the session, or nullptr
+    UserAccount* sessionUser(const crow::request& req) {
+        std::optional<Session> session = authenticate(req);
+        return session ? UserAccount::findUserByEmail(session->email) : nullptr;
+    }
+
+    size_t pageLimit(const crow::request& req) {
+        const char* limit = req.url_params.get("limit");
+        return limit ? std::stoul(limit) : 20;
+    }
+
+    /*
+     * Page cursors are opaque to clients: a tag naming what the cursor pages
+     * through, then the position of the last item returned as 16-digit hex
+     * words. A cursor from one query passed to another is rejected rather
+     * than misread.
+     */
+    std::string encodeCursor(char tag, std::initializer_list<uint64_t> words) {
+        std::string cursor(1, tag);
+        char hex[17];
+        for (uint64_t word : words) {
+            std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(word));
+            cursor += hex;
+        }
+        return cursor;
+    }
+
+    bool decodeCursor(const std::string& cursor, char tag, uint64_t* words, size_t count) {
+        if (cursor.size() != 1 + 16 * count || cursor[0] != tag) {
+            return false;
+        }
+        for (size_t i = 0; i < count; i++) {
+            uint64_t word = 0;
+            for (char c : std::string_view(cursor).substr(1 + 16 * i, 16)) {
+                int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+                if (digit < 0) return false;
+                word = (word << 4) | static_cast<uint64_t>(digit);
+            }
+            words[i] = word;
+        }
+        return true;
+    }
+
+    char listingCursorTag(ListingSort sort) {
+        switch (sort) {
+            case ListingSort::PRICE_ASC: return 'a';
+            case ListingSort::PRICE_DESC: return 'd';
+            case ListingSort::NEWEST: return 'n';
+            case ListingSort::OLDEST: return 'o';
+        }
+        return '?';
+    }
+
+    std::string encodeListingCursor(ListingSort sort, const OrderBookEntry& entry) {
+        uint64_t priceBits;
+        std::memcpy(&priceBits, &entry.price, sizeof(priceBits));
+        return encodeCursor(listingCursorTag(sort), {priceBits, entry.listedSeq});
+    }
+
+    std::optional<OrderBookEntry> decodeListingCursor(const std::string& cursor, ListingSort sort) {
+        uint64_t words[2];
+        if (!decodeCursor(cursor, listingCursorTag(sort), words, 2)) {
+            return std::nullopt;
+        }
+        OrderBookEntry entry{0.0, words[1], TokenId()};
+        std::memcpy(&entry.price, &words[0], sizeof(entry.price));
+        return entry;
+    }
+
+    void writeListing(JsonWriter& json, const NFT& nft) {
+        double fee = Marketplace::getInstance()->calculateFee(nft.getPrice());
+        json.beginObject()
+            .field("tokenId", nft.getTokenId())
+            .field("name", nft.getName())
+            .field("owner", nft.getOwner())
+            .field("price", nft.getPrice())
+            .field("platformFee", fee)
+            .field("totalCost", nft.getPrice() + fee)
+            .field("collection", nft.getCollection())
+            .field("mintAddress", nft.getMintAddress())
+            .field("metadataUri", nft.getMetadataUri())
+            .endObject();
+    }
+
+    void writeTransaction(JsonWriter& json, const Transaction& tx) {
+        json.beginObject()
+            .field("transactionId", tx.getTransactionId())
+            .field("tokenId", tx.getTokenId())
+            .field("seller", tx.getSeller())
+            .field("buyer", tx.getBuyer())
+            .field("price", tx.getPrice())
+            .field("timestamp", tx.getTimestamp())
+            .field("status", tx.getStatus())
+            .endObject();
+    }
+
+    // {"items": [...], "nextCursor": "..." or null}
+    crow::response transactionPageResponse(const TransactionPage& page) {
+        JsonWriter& json = responseWriter();
+        json.beginObject().key("items").beginArray();
+        for (const auto& tx : page.items) {
+            writeTransaction(json, tx);
+        }
+        json.endArray().key("nextCursor");
+        if (page.nextCursor) {
+            json.value(encodeCursor('t', {*page.nextCursor}));
+        } else {
+            json.null();
+        }
+        json.endObject();
+        return jsonResponse(200, json);
+    }
+
+    // Reads ?cursor= for a transaction page; false if it is there but not one of ours
+    bool transactionCursor(const crow::request& req, std::optional<uint64_t>& cursor) {
+        const char* text = req.url_params.get("cursor");
+        if (!text) {
+            return true;
+        }
+        uint64_t sequence;
+        if (!decodeCursor(text, 't', &sequence, 1)) {
+            return false;
+        }
+        cursor = sequence;
+        return true;
+    }
+}
 
 void startApiServer() {
     crow::SimpleApp app;
@@ -16,17 +190,19 @@ void startApiServer() {
                     std::string name = x["name"].s();
                     std::string keypair_path = "keypairs/" + name + "/id.json";
                     
-                    // Use solana-keygen directly since it's in PATH
-                    std::string keygen_cmd = "solana-keygen new --no-bip39-passphrase --force -o " + keypair_path;
-                    
-                    if (system(keygen_cmd.c_str()) != 0) {
-                        return crow::response(500, "Failed to generate keypair");
+                    try {
+                        std::filesystem::create_directories("keypairs/" + name);
+                        SolanaKeypair::generate().save(keypair_path, true);
+                    } catch (const std::exception& e) {
+                        return crow::response(500, std::string("Failed to generate keypair: ") + e.what());
                     }
 
-                    crow::json::wvalue response;
-                    response["status"] = "success";
-                    response["keypair_path"] = keypair_path;
-                    return crow::response(response);
+                    JsonWriter& json = responseWriter();
+                    json.beginObject()
+                        .field("status", "success")
+                        .field("keypair_path", keypair_path)
+                        .endObject();
+                    return jsonResponse(200, json);
                 } catch(const std::exception& e) {
                     return crow::response(400, e.what());
                 }
@@ -42,11 +218,13 @@ void startApiServer() {
                     std::string check_cmd = "test -f " + keypair_path;
                     if (system(check_cmd.c_str()) == 0) {
                         // File exists, return account info
-                        crow::json::wvalue response;
-                        response["status"] = "success";
-                        response["name"] = name;
-                        response["keypair_path"] = keypair_path;
-                        return crow::response(response);
+                        JsonWriter& json = responseWriter();
+                        json.beginObject()
+                            .field("status", "success")
+                            .field("name", name)
+                            .field("keypair_path", keypair_path)
+                            .endObject();
+                        return jsonResponse(200, json);
                     } else {
                         // File doesn't exist
                         return crow::response(404, "Account not found");
@@ -79,10 +257,13 @@ void startApiServer() {
                     pclose(pipe);
 
                     // Create response
-                    crow::json::wvalue response;
-                    response["status"] = "success";
-                    response["accounts"] = accounts;
-                    return crow::response(response);
+                    JsonWriter& json = responseWriter();
+                    json.beginObject().field("status", "success").key("accounts").beginArray();
+                    for (const auto& account : accounts) {
+                        json.value(account);
+                    }
+                    json.endArray().endObject();
+                    return jsonResponse(200, json);
                 } catch(const std::exception& e) {
                     return crow::response(400, e.what());
                 }
@@ -111,15 +292,451 @@ void startApiServer() {
                         pclose(pipe);
 
                         // Create response
-                        crow::json::wvalue response;
-                        response["status"] = "success";
-                        response["collections"] = collections;
-                        return crow::response(response);
+                        JsonWriter& json = responseWriter();
+                        json.beginObject().field("status", "success").key("collections").beginArray();
+                        for (const auto& collection : collections) {
+                            json.value(collection);
+                        }
+                        json.endArray().endObject();
+                        return jsonResponse(200, json);
                     } catch(const std::exception& e) {
                         return crow::response(400, e.what());
                     }
                 });
 
+            // Count, total and lowest price of live listings; ?min=&max=&collection= narrow it down
+            CROW_ROUTE(app, "/api/marketplace/stats").methods("GET"_method)
+                ([](const crow::request& req) {
+                    try {
+                        const char* min = req.url_params.get("min");
+                        const char* max = req.url_params.get("max");
+                        const char* collection = req.url_params.get("collection");
+                        double minPrice = min ? std::stod(min) : 0.0;
+                        double maxPrice = max ? std::stod(max) : ListingColumns::ANY_PRICE;
+                        ListingStats stats = Marketplace::getInstance()->getListingStats(
+                            minPrice, maxPrice, collection ? collection : "");
+
+                        JsonWriter& json = responseWriter();
+                        json.beginObject()
+                            .field("count", stats.count)
+                            .field("totalPrice", stats.totalPrice)
+                            .key("minPrice");
+                        if (stats.count > 0) {
+                            json.value(stats.minPrice);
+                        } else {
+                            json.null();
+                        }
+                        json.endObject();
+                        return jsonResponse(200, json);
+                    } catch (const std::exception& e) {
+                        return crow::response(400, e.what());
+                    }
+                });
+
+            // Floor price and listing count of every collection with live listings
+            CROW_ROUTE(app, "/api/marketplace/floors").methods("GET"_method)
+                ([]() {
+                    std::shared_ptr<const ListingsView> view = Marketplace::getInstance()->getListingsView();
+                    JsonWriter& json = responseWriter();
+                    json.beginObject().key("collections").beginArray();
+                    for (const auto& [collection, summary] : *view) {
+                        json.beginObject()
+                            .field("collection", collection)
+                            .field("floorPrice", *summary->floorPrice)
+                            .field("listingCount", summary->listingCount)
+                            .endObject();
+                    }
+                    json.endArray().endObject();
+                    return jsonResponse(200, json);
+                });
+
+            // One collection's floor and its ?limit= cheapest listings: ?collection=&limit=
+            CROW_ROUTE(app, "/api/marketplace/floor").methods("GET"_method)
+                ([](const crow::request& req) {
+                    try {
+                        const char* collection = req.url_params.get("collection");
+                        if (!collection) {
+                            return crow::response(400, "Expected collection");
+                        }
+                        Marketplace* marketplace = Marketplace::getInstance();
+                        std::optional<double> floor = marketplace->getFloorPrice(collection);
+                        V<OrderBookEntry> cheapest = marketplace->getCheapestListings(
+                            collection, std::min(pageLimit(req), Marketplace::MAX_PAGE_SIZE));
+
+                        JsonWriter& json = responseWriter();
+                        json.beginObject().field("collection", collection).key("floorPrice");
+                        if (floor) {
+                            json.value(*floor);
+                        } else {
+                            json.null();
+                        }
+                        json.key("cheapest").beginArray();
+                        for (const auto& entry : cheapest) {
+                            json.beginObject()
+                                .field("tokenId", entry.tokenId.toString())
+                                .field("price", entry.price)
+                                .endObject();
+                        }
+                        json.endArray().endObject();
+                        return jsonResponse(200, json);
+                    } catch (const std::exception& e) {
+                        return crow::response(400, e.what());
+                    }
+                });
+
+            // Live listings, one page at a time: ?collection=&min=&max=&sort=&limit=&cursor=
+            // sort is price_asc (default), price_desc, newest or oldest. Newest and oldest with min or max
+            // may return short or empty pages before the last; keep following nextCursor until it is null
+            CROW_ROUTE(app, "/api/marketplace/listings").methods("GET"_method)
+                ([](const crow::request& req) {
+                    try {
+                        const char* collection = req.url_params.get("collection");
+                        const char* min = req.url_params.get("min");
+                        const char* max = req.url_params.get("max");
+                        const char* sortName = req.url_params.get("sort");
+                        const char* cursor = req.url_params.get("cursor");
+
+                        ListingSort sort = ListingSort::PRICE_ASC;
+                        std::string_view sortText = sortName ? sortName : "price_asc";
+                        if (sortText == "price_desc") {
+                            sort = ListingSort::PRICE_DESC;
+                        } else if (sortText == "newest") {
+                            sort = ListingSort::NEWEST;
+                        } else if (sortText == "oldest") {
+                            sort = ListingSort::OLDEST;
+                        } else if (sortText != "price_asc") {
+                            return crow::response(400, "sort must be price_asc, price_desc, newest or oldest");
+                        }
+
+                        std::optional<OrderBookEntry> after;
+                        if (cursor) {
+                            after = decodeListingCursor(cursor, sort);
+                            if (!after) {
+                                return crow::response(400, "Invalid cursor");
+                            }
+                        }
+
+                        ListingPage page = Marketplace::getInstance()->getListingsPage(
+                            collection ? collection : "",
+                            min ? std::stod(min) : 0.0,
+                            max ? std::stod(max) : ListingColumns::ANY_PRICE,
+                            sort, after, pageLimit(req));
+
+                        JsonWriter& json = responseWriter();
+                        json.beginObject().key("items").beginArray();
+                        for (const auto& nft : page.items) {
+                            writeListing(json, nft);
+                        }
+                        json.endArray().key("nextCursor");
+                        if (page.next) {
+                            json.value(encodeListingCursor(sort, *page.next));
+                        } else {
+                            json.null();
+                        }
+                        json.endObject();
+                        return jsonResponse(200, json);
+                    } catch (const std::exception& e) {
+                        return crow::response(400, e.what());
+                    }
+                });
+
+            // Lists one of the caller's NFTs: {"tokenId": ..., "price": ...}
+            CROW_ROUTE(app, "/api/marketplace/listings").methods("POST"_method)
+                ([](const crow::request& req) {
+                    UserAccount* seller = sessionUser(req);
+                    if (!seller) {
+                        return crow::response(401, "Not logged in");
+                    }
+                    std::string tokenText;
+                    double price = 0.0;
+                    try {
+                        auto body = crow::json::load(req.body);
+                        if (!body || !body.has("tokenId") || !body.has("price")) {
+                            return crow::response(400, "Expected tokenId and price");
+                        }
+                        tokenText = body["tokenId"].s();
+                        price = body["price"].d();
+                    } catch (const std::exception& e) {
+                        return crow::response(400, e.what());
+                    }
+                    if (!(price > 0) || !std::isfinite(price)) {
+                        return crow::response(400, "Price must be greater than 0");
+                    }
+
+                    // Just for the status code; listNFT looks it up again under the token lock
+                    TokenId tokenId = TokenId::lookup(tokenText);
+                    bool found = false;
+                    bool alreadyListed = false;
+                    {
+                        AccountGuard account(*seller);
+                        for (const auto& collection : seller->getCollections()) {
+                            const NFT* nft = tokenId.empty() ? nullptr : collection.findNFT(tokenId);
+                            if (nft) {
+                                found = true;
+                                alreadyListed = nft->getIsListed();
+                                break;
+                            }
+                        }
+                    }
+                    if (!found) {
+                        return crow::response(404, "NFT not found in your collections");
+                    }
+                    if (alreadyListed) {
+                        return crow::response(409, "NFT is already listed for sale");
+                    }
+                    try {
+                        if (!Marketplace::getInstance()->listNFT(tokenText, price, *seller)) {
+                            return crow::response(409, "NFT could not be listed");
+                        }
+                    } catch (const PersistenceError& e) {
+                        return crow::response(500, e.what());
+                    }
+
+                    std::optional<NFT> listed = Marketplace::getInstance()->findNFTByTokenId(tokenText);
+                    if (!listed) {
+                        // Bought or taken down before we could read it back
+                        return crow::response(409, "NFT is no longer listed");
+                    }
+                    JsonWriter& json = responseWriter();
+                    writeListing(json, *listed);
+                    return jsonResponse(201, json);
+                });
+
+            // Takes one of the caller's listings down
+            CROW_ROUTE(app, "/api/marketplace/listings/<string>").methods("DELETE"_method)
+                ([](const crow::request& req, const std::string& tokenId) {
+                    UserAccount* seller = sessionUser(req);
+                    if (!seller) {
+                        return crow::response(401, "Not logged in");
+                    }
+                    std::optional<NFT> listed = Marketplace::getInstance()->findNFTByTokenId(tokenId);
+                    if (!listed) {
+                        return crow::response(404, "NFT not listed");
+                    }
+                    if (listed->ownerKey() != Pubkey::lookup(seller->getWalletAddress())) {
+                        return crow::response(403, "You can only unlist NFTs that you own");
+                    }
+                    try {
+                        Marketplace::getInstance()->unlistNFT(tokenId, *seller);
+                    } catch (const PersistenceError& e) {
+                        return crow::response(500, e.what());
+                    } catch (const std::exception& e) {
+                        return crow::response(409, e.what());
+                    }
+
+                    JsonWriter& json = responseWriter();
+                    json.beginObject().field("status", "success").field("tokenId", tokenId).endObject();
+                    return jsonResponse(200, json);
+                });
+
+            // Buys a listing for the caller; the response is the sale's transaction
+            CROW_ROUTE(app, "/api/marketplace/listings/<string>/buy").methods("POST"_method)
+                ([](const crow::request& req, const std::string& tokenId) {
+                    UserAccount* buyer = sessionUser(req);
+                    if (!buyer) {
+                        return crow::response(401, "Not logged in");
+                    }
+                    if (!Marketplace::getInstance()->findNFTByTokenId(tokenId)) {
+                        return crow::response(404, "NFT not listed");
+                    }
+                    std::optional<Transaction> tx;
+                    try {
+                        tx = Marketplace::getInstance()->buyNFT(tokenId, *buyer);
+                    } catch (const PersistenceError& e) {
+                        // Went through, but isn't on disk: not the caller's conflict
+                        return crow::response(500, e.what());
+                    } catch (const std::exception& e) {
+                        // Sold to someone else first, or the balance doesn't cover it
+                        return crow::response(409, e.what());
+                    }
+                    JsonWriter& json = responseWriter();
+                    writeTransaction(json, *tx);
+                    return jsonResponse(200, json);
+                });
+
+            // A listed NFT with its fee and total cost
+            CROW_ROUTE(app, "/api/nfts/<string>").methods("GET"_method)
+                ([](const std::string& tokenId) {
+                    std::optional<NFT> listed = Marketplace::getInstance()->findNFTByTokenId(tokenId);
+                    if (!listed) {
+                        return crow::response(404, "NFT not listed");
+                    }
+                    JsonWriter& json = responseWriter();
+                    writeListing(json, *listed);
+                    return jsonResponse(200, json);
+                });
+
+            // Every sale of the token, oldest first
+            CROW_ROUTE(app, "/api/nfts/<string>/transactions").methods("GET"_method)
+                ([](const crow::request& req, const std::string& tokenId) {
+                    try {
+                        std::optional<uint64_t> cursor;
+                        if (!transactionCursor(req, cursor)) {
+                            return crow::response(400, "Invalid cursor");
+                        }
+                        return transactionPageResponse(
+                            Marketplace::getInstance()->getProvenance(tokenId, cursor, pageLimit(req)));
+                    } catch (const std::exception& e) {
+                        return crow::response(400, e.what());
+                    }
+                });
+
+            // All sales, newest first
+            CROW_ROUTE(app, "/api/transactions").methods("GET"_method)
+                ([](const crow::request& req) {
+                    try {
+                        std::optional<uint64_t> cursor;
+                        if (!transactionCursor(req, cursor)) {
+                            return crow::response(400, "Invalid cursor");
+                        }
+                        return transactionPageResponse(
+                            Marketplace::getInstance()->getTransactions(cursor, pageLimit(req)));
+                    } catch (const std::exception& e) {
+                        return crow::response(400, e.what());
+                    }
+                });
+
+            CROW_ROUTE(app, "/api/transactions/<string>").methods("GET"_method)
+                ([](const std::string& transactionId) {
+                    std::optional<Transaction> tx = Marketplace::getInstance()->getTransaction(transactionId);
+                    if (!tx) {
+                        return crow::response(404, "Transaction not found");
+                    }
+                    JsonWriter& json = responseWriter();
+                    writeTransaction(json, *tx);
+                    return jsonResponse(200, json);
+                });
+
+            // Sales the wallet bought or sold, newest first
+            CROW_ROUTE(app, "/api/wallets/<string>/transactions").methods("GET"_method)
+                ([](const crow::request& req, const std::string& walletAddress) {
+                    try {
+                        std::optional<uint64_t> cursor;
+                        if (!transactionCursor(req, cursor)) {
+                            return crow::response(400, "Invalid cursor");
+                        }
+                        return transactionPageResponse(
+                            Marketplace::getInstance()->getWalletTransactions(walletAddress, cursor, pageLimit(req)));
+                    } catch (const std::exception& e) {
+                        return crow::response(400, e.what());
+                    }
+                });
+
+            // Verifies the password once and hands back a session token for later requests
+            CROW_ROUTE(app, "/api/login").methods("POST"_method)
+                ([](const crow::request& req) {
+                    auto body = crow::json::load(req.body);
+                    if (!body || !body.has("email") || !body.has("password")) {
+                        return crow::response(400, "Expected email and password");
+                    }
+                    std::string email = body["email"].s();
+                    std::string password = body["password"].s();
+
+                    try {
+                        UserAccount* user = UserAccount::findUserByEmail(email);
+                        if (!user || !user->checkPassword(password)) {
+                            return crow::response(401, "Invalid email or password");
+                        }
+
+                        std::string token = sessionManager().issue(user->getEmail());
+                        JsonWriter& json = responseWriter();
+                        json.beginObject()
+                            .field("status", "success")
+                            .field("token", token)
+                            .field("name", user->getName())
+                            .field("walletAddress", user->getWalletAddress())
+                            .endObject();
+                        return jsonResponse(200, json);
+                    } catch (const PasswordHasherBusy& e) {
+                        crow::response res(503, e.what());
+                        res.set_header("Retry-After", "1");
+                        return res;
+                    } catch (const std::exception& e) {
+                        return crow::response(500, e.what());
+                    }
+                });
+
+            CROW_ROUTE(app, "/api/logout").methods("POST"_method)
+                ([](const crow::request& req) {
+                    const std::string header = req.get_header_value("Authorization");
+                    const std::string prefix = "Bearer ";
+                    if (header.compare(0, prefix.size(), prefix) != 0 ||
+                        !sessionManager().revoke(std::string_view(header).substr(prefix.size()))) {
+                        return crow::response(401, "Not logged in");
+                    }
+                    JsonWriter& json = responseWriter();
+                    json.beginObject().field("status", "success").endObject();
+                    return jsonResponse(200, json);
+                });
+
+            // The account behind the request's session token
+            CROW_ROUTE(app, "/api/me").methods("GET"_method)
+                ([](const crow::request& req) {
+                    std::optional<Session> session = authenticate(req);
+                    if (!session) {
+                        return crow::response(401, "Not logged in");
+                    }
+                    UserAccount* user = UserAccount::findUserByEmail(session->email);
+                    if (!user) {
+                        return crow::response(404, "Account not found");
+                    }
+                    JsonWriter& json = responseWriter();
+                    json.beginObject()
+                        .field("status", "success")
+                        .field("name", user->getName())
+                        .field("email", user->getEmail())
+                        .field("walletAddress", user->getWalletAddress())
+                        .field("expiresAt", static_cast<int64_t>(session->expiresAt))
+                        .endObject();
+                    return jsonResponse(200, json);
+                });
+
+            // Process counters: balance cache, RPC connection reuse and password hashing
+            CROW_ROUTE(app, "/api/metrics").methods("GET"_method)
+                ([]() {
+                    BalanceCache::Stats cache = balanceCache().stats();
+                    HttpConnectionPool::Stats rpc = solanaRpc().stats();
+                    PasswordHasher::Stats hasher = passwordHasher().stats();
+
+                    JsonWriter& json = responseWriter();
+                    json.beginObject()
+                        .key("balanceCache").beginObject()
+                            .field("hits", cache.hits)
+                            .field("misses", cache.misses)
+                            .field("coalesced", cache.coalesced)
+                            .field("errors", cache.errors)
+                            .field("invalidations", cache.invalidations)
+                            .field("entries", cache.entries)
+                            .field("ttlMs", cache.ttlMs)
+                            .field("hitRate", cache.hitRate)
+                            .field("meanHitAgeMs", cache.meanHitAgeMs)
+                            .field("maxHitAgeMs", cache.maxHitAgeMs)
+                        .endObject()
+                        .key("rpc").beginObject()
+                            .field("requests", rpc.requests)
+                            .field("connectionsOpened", rpc.connectionsOpened)
+                            .field("connectionsReused", rpc.connectionsReused)
+                        .endObject()
+                        .key("passwordHasher").beginObject()
+                            .field("lanes", hasher.lanes)
+                            .field("queued", hasher.queued)
+                            .field("active", hasher.active)
+                            .field("completed", hasher.completed)
+                            .field("rejected", hasher.rejected)
+                            .field("timedOut", hasher.timedOut)
+                            .key("queueWait");
+                    writeHistogram(json, hasher.queueWait);
+                    json.key("hashTime");
+                    writeHistogram(json, hasher.hashTime);
+                    json.endObject()
+                        .key("sessions").beginObject()
+                            .field("revoked", sessionManager().revokedCount())
+                        .endObject()
+                        .field("registeredUsers", userRegistry().size())
+                        .endObject();
+                    return jsonResponse(200, json);
+                });
+
 	// Add DELETE endpoint
             CROW_ROUTE(app, "/api/account/<string>").methods("DELETE"_method)
             ([](const std::string& name) {
@@ -136,10 +753,19 @@ void startApiServer() {
                             return crow::response(500, "Failed to delete account");
                         }
 
-                        crow::json::wvalue response;
-                        response["status"] = "success";
-                        response["message"] = "Account deleted successfully";
-                        return crow::response(response);
+                        // Drop the account's records from the account store
+                        WriteBatch batch;
+                        for (const auto& key : accountStore().keysWithPrefix(dir_path + "/")) {
+                            batch.remove(key);
+                        }
+                        accountStore().commit(batch);
+
+                        JsonWriter& json = responseWriter();
+                        json.beginObject()
+                            .field("status", "success")
+                            .field("message", "Account deleted successfully")
+                            .endObject();
+                        return jsonResponse(200, json);
                     } else {
                         return crow::response(404, "Account not found");
                     }
@@ -158,19 +784,23 @@ CROW_ROUTE(app, "/api/account/<string>").methods("PUT"_method)
         std::string check_cmd = "test -f " + old_keypair_path;
         
         if (system(check_cmd.c_str()) != 0) {
-            crow::json::wvalue error_response;
-            error_response["status"] = "error";
-            error_response["message"] = "Account '" + name + "' not found";
-            return crow::response(404, error_response);
+            JsonWriter& json = responseWriter();
+            json.beginObject()
+                .field("status", "error")
+                .field("message", "Account '" + name + "' not found")
+                .endObject();
+            return jsonResponse(404, json);
         }
 
         // Parse the update request
         auto x = crow::json::load(req.body);
         if (!x.has("new_name")) {
-            crow::json::wvalue error_response;
-            error_response["status"] = "error";
-            error_response["message"] = "Missing 'new_name' in request body";
-            return crow::response(400, error_response);
+            JsonWriter& json = responseWriter();
+            json.beginObject()
+                .field("status", "error")
+                .field("message", "Missing 'new_name' in request body")
+                .endObject();
+            return jsonResponse(400, json);
         }
 
         std::string new_name = x["new_name"].s();
@@ -192,19 +822,36 @@ CROW_ROUTE(app, "/api/account/<string>").methods("PUT"_method)
         std::string rmdir_cmd = "rm -rf keypairs/" + name;
         system(rmdir_cmd.c_str());  // Don't check result as it's not critical
 
+        // Move the account's store records to the new directory name in one batch
+        std::string old_prefix = "keypairs/" + name + "/";
+        std::string new_prefix = "keypairs/" + new_name + "/";
+        WriteBatch batch;
+        for (const auto& key : accountStore().keysWithPrefix(old_prefix)) {
+            std::string value;
+            if (accountStore().get(key, value)) {
+                batch.put(new_prefix + key.substr(old_prefix.size()), value);
+                batch.remove(key);
+            }
+        }
+        accountStore().commit(batch);
+
         // Return success response
-        crow::json::wvalue response;
-        response["status"] = "success";
-        response["message"] = "Account updated successfully";
-        response["old_name"] = name;
-        response["new_name"] = new_name;
-        response["new_keypair_path"] = new_keypair_path;
-        return crow::response(response);
+        JsonWriter& json = responseWriter();
+        json.beginObject()
+            .field("status", "success")
+            .field("message", "Account updated successfully")
+            .field("old_name", name)
+            .field("new_name", new_name)
+            .field("new_keypair_path", new_keypair_path)
+            .endObject();
+        return jsonResponse(200, json);
     } catch(const std::exception& e) {
-        crow::json::wvalue error_response;
-        error_response["status"] = "error";
-        error_response["message"] = e.what();
-        return crow::response(400, error_response);
+        JsonWriter& json = responseWriter();
+        json.beginObject()
+            .field("status", "error")
+            .field("message", e.what())
+            .endObject();
+        return jsonResponse(400, json);
     }
 });
 
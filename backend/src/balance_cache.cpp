@@ -0,0 +1,117 @@
+#include "../include/balance_cache.hpp"
+#include "../include/solana_rpc.hpp"
+#include <cstdlib>
+#include <exception>
+
+BalanceCache::BalanceCache(Fetcher fetcher, std::chrono::milliseconds timeToLive)
+    : fetch(std::move(fetcher)), ttl(timeToLive) {}
+
+uint64_t BalanceCache::get(const std::string& address) {
+    std::shared_ptr<Flight> flight;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        Entry& entry = entries[address];
+        Clock::time_point now = Clock::now();
+
+        if (entry.valid && now - entry.fetchedAt < ttl) {
+            uint64_t ageMs = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(now - entry.fetchedAt).count());
+            hits++;
+            hitAgeTotalMs += ageMs;
+            if (ageMs > hitAgeMaxMs) hitAgeMaxMs = ageMs;
+            return entry.lamports;
+        }
+
+        // Someone is already asking the node for this address; share their answer
+        if (entry.flight) {
+            coalesced++;
+            std::shared_future<uint64_t> result = entry.flight->result;
+            lock.unlock();
+            return result.get();
+        }
+
+        misses++;
+        flight = std::make_shared<Flight>();
+        entry.flight = flight;
+    }
+
+    uint64_t lamports;
+    try {
+        lamports = fetch(address);
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            errors++;
+            auto it = entries.find(address);
+            if (it != entries.end() && it->second.flight == flight) {
+                entries.erase(it);
+            }
+        }
+        flight->promise.set_exception(std::current_exception());
+        throw;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // Only store if the entry wasn't invalidated while the RPC was running
+        auto it = entries.find(address);
+        if (it != entries.end() && it->second.flight == flight) {
+            it->second.lamports = lamports;
+            it->second.fetchedAt = Clock::now();
+            it->second.valid = true;
+            it->second.flight.reset();
+        }
+    }
+    flight->promise.set_value(lamports);
+    return lamports;
+}
+
+void BalanceCache::put(const std::string& address, uint64_t lamports) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Entry& entry = entries[address];
+    entry.lamports = lamports;
+    entry.fetchedAt = Clock::now();
+    entry.valid = true;
+}
+
+void BalanceCache::invalidate(const std::string& address) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // Erasing also detaches any fetch in progress, so later lookups start a new one
+    if (entries.erase(address) > 0) {
+        invalidations++;
+    }
+}
+
+void BalanceCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    invalidations += entries.size();
+    entries.clear();
+}
+
+BalanceCache::Stats BalanceCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats stats;
+    stats.hits = hits;
+    stats.misses = misses;
+    stats.coalesced = coalesced;
+    stats.errors = errors;
+    stats.invalidations = invalidations;
+    stats.entries = entries.size();
+    stats.ttlMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(ttl).count());
+    uint64_t lookups = hits + misses + coalesced;
+    stats.hitRate = lookups == 0 ? 0.0 : static_cast<double>(hits + coalesced) / lookups;
+    stats.meanHitAgeMs = hits == 0 ? 0.0 : static_cast<double>(hitAgeTotalMs) / hits;
+    stats.maxHitAgeMs = hitAgeMaxMs;
+    return stats;
+}
+
+BalanceCache& balanceCache() {
+    static BalanceCache cache(
+        [](const std::string& address) { return solanaRpc().getBalance(address); },
+        [] {
+            const char* ttl = std::getenv("BALANCE_CACHE_TTL_MS");
+            long ms = ttl && *ttl ? std::strtol(ttl, nullptr, 10) : 5000;
+            return std::chrono::milliseconds(ms < 0 ? 0 : ms);
+        }());
+    return cache;
+}
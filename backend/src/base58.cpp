@@ -0,0 +1,121 @@
+#include "../include/base58.hpp"
+#include <algorithm>
+#include <array>
+
+namespace {
+    const char ALPHABET[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+
+    // Five base58 digits per limb: 58^5 < 2^30, so limb * 2^32 + carry fits in 64 bits
+    constexpr uint64_t LIMB_BASE = 58ULL * 58 * 58 * 58 * 58;
+    constexpr int DIGITS_PER_LIMB = 5;
+
+    constexpr std::array<int8_t, 256> makeDecodeTable() {
+        std::array<int8_t, 256> table{};
+        for (auto& entry : table) entry = -1;
+        for (int i = 0; i < 58; i++) {
+            table[static_cast<unsigned char>(ALPHABET[i])] = static_cast<int8_t>(i);
+        }
+        return table;
+    }
+    constexpr std::array<int8_t, 256> DECODE = makeDecodeTable();
+}
+
+/*
+ * Instead of dividing the whole number by 58 once per output digit, the
+ * input is folded in 32 bits at a time into limbs of base 58^5, and each
+ * limb is then split into its five digits. A 32-byte key takes 8 passes
+ * over ~10 limbs rather than 44 passes over 32 bytes.
+ */
+std::string base58Encode(const uint8_t* data, size_t size) {
+    size_t zeros = 0;
+    while (zeros < size && data[zeros] == 0) zeros++;
+
+    std::vector<uint32_t> limbs;   // little-endian
+    limbs.reserve(size / 4 + 2);
+
+    auto fold = [&limbs](uint64_t word, int bits) {
+        uint64_t carry = word;
+        for (auto& limb : limbs) {
+            uint64_t acc = (static_cast<uint64_t>(limb) << bits) + carry;
+            limb = static_cast<uint32_t>(acc % LIMB_BASE);
+            carry = acc / LIMB_BASE;
+        }
+        while (carry > 0) {
+            limbs.push_back(static_cast<uint32_t>(carry % LIMB_BASE));
+            carry /= LIMB_BASE;
+        }
+    };
+
+    size_t i = zeros;
+    size_t head = (size - zeros) % 4;
+    if (head > 0) {
+        uint64_t word = 0;
+        for (size_t k = 0; k < head; k++) word = (word << 8) | data[i++];
+        fold(word, static_cast<int>(head * 8));
+    }
+    for (; i < size; i += 4) {
+        uint64_t word = (static_cast<uint64_t>(data[i]) << 24) | (static_cast<uint64_t>(data[i + 1]) << 16) |
+                        (static_cast<uint64_t>(data[i + 2]) << 8) | data[i + 3];
+        fold(word, 32);
+    }
+
+    // Digits come out least significant first
+    std::string out;
+    out.reserve(zeros + limbs.size() * DIGITS_PER_LIMB);
+    for (uint32_t limb : limbs) {
+        for (int d = 0; d < DIGITS_PER_LIMB; d++) {
+            out.push_back(ALPHABET[limb % 58]);
+            limb /= 58;
+        }
+    }
+    while (!out.empty() && out.back() == ALPHABET[0]) out.pop_back();
+    out.append(zeros, ALPHABET[0]);
+    std::reverse(out.begin(), out.end());
+    return out;
+}
+
+bool base58Decode(std::string_view text, std::vector<uint8_t>& out) {
+    out.clear();
+    size_t ones = 0;
+    while (ones < text.size() && text[ones] == ALPHABET[0]) ones++;
+
+    std::vector<uint32_t> words;   // little-endian base 2^32
+
+    auto fold = [&words](uint64_t multiplier, uint64_t value) {
+        uint64_t carry = value;
+        for (auto& word : words) {
+            uint64_t acc = static_cast<uint64_t>(word) * multiplier + carry;
+            word = static_cast<uint32_t>(acc);
+            carry = acc >> 32;
+        }
+        while (carry > 0) {
+            words.push_back(static_cast<uint32_t>(carry));
+            carry >>= 32;
+        }
+    };
+
+    // Up to five digits at a time, mirroring the encoder's limbs
+    size_t i = ones;
+    while (i < text.size()) {
+        uint64_t multiplier = 1;
+        uint64_t value = 0;
+        for (int d = 0; d < DIGITS_PER_LIMB && i < text.size(); d++, i++) {
+            int digit = DECODE[static_cast<unsigned char>(text[i])];
+            if (digit < 0) return false;
+            value = value * 58 + static_cast<uint64_t>(digit);
+            multiplier *= 58;
+        }
+        fold(multiplier, value);
+    }
+
+    out.assign(ones, 0);
+    size_t start = out.size();
+    for (uint32_t word : words) {
+        for (int b = 0; b < 4; b++) {
+            out.push_back(static_cast<uint8_t>(word >> (8 * b)));
+        }
+    }
+    while (out.size() > start && out.back() == 0) out.pop_back();
+    std::reverse(out.begin() + static_cast<std::ptrdiff_t>(start), out.end());
+    return true;
+}
@@ -19,12 +19,50 @@ void Collection::displayCollection() const {
 	}
 }
 
+void Collection::addNFT(const NFT& nft) {
+	size_t slot = slots.find(nft.id());
+	if (slot == FlatHashIndex<TokenId>::npos) {
+		slot = nfts.size();
+		nfts.push_back(nft);
+		slots.insert(nft.id(), slot);
+	} else {
+		nfts[slot] = nft;
+	}
+	nfts[slot].setCollection(name);
+}
+
+bool Collection::removeNFT(TokenId tokenId) {
+	size_t slot = slots.find(tokenId);
+	if (slot == FlatHashIndex<TokenId>::npos) {
+		return false;
+	}
+	slots.erase(tokenId);
+	size_t last = nfts.size() - 1;
+	if (slot != last) {
+		nfts[slot] = std::move(nfts[last]);
+		slots.insert(nfts[slot].id(), slot);
+	}
+	nfts.pop_back();
+	return true;
+}
+
+NFT* Collection::findNFT(TokenId tokenId) {
+	size_t slot = slots.find(tokenId);
+	return slot == FlatHashIndex<TokenId>::npos ? nullptr : &nfts[slot];
+}
+
+const NFT* Collection::findNFT(TokenId tokenId) const {
+	size_t slot = slots.find(tokenId);
+	return slot == FlatHashIndex<TokenId>::npos ? nullptr : &nfts[slot];
+}
+
 void UserAccount::viewAllCollections() {
     if (!currentUser) {
         std::cout << "Please login first\n" << std::endl;
         return;
     }
 
+    AccountGuard account(*currentUser);
     if (currentUser->collections.empty()) {
         std::cout << "\nNo collections found. Create a collection first!\n" << std::endl;
         return;
@@ -51,3 +89,30 @@ void UserAccount::viewAllCollections() {
         std::cout << std::endl;
     }
 }
+
+void Collection::addToSnapshot(SnapshotBuilder& builder) const {
+	SnapshotCollection record{};
+	record.name = builder.intern(name);
+	record.creator = builder.intern(creator);
+	record.firstNFT = builder.nftCount();
+	for (const auto& nft : nfts) {
+		builder.addNFT(nft.toSnapshot(builder));
+	}
+	record.nftCount = builder.nftCount() - record.firstNFT;
+	builder.addCollection(record);
+}
+
+Collection Collection::fromSnapshot(const SnapshotImage& image, const SnapshotCollection& record) {
+	Collection collection(image.text(record.name), image.text(record.creator));
+	SnapshotRange<SnapshotNFT> records = image.nfts().slice(record.firstNFT, record.nftCount);
+	collection.nfts.reserve(records.size());
+	collection.slots.reserve(records.size());
+	for (const auto& nftRecord : records) {
+		// Kept as stored, so no addNFT(): the NFT already carries its collection
+		NFT nft = NFT::fromSnapshot(image, nftRecord);
+		if (collection.slots.insert(nft.id(), collection.nfts.size())) {
+			collection.nfts.push_back(std::move(nft));
+		}
+	}
+	return collection;
+}
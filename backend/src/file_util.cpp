@@ -0,0 +1,59 @@
+#include "../include/file_util.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+
+void writeFileAtomic(const std::string& path, const std::string& contents, unsigned int mode) {
+    std::string tmpPath = path + ".tmp";
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, static_cast<mode_t>(mode));
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open " + tmpPath + ": " + std::strerror(errno));
+    }
+
+    size_t written = 0;
+    while (written < contents.size()) {
+        ssize_t n = ::write(fd, contents.data() + written, contents.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            int err = errno;
+            ::close(fd);
+            throw std::runtime_error("Cannot write " + tmpPath + ": " + std::strerror(err));
+        }
+        written += static_cast<size_t>(n);
+    }
+
+    if (::fsync(fd) != 0) {
+        int err = errno;
+        ::close(fd);
+        throw std::runtime_error("Cannot sync " + tmpPath + ": " + std::strerror(err));
+    }
+    ::close(fd);
+
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Cannot replace " + path + ": " + std::strerror(errno));
+    }
+
+    // Make the rename itself durable
+    syncParentDirectory(path);
+}
+
+void syncParentDirectory(const std::string& path) {
+    std::string dir = ".";
+    size_t slash = path.find_last_of('/');
+    if (slash != std::string::npos) {
+        dir = path.substr(0, slash);
+    }
+    int dirFd = ::open(dir.c_str(), O_RDONLY);
+    if (dirFd < 0) {
+        throw std::runtime_error("Cannot open " + dir + ": " + std::strerror(errno));
+    }
+    if (::fsync(dirFd) != 0) {
+        int err = errno;
+        ::close(dirFd);
+        throw std::runtime_error("Cannot sync " + dir + ": " + std::strerror(err));
+    }
+    ::close(dirFd);
+}
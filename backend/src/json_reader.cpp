@@ -0,0 +1,257 @@
+#include "../include/json_reader.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+void JsonReader::fail(const char* message) const {
+    throw std::runtime_error("JSON parse error at offset " + std::to_string(pos) + ": " + message);
+}
+
+void JsonReader::skipWhitespace() {
+    while (pos < text.size()) {
+        char c = text[pos];
+        if (c != ' ' && c != '\n' && c != '\r' && c != '\t') break;
+        pos++;
+    }
+}
+
+void JsonReader::expect(char c) {
+    skipWhitespace();
+    if (pos >= text.size() || text[pos] != c) {
+        fail(pos >= text.size() ? "unexpected end of input" : "unexpected character");
+    }
+    pos++;
+}
+
+void JsonReader::expectLiteral(std::string_view literal) {
+    if (text.substr(pos, literal.size()) != literal) {
+        fail("invalid literal");
+    }
+    pos += literal.size();
+}
+
+void JsonReader::parse(JsonHandler& handler) {
+    pos = 0;
+    parseValue(handler, 0);
+    skipWhitespace();
+    if (pos != text.size()) {
+        fail("trailing characters after document");
+    }
+}
+
+void JsonReader::parseValue(JsonHandler& handler, int depth) {
+    skipWhitespace();
+    if (pos >= text.size()) {
+        fail("unexpected end of input");
+    }
+    switch (text[pos]) {
+        case '{': parseObject(handler, depth + 1); break;
+        case '[': parseArray(handler, depth + 1); break;
+        case '"': handler.string(parseString()); break;
+        case 't': expectLiteral("true"); handler.boolean(true); break;
+        case 'f': expectLiteral("false"); handler.boolean(false); break;
+        case 'n': expectLiteral("null"); handler.null(); break;
+        default: handler.number(parseNumber()); break;
+    }
+}
+
+void JsonReader::parseObject(JsonHandler& handler, int depth) {
+    if (depth > MAX_DEPTH) fail("nesting too deep");
+    pos++; // '{'
+    handler.startObject();
+    skipWhitespace();
+    if (pos < text.size() && text[pos] == '}') {
+        pos++;
+        handler.endObject();
+        return;
+    }
+    while (true) {
+        skipWhitespace();
+        if (pos >= text.size() || text[pos] != '"') fail("expected object key");
+        handler.key(parseString());
+        expect(':');
+        parseValue(handler, depth);
+        skipWhitespace();
+        if (pos < text.size() && text[pos] == ',') {
+            pos++;
+            continue;
+        }
+        expect('}');
+        break;
+    }
+    handler.endObject();
+}
+
+void JsonReader::parseArray(JsonHandler& handler, int depth) {
+    if (depth > MAX_DEPTH) fail("nesting too deep");
+    pos++; // '['
+    handler.startArray();
+    skipWhitespace();
+    if (pos < text.size() && text[pos] == ']') {
+        pos++;
+        handler.endArray();
+        return;
+    }
+    while (true) {
+        parseValue(handler, depth);
+        skipWhitespace();
+        if (pos < text.size() && text[pos] == ',') {
+            pos++;
+            continue;
+        }
+        expect(']');
+        break;
+    }
+    handler.endArray();
+}
+
+// Returns a view of the input when the string has no escapes, else of scratch
+std::string_view JsonReader::parseString() {
+    pos++; // opening quote
+    size_t start = pos;
+    while (pos < text.size() && text[pos] != '"' && text[pos] != '\\') {
+        pos++;
+    }
+    if (pos >= text.size()) fail("unterminated string");
+    if (text[pos] == '"') {
+        return text.substr(start, pos++ - start);
+    }
+
+    scratch.assign(text.data() + start, pos - start);
+    while (pos < text.size() && text[pos] != '"') {
+        if (text[pos] == '\\') {
+            decodeEscape();
+        } else {
+            scratch.push_back(text[pos++]);
+        }
+    }
+    if (pos >= text.size()) fail("unterminated string");
+    pos++;
+    return scratch;
+}
+
+void JsonReader::decodeEscape() {
+    pos++; // backslash
+    if (pos >= text.size()) fail("unterminated escape");
+    char c = text[pos++];
+    switch (c) {
+        case '"': scratch.push_back('"'); return;
+        case '\\': scratch.push_back('\\'); return;
+        case '/': scratch.push_back('/'); return;
+        case 'b': scratch.push_back('\b'); return;
+        case 'f': scratch.push_back('\f'); return;
+        case 'n': scratch.push_back('\n'); return;
+        case 'r': scratch.push_back('\r'); return;
+        case 't': scratch.push_back('\t'); return;
+        case 'u': break;
+        default: fail("invalid escape");
+    }
+
+    auto hex4 = [this]() {
+        if (text.size() - pos < 4) fail("truncated \\u escape");
+        uint32_t value = 0;
+        for (int i = 0; i < 4; i++) {
+            char h = text[pos++];
+            value <<= 4;
+            if (h >= '0' && h <= '9') value |= static_cast<uint32_t>(h - '0');
+            else if (h >= 'a' && h <= 'f') value |= static_cast<uint32_t>(h - 'a' + 10);
+            else if (h >= 'A' && h <= 'F') value |= static_cast<uint32_t>(h - 'A' + 10);
+            else fail("invalid \\u escape");
+        }
+        return value;
+    };
+
+    uint32_t code = hex4();
+    if (code >= 0xD800 && code <= 0xDBFF) {
+        // High surrogate; the low half must follow
+        if (text.substr(pos, 2) != "\\u") fail("unpaired surrogate");
+        pos += 2;
+        uint32_t low = hex4();
+        if (low < 0xDC00 || low > 0xDFFF) fail("unpaired surrogate");
+        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+    }
+
+    // UTF-8 encode
+    if (code < 0x80) {
+        scratch.push_back(static_cast<char>(code));
+    } else if (code < 0x800) {
+        scratch.push_back(static_cast<char>(0xC0 | (code >> 6)));
+        scratch.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    } else if (code < 0x10000) {
+        scratch.push_back(static_cast<char>(0xE0 | (code >> 12)));
+        scratch.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+        scratch.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    } else {
+        scratch.push_back(static_cast<char>(0xF0 | (code >> 18)));
+        scratch.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+        scratch.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+        scratch.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    }
+}
+
+double JsonReader::parseNumber() {
+    size_t start = pos;
+    auto digits = [this]() {
+        size_t first = pos;
+        while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') pos++;
+        return pos - first;
+    };
+
+    if (pos < text.size() && text[pos] == '-') pos++;
+    if (digits() == 0) fail("invalid number");
+    if (pos < text.size() && text[pos] == '.') {
+        pos++;
+        if (digits() == 0) fail("invalid number");
+    }
+    if (pos < text.size() && (text[pos] == 'e' || text[pos] == 'E')) {
+        pos++;
+        if (pos < text.size() && (text[pos] == '+' || text[pos] == '-')) pos++;
+        if (digits() == 0) fail("invalid number");
+    }
+
+    // strtod needs a terminator, and the input view may end right here
+    char buffer[64];
+    size_t length = pos - start;
+    if (length < sizeof(buffer)) {
+        text.copy(buffer, length, start);
+        buffer[length] = '\0';
+        return std::strtod(buffer, nullptr);
+    }
+    return std::strtod(std::string(text.substr(start, length)).c_str(), nullptr);
+}
+
+bool parseJsonFile(const std::string& path, JsonHandler& handler) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    size_t length = static_cast<size_t>(st.st_size);
+    if (length == 0) {
+        ::close(fd);
+        return true; // nothing saved yet
+    }
+    void* mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+
+    try {
+        JsonReader(std::string_view(static_cast<const char*>(mapped), length)).parse(handler);
+    } catch (...) {
+        ::munmap(mapped, length);
+        throw;
+    }
+    ::munmap(mapped, length);
+    return true;
+}
@@ -0,0 +1,149 @@
+#include "../include/json_writer.hpp"
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+JsonWriter::JsonWriter(bool prettyPrint, size_t initialCapacity) : pretty(prettyPrint) {
+    buffer.reserve(initialCapacity);
+    hasValue.reserve(16);
+}
+
+void JsonWriter::clear() {
+    buffer.clear();
+    hasValue.clear();
+    afterKey = false;
+}
+
+void JsonWriter::newline() {
+    buffer.push_back('\n');
+    buffer.append(hasValue.size() * 2, ' ');
+}
+
+// Separator and indentation owed before the next key or array element
+void JsonWriter::beforeValue() {
+    if (afterKey) {
+        afterKey = false;
+        return;
+    }
+    if (hasValue.empty()) return;
+    if (hasValue.back()) {
+        buffer.push_back(',');
+    }
+    hasValue.back() = true;
+    if (pretty) newline();
+}
+
+void JsonWriter::open(char bracket) {
+    beforeValue();
+    buffer.push_back(bracket);
+    hasValue.push_back(false);
+}
+
+void JsonWriter::close(char bracket) {
+    bool empty = hasValue.empty() || !hasValue.back();
+    if (!hasValue.empty()) hasValue.pop_back();
+    if (pretty && !empty) newline();
+    buffer.push_back(bracket);
+}
+
+JsonWriter& JsonWriter::key(std::string_view name) {
+    beforeValue();
+    buffer.push_back('"');
+    appendEscaped(name);
+    buffer.append(pretty ? "\": " : "\":");
+    afterKey = true;
+    return *this;
+}
+
+void JsonWriter::appendEscaped(std::string_view text) {
+    static const char HEX[] = "0123456789abcdef";
+    size_t runStart = 0;
+    for (size_t i = 0; i < text.size(); i++) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+        // Copy the plain run in one go, then the escape
+        buffer.append(text.data() + runStart, i - runStart);
+        runStart = i + 1;
+        switch (c) {
+            case '"': buffer.append("\\\""); break;
+            case '\\': buffer.append("\\\\"); break;
+            case '\n': buffer.append("\\n"); break;
+            case '\r': buffer.append("\\r"); break;
+            case '\t': buffer.append("\\t"); break;
+            case '\b': buffer.append("\\b"); break;
+            case '\f': buffer.append("\\f"); break;
+            default: {
+                char escape[6] = {'\\', 'u', '0', '0', HEX[c >> 4], HEX[c & 0xF]};
+                buffer.append(escape, sizeof(escape));
+                break;
+            }
+        }
+    }
+    buffer.append(text.data() + runStart, text.size() - runStart);
+}
+
+JsonWriter& JsonWriter::value(std::string_view text) {
+    beforeValue();
+    buffer.push_back('"');
+    appendEscaped(text);
+    buffer.push_back('"');
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(double number) {
+    beforeValue();
+    if (!std::isfinite(number)) {
+        buffer.append("null"); // JSON has no NaN or infinity
+    } else {
+        appendShortestDouble(buffer, number);
+    }
+    return *this;
+}
+
+JsonWriter& JsonWriter::integer(int64_t number) {
+    beforeValue();
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    buffer.append(digits, static_cast<size_t>(result.ptr - digits));
+    return *this;
+}
+
+JsonWriter& JsonWriter::unsignedInteger(uint64_t number) {
+    beforeValue();
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    buffer.append(digits, static_cast<size_t>(result.ptr - digits));
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool flag) {
+    beforeValue();
+    buffer.append(flag ? "true" : "false");
+    return *this;
+}
+
+JsonWriter& JsonWriter::null() {
+    beforeValue();
+    buffer.append("null");
+    return *this;
+}
+
+void appendShortestDouble(std::string& out, double value) {
+    char digits[32];
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, static_cast<size_t>(result.ptr - digits));
+#else
+    // Standard libraries without floating-point to_chars: take the
+    // shortest %.*g that parses back to the same value
+    for (int precision = 1; precision <= 17; precision++) {
+        int length = std::snprintf(digits, sizeof(digits), "%.*g", precision, value);
+        if (std::strtod(digits, nullptr) == value || precision == 17) {
+            out.append(digits, static_cast<size_t>(length));
+            return;
+        }
+    }
+#endif
+}
@@ -0,0 +1,263 @@
+#include "../include/kv_store.hpp"
+#include "../include/byte_buffer.hpp"
+#include "../include/crc32.hpp"
+#include "../include/file_util.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+    const char STORE_MAGIC[8] = {'N', 'F', 'T', 'K', 'V', '0', '0', '1'};
+    const size_t FRAME_HEADER = 8;
+    const uint64_t MIN_COMPACT_BYTES = 1 << 20;
+
+    void writeAll(int fd, const std::string& data) {
+        size_t written = 0;
+        while (written < data.size()) {
+            ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error("Store write failed: " + std::string(std::strerror(errno)));
+            }
+            written += static_cast<size_t>(n);
+        }
+    }
+
+    std::string frame(const std::string& payload) {
+        ByteWriter out;
+        out.putU32(static_cast<uint32_t>(payload.size()));
+        out.putU32(crc32(payload.data(), payload.size()));
+        out.putBytes(payload.data(), payload.size());
+        return out.str();
+    }
+
+    uint64_t entryBytes(const std::string& key, const std::string& value) {
+        return 9 + key.size() + value.size();
+    }
+}
+
+LogStructuredStore::LogStructuredStore(const std::string& storePath) : path(storePath) {
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent);
+    }
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open store " + path + ": " + std::strerror(errno));
+    }
+    load();
+}
+
+LogStructuredStore::~LogStructuredStore() {
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+void LogStructuredStore::load() {
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        throw std::runtime_error("Cannot stat store " + path);
+    }
+    if (st.st_size == 0) {
+        writeAll(fd, std::string(STORE_MAGIC, sizeof(STORE_MAGIC)));
+        ::fsync(fd);
+        fileBytes = sizeof(STORE_MAGIC);
+        return;
+    }
+
+    std::vector<unsigned char> contents(static_cast<size_t>(st.st_size));
+    if (::pread(fd, contents.data(), contents.size(), 0) != static_cast<ssize_t>(contents.size())) {
+        throw std::runtime_error("Cannot read store " + path);
+    }
+    if (contents.size() < sizeof(STORE_MAGIC) ||
+        std::memcmp(contents.data(), STORE_MAGIC, sizeof(STORE_MAGIC)) != 0) {
+        throw std::runtime_error("Not an account store: " + path);
+    }
+
+    size_t offset = sizeof(STORE_MAGIC);
+    while (offset + FRAME_HEADER <= contents.size()) {
+        ByteReader header(&contents[offset], FRAME_HEADER);
+        uint32_t length = header.getU32();
+        uint32_t checksum = header.getU32();
+        if (offset + FRAME_HEADER + length > contents.size()) break;
+        const unsigned char* payload = &contents[offset + FRAME_HEADER];
+        if (crc32(payload, length) != checksum) break;
+
+        ByteReader reader(payload, length);
+        uint32_t count = reader.getU32();
+        for (uint32_t i = 0; i < count && reader.ok(); i++) {
+            bool remove = reader.getBool();
+            std::string key = reader.getString();
+            std::string value = reader.getString();
+            if (!reader.ok()) break;
+            auto it = data.find(key);
+            if (it != data.end()) {
+                liveBytes -= entryBytes(it->first, it->second);
+            }
+            if (remove) {
+                if (it != data.end()) data.erase(it);
+            } else {
+                liveBytes += entryBytes(key, value);
+                data[key] = std::move(value);
+            }
+        }
+        offset += FRAME_HEADER + length;
+    }
+
+    // Drop a batch that was only partly written when the process died
+    if (offset != contents.size()) {
+        if (::ftruncate(fd, static_cast<off_t>(offset)) != 0) {
+            throw std::runtime_error("Cannot truncate store tail: " + path);
+        }
+        ::fsync(fd);
+    }
+    fileBytes = offset;
+    ::lseek(fd, 0, SEEK_END);
+}
+
+void LogStructuredStore::appendFrame(const std::string& payload) {
+    std::string bytes = frame(payload);
+    try {
+        writeAll(fd, bytes);
+        if (::fsync(fd) != 0) {
+            throw std::runtime_error("Store fsync failed: " + std::string(std::strerror(errno)));
+        }
+        // This frame is only as durable as the file holding it
+        if (renameUnsynced) {
+            syncParentDirectory(path);
+            renameUnsynced = false;
+        }
+    } catch (...) {
+        // Cut off a partial frame so later commits stay readable
+        if (::ftruncate(fd, static_cast<off_t>(fileBytes)) == 0) {
+            ::lseek(fd, 0, SEEK_END);
+        }
+        throw;
+    }
+    fileBytes += bytes.size();
+}
+
+bool LogStructuredStore::get(const std::string& key, std::string& value) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = data.find(key);
+    if (it == data.end()) {
+        return false;
+    }
+    value = it->second;
+    return true;
+}
+
+V<std::string> LogStructuredStore::keysWithPrefix(const std::string& prefix) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    V<std::string> keys;
+    for (auto it = data.lower_bound(prefix); it != data.end(); ++it) {
+        if (it->first.compare(0, prefix.size(), prefix) != 0) break;
+        keys.push_back(it->first);
+    }
+    return keys;
+}
+
+void LogStructuredStore::commit(const WriteBatch& batch) {
+    if (batch.empty()) return;
+
+    ByteWriter payload;
+    payload.putU32(static_cast<uint32_t>(batch.operations().size()));
+    for (const auto& op : batch.operations()) {
+        payload.putBool(op.remove);
+        payload.putString(op.key);
+        payload.putString(op.value);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    appendFrame(payload.str());
+
+    // Only touch memory once the frame is durable
+    for (const auto& op : batch.operations()) {
+        auto it = data.find(op.key);
+        if (it != data.end()) {
+            liveBytes -= entryBytes(it->first, it->second);
+        }
+        if (op.remove) {
+            if (it != data.end()) data.erase(it);
+        } else {
+            liveBytes += entryBytes(op.key, op.value);
+            data[op.key] = op.value;
+        }
+    }
+
+    if (fileBytes > MIN_COMPACT_BYTES && fileBytes > 2 * liveBytes) {
+        // The batch is already durable; a failed compaction only leaves the log long
+        try {
+            compactLocked();
+        } catch (const std::exception& e) {
+            std::cerr << "Store compaction failed: " << e.what() << std::endl;
+        }
+    }
+}
+
+size_t LogStructuredStore::keyCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return data.size();
+}
+
+void LogStructuredStore::compact() {
+    std::lock_guard<std::mutex> lock(mutex);
+    compactLocked();
+}
+
+void LogStructuredStore::compactLocked() {
+    ByteWriter payload;
+    payload.putU32(static_cast<uint32_t>(data.size()));
+    for (const auto& entry : data) {
+        payload.putBool(false);
+        payload.putString(entry.first);
+        payload.putString(entry.second);
+    }
+
+    std::string tmpPath = path + ".compact";
+    int tmpFd = ::open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (tmpFd < 0) {
+        throw std::runtime_error("Cannot create " + tmpPath + ": " + std::strerror(errno));
+    }
+    std::string bytes = std::string(STORE_MAGIC, sizeof(STORE_MAGIC)) + frame(payload.str());
+    try {
+        writeAll(tmpFd, bytes);
+        if (::fsync(tmpFd) != 0) {
+            throw std::runtime_error("Cannot sync " + tmpPath);
+        }
+    } catch (...) {
+        ::close(tmpFd);
+        std::remove(tmpPath.c_str());
+        throw;
+    }
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        int err = errno;
+        ::close(tmpFd);
+        std::remove(tmpPath.c_str());
+        throw std::runtime_error("Cannot replace " + path + ": " + std::strerror(err));
+    }
+
+    ::close(fd);
+    fd = tmpFd;
+    fileBytes = bytes.size();
+    ::lseek(fd, 0, SEEK_END);
+
+    // Until the directory is synced a crash could bring back the old file, and
+    // with it lose every commit appended to the new one
+    renameUnsynced = true;
+    syncParentDirectory(path);
+    renameUnsynced = false;
+}
+
+KeyValueStore& accountStore() {
+    static LogStructuredStore store("data/accounts.db");
+    return store;
+}
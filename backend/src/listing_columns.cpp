@@ -0,0 +1,160 @@
+#include "../include/listing_columns.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace {
+    constexpr double INF = std::numeric_limits<double>::infinity();
+
+    void addScalar(ListingStats& stats, double price) {
+        stats.count++;
+        stats.totalPrice += price;
+        if (price < stats.minPrice) stats.minPrice = price;
+    }
+
+    // Count, sum and minimum of the prices in [lo, hi], over the slots whose
+    // key is `key` when KEYED. Four prices per iteration in two vectors.
+    template<bool KEYED>
+    ListingStats scanStats(const double* prices, const uint32_t* keys, uint32_t key, size_t n, double lo, double hi) {
+        ListingStats stats;
+        size_t i = 0;
+#if defined(__SSE2__)
+        const __m128d vlo = _mm_set1_pd(lo), vhi = _mm_set1_pd(hi), vinf = _mm_set1_pd(INF);
+        const __m128i vkey = _mm_set1_epi32(static_cast<int>(key));
+        __m128d sum0 = _mm_setzero_pd(), sum1 = _mm_setzero_pd();
+        __m128d min0 = vinf, min1 = vinf;
+        __m128i count0 = _mm_setzero_si128(), count1 = _mm_setzero_si128();
+        for (; i + 4 <= n; i += 4) {
+            __m128d p0 = _mm_loadu_pd(prices + i);
+            __m128d p1 = _mm_loadu_pd(prices + i + 2);
+            __m128d m0 = _mm_and_pd(_mm_cmpge_pd(p0, vlo), _mm_cmple_pd(p0, vhi));
+            __m128d m1 = _mm_and_pd(_mm_cmpge_pd(p1, vlo), _mm_cmple_pd(p1, vhi));
+            if (KEYED) {
+                // 32-bit key matches widened to the 64-bit price lanes
+                __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i)), vkey);
+                m0 = _mm_and_pd(m0, _mm_castsi128_pd(_mm_unpacklo_epi32(eq, eq)));
+                m1 = _mm_and_pd(m1, _mm_castsi128_pd(_mm_unpackhi_epi32(eq, eq)));
+            }
+            sum0 = _mm_add_pd(sum0, _mm_and_pd(m0, p0));
+            sum1 = _mm_add_pd(sum1, _mm_and_pd(m1, p1));
+            min0 = _mm_min_pd(min0, _mm_or_pd(_mm_and_pd(m0, p0), _mm_andnot_pd(m0, vinf)));
+            min1 = _mm_min_pd(min1, _mm_or_pd(_mm_and_pd(m1, p1), _mm_andnot_pd(m1, vinf)));
+            // A matching lane is all ones, i.e. -1
+            count0 = _mm_sub_epi64(count0, _mm_castpd_si128(m0));
+            count1 = _mm_sub_epi64(count1, _mm_castpd_si128(m1));
+        }
+        double sums[2], mins[2];
+        uint64_t counts[2];
+        _mm_storeu_pd(sums, _mm_add_pd(sum0, sum1));
+        _mm_storeu_pd(mins, _mm_min_pd(min0, min1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(counts), _mm_add_epi64(count0, count1));
+        stats.count = counts[0] + counts[1];
+        stats.totalPrice = sums[0] + sums[1];
+        stats.minPrice = mins[0] < mins[1] ? mins[0] : mins[1];
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+        const float64x2_t vlo = vdupq_n_f64(lo), vhi = vdupq_n_f64(hi), vinf = vdupq_n_f64(INF);
+        const uint32x4_t vkey = vdupq_n_u32(key);
+        float64x2_t sum0 = vdupq_n_f64(0.0), sum1 = vdupq_n_f64(0.0);
+        float64x2_t min0 = vinf, min1 = vinf;
+        int64x2_t count0 = vdupq_n_s64(0), count1 = vdupq_n_s64(0);
+        for (; i + 4 <= n; i += 4) {
+            float64x2_t p0 = vld1q_f64(prices + i);
+            float64x2_t p1 = vld1q_f64(prices + i + 2);
+            uint64x2_t m0 = vandq_u64(vcgeq_f64(p0, vlo), vcleq_f64(p0, vhi));
+            uint64x2_t m1 = vandq_u64(vcgeq_f64(p1, vlo), vcleq_f64(p1, vhi));
+            if (KEYED) {
+                // Sign extension widens each all-ones 32-bit match to 64 bits
+                int32x4_t eq = vreinterpretq_s32_u32(vceqq_u32(vld1q_u32(keys + i), vkey));
+                m0 = vandq_u64(m0, vreinterpretq_u64_s64(vmovl_s32(vget_low_s32(eq))));
+                m1 = vandq_u64(m1, vreinterpretq_u64_s64(vmovl_s32(vget_high_s32(eq))));
+            }
+            sum0 = vaddq_f64(sum0, vreinterpretq_f64_u64(vandq_u64(m0, vreinterpretq_u64_f64(p0))));
+            sum1 = vaddq_f64(sum1, vreinterpretq_f64_u64(vandq_u64(m1, vreinterpretq_u64_f64(p1))));
+            min0 = vminq_f64(min0, vbslq_f64(m0, p0, vinf));
+            min1 = vminq_f64(min1, vbslq_f64(m1, p1, vinf));
+            count0 = vsubq_s64(count0, vreinterpretq_s64_u64(m0));
+            count1 = vsubq_s64(count1, vreinterpretq_s64_u64(m1));
+        }
+        stats.count = static_cast<size_t>(vaddvq_s64(vaddq_s64(count0, count1)));
+        stats.totalPrice = vaddvq_f64(vaddq_f64(sum0, sum1));
+        stats.minPrice = vminvq_f64(vminq_f64(min0, min1));
+#endif
+        for (; i < n; i++) {
+            if (prices[i] >= lo && prices[i] <= hi && (!KEYED || keys[i] == key)) {
+                addScalar(stats, prices[i]);
+            }
+        }
+        return stats;
+    }
+}
+
+uint32_t ListingColumns::number(std::unordered_map<Pubkey, uint32_t>& numbers, const Pubkey& key) {
+    return numbers.emplace(key, static_cast<uint32_t>(numbers.size())).first->second;
+}
+
+uint32_t ListingColumns::number(std::unordered_map<std::string, uint32_t>& numbers, const std::string& key) {
+    return numbers.emplace(key, static_cast<uint32_t>(numbers.size())).first->second;
+}
+
+void ListingColumns::append(TokenId tokenId, double price, const Pubkey& owner, const std::string& collection, uint64_t listedSeq) {
+    prices.push_back(price);
+    tokenIds.push_back(tokenId.raw());
+    ownerIds.push_back(number(ownerNumbers, owner));
+    collectionIds.push_back(number(collectionNumbers, collection));
+    listedSeqs.push_back(listedSeq);
+}
+
+void ListingColumns::removeAt(size_t slot) {
+    size_t last = prices.size() - 1;
+    if (slot != last) {
+        prices[slot] = prices[last];
+        tokenIds[slot] = tokenIds[last];
+        ownerIds[slot] = ownerIds[last];
+        collectionIds[slot] = collectionIds[last];
+        listedSeqs[slot] = listedSeqs[last];
+    }
+    prices.pop_back();
+    tokenIds.pop_back();
+    ownerIds.pop_back();
+    collectionIds.pop_back();
+    listedSeqs.pop_back();
+}
+
+void ListingColumns::reserve(size_t n) {
+    prices.reserve(n);
+    tokenIds.reserve(n);
+    ownerIds.reserve(n);
+    collectionIds.reserve(n);
+    listedSeqs.reserve(n);
+}
+
+TokenId ListingColumns::tokenId(size_t slot) const {
+    return TokenId::fromRaw(tokenIds[slot]);
+}
+
+uint32_t ListingColumns::ownerKey(const Pubkey& owner) const {
+    auto found = ownerNumbers.find(owner);
+    return found == ownerNumbers.end() ? NO_KEY : found->second;
+}
+
+uint32_t ListingColumns::collectionKey(const std::string& collection) const {
+    auto found = collectionNumbers.find(collection);
+    return found == collectionNumbers.end() ? NO_KEY : found->second;
+}
+
+ListingStats ListingColumns::stats(double minPrice, double maxPrice) const {
+    return scanStats<false>(prices.data(), nullptr, 0, prices.size(), minPrice, maxPrice);
+}
+
+ListingStats ListingColumns::ownerStats(uint32_t ownerKey, double minPrice, double maxPrice) const {
+    if (ownerKey == NO_KEY) return ListingStats();
+    return scanStats<true>(prices.data(), ownerIds.data(), ownerKey, prices.size(), minPrice, maxPrice);
+}
+
+ListingStats ListingColumns::collectionStats(uint32_t collectionKey, double minPrice, double maxPrice) const {
+    if (collectionKey == NO_KEY) return ListingStats();
+    return scanStats<true>(prices.data(), collectionIds.data(), collectionKey, prices.size(), minPrice, maxPrice);
+}
@@ -2,25 +2,60 @@
 #include <crow.h>
 #include <thread>
 #include <chrono>
+#include <cstdlib>
 
 int main() {
     try {
-        std::vector<UserAccount>users;
+        UserTable& users = userTable();
         std::vector<NFT> nfts;
         std::vector<Collection> collections;
 
-        // Load existing users from keypairs directory
-        std::cout << "Main: About to load existing users..." << std::endl;
-        UserAccount::loadExistingUsers(users);
-        std::cout << "Main: Finished loading users. Total users: " << users.size() << std::endl;
-
-        std::cout << "Starting NFT Marketplace API server..." << std::endl;
-
         // Initialize the marketplace
         Marketplace* marketplace = Marketplace::getInstance();
-        
-        // Load existing marketplace data
-        marketplace->loadMarketplaceData();
+
+        // Boot from the binary image when it matches the files on disk
+        bool fromSnapshot = false;
+        {
+            auto start = std::chrono::steady_clock::now();
+            SnapshotImage snapshot;
+            if (snapshot.open(SNAPSHOT_PATH, currentSnapshotStamp())) {
+                try {
+                    UserAccount::loadFromSnapshot(users, snapshot);
+                    marketplace->loadFromSnapshot(snapshot);
+                    fromSnapshot = true;
+                    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+                    std::cout << "Main: Loaded " << users.size() << " users from snapshot (" << snapshot.bytes()
+                              << " bytes) in " << elapsed.count() << " ms" << std::endl;
+                } catch (const std::exception& e) {
+                    std::cerr << "Snapshot unusable, falling back to full load: " << e.what() << std::endl;
+                    users.clear();
+                }
+            }
+        }
+
+        if (!fromSnapshot) {
+            // Load existing users from the account store
+            std::cout << "Main: About to load existing users..." << std::endl;
+            UserAccount::loadExistingUsers(users);
+            std::cout << "Main: Finished loading users. Total users: " << users.size() << std::endl;
+
+            // Load existing marketplace data
+            marketplace->loadMarketplaceData();
+            marketplace->reconcileWithAccounts();
+        }
+
+        // Accounts and keypairs are made in-process; only airdrops and Phantom need the CLI
+        if (!UserAccount::checkSolanaInstallation()) {
+            std::cout << "Main: Solana CLI not found; airdrops and wallet connection are unavailable" << std::endl;
+        }
+
+        // Opt-in: a network round trip per 100 wallets before the menu appears
+        const char* reconcile = std::getenv("RECONCILE_BALANCES");
+        if (reconcile && *reconcile && std::string(reconcile) != "0") {
+            UserAccount::reconcileBalances(users);
+        }
+
+        std::cout << "Starting NFT Marketplace API server..." << std::endl;
 
         // Start the API server
         std::cout << "Starting API server on port 3000..." << std::endl;
@@ -34,8 +69,28 @@ int main() {
 
         menu(users, nfts, collections);
 
+        // Let queued mints finish so their addresses are saved
+        if (mintQueue().pending() > 0) {
+            std::cout << "Waiting for " << mintQueue().pending() << " mint(s) to finish..." << std::endl;
+            mintQueue().waitIdle();
+        }
+        UserAccount::applyCompletedMints();
+
         // Save marketplace data before exiting
         marketplace->saveMarketplaceData();
+
+        // Image for the next start, stamped with the files it was built from
+        try {
+            SnapshotBuilder builder;
+            for (const auto& user : users) {
+                AccountGuard account(user);
+                user.addToSnapshot(builder);
+            }
+            marketplace->addToSnapshot(builder);
+            builder.write(SNAPSHOT_PATH, currentSnapshotStamp());
+        } catch (const std::exception& e) {
+            std::cerr << "Error writing snapshot: " << e.what() << std::endl;
+        }
         delete marketplace;
         return 0;
     } catch (const std::exception& e) {
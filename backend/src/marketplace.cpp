@@ -1,373 +1,470 @@
 #include "../include/header.hpp"
 #include "../include/solana_config.hpp"
 #include "../include/solana_integration.hpp"
+#include "../include/file_util.hpp"
+#include "../include/json_reader.hpp"
+#include "../include/json_writer.hpp"
 
 Marketplace* Marketplace::instance = nullptr;
+std::once_flag Marketplace::instanceCreated;
+
+namespace {
+    const char* JOURNAL_PATH = "marketplace/journal.bin";
+    // Account store key holding the token's latest sale (encodeTransaction), committed with the accounts
+    const std::string SALE_PREFIX = "sales/";
+
+    // Journal record types
+    enum JournalEvent : uint8_t {
+        EVENT_LIST = 1,
+        EVENT_UNLIST = 2,
+        EVENT_BUY = 3
+    };
+
+    void encodeNFT(ByteWriter& out, const NFT& nft) {
+        out.putString(nft.getTokenId());
+        out.putString(nft.getName());
+        out.putString(nft.getOwner());
+        out.putDouble(nft.getPrice());
+        out.putBool(nft.getIsListed());
+        out.putString(nft.getMintAddress());
+        out.putString(nft.getMetadataUri());
+        out.putString(nft.getCollection());
+    }
 
-Marketplace* Marketplace::getInstance() {
-    if (!instance) {
-        instance = new Marketplace();
+    // Commits account records for a change already made in memory
+    void commitAccounts(const WriteBatch& batch, const std::string& change) {
+        try {
+            accountStore().commit(batch);
+        } catch (const std::exception& e) {
+            throw PersistenceError(change + " but could not be saved: " + e.what());
+        }
+    }
+
+    NFT decodeNFT(ByteReader& in) {
+        std::string tokenId = in.getString();
+        std::string name = in.getString();
+        std::string owner = in.getString();
+        double price = in.getDouble();
+        bool isListed = in.getBool();
+        std::string mintAddress = in.getString();
+        std::string metadataUri = in.getString();
+        std::string collection = in.getString();
+        NFT nft(tokenId, name, owner, price, isListed, metadataUri);
+        nft.setMintAddress(mintAddress);
+        nft.setCollection(collection);
+        return nft;
+    }
+
+    void encodeTransaction(ByteWriter& out, const Transaction& tx) {
+        out.putString(tx.getTransactionId());
+        out.putString(tx.getTokenId());
+        out.putString(tx.getSeller());
+        out.putString(tx.getBuyer());
+        out.putDouble(tx.getPrice());
+        out.putString(tx.getTimestamp());
+        out.putString(tx.getStatus());
+    }
+
+    Transaction decodeTransaction(ByteReader& in) {
+        std::string transactionId = in.getString();
+        std::string tokenId = in.getString();
+        std::string seller = in.getString();
+        std::string buyer = in.getString();
+        double price = in.getDouble();
+        std::string timestamp = in.getString();
+        std::string status = in.getString();
+        return Transaction(transactionId, tokenId, seller, buyer, price, timestamp, status);
+    }
+}
+
+void Marketplace::openJournal() {
+    std::call_once(journalOpened, [this] {
+        std::filesystem::create_directories("marketplace");
+        journal.open(JOURNAL_PATH);
+    });
+}
+
+// Durably records one event. Once the journal gets long, the compactor thread
+// folds it into a fresh snapshot; the caller only pays for the append.
+// Called without stateMutex, after the change is already visible in memory:
+// compact() counts on every record before its mark being in the state it copied.
+// Every event is in the account store by now, so a failed append is logged, not
+// thrown: reconcileWithAccounts brings it back at the next start.
+void Marketplace::journalEvent(const ByteWriter& record) {
+    try {
+        openJournal();
+        journal.append(record);
+    } catch (const std::exception& e) {
+        std::cerr << "Error journaling marketplace event (restored from the account store at the next start): "
+                  << e.what() << std::endl;
+        return;
+    }
+    if (journal.records() >= JOURNAL_COMPACT_RECORDS && !compactionQueued.exchange(true)) {
+        compactor.submit([this] {
+            {
+                std::lock_guard<std::mutex> compaction(compactionMutex);
+                // saveMarketplaceData may have compacted since this was queued
+                if (journal.records() >= JOURNAL_COMPACT_RECORDS) {
+                    compact();
+                }
+            }
+            compactionQueued = false;
+        });
     }
+}
+
+// Replay is idempotent: the journal can hold events the snapshot already
+// contains, from a crash before truncation or journaled while it was copied.
+void Marketplace::applyJournalRecord(ByteReader& reader) {
+    uint8_t type = reader.getU8();
+    switch (type) {
+        case EVENT_LIST: {
+            NFT nft = decodeNFT(reader);
+            if (!reader.ok()) break;
+            size_t slot = listingIndex.find(nft.id());
+            if (slot != FlatHashIndex<TokenId>::npos) {
+                removeListingAt(slot);
+            }
+            addListing(nft);
+            break;
+        }
+        case EVENT_UNLIST: {
+            TokenId tokenId = TokenId::lookup(reader.getString());
+            size_t slot = listingIndex.find(tokenId);
+            if (reader.ok() && slot != FlatHashIndex<TokenId>::npos) {
+                removeListingAt(slot);
+            }
+            break;
+        }
+        case EVENT_BUY: {
+            Transaction tx = decodeTransaction(reader);
+            if (!reader.ok()) break;
+            size_t slot = listingIndex.find(tx.token());
+            if (slot != FlatHashIndex<TokenId>::npos) {
+                removeListingAt(slot);
+            }
+            appendTransaction(tx);
+            break;
+        }
+        default:
+            std::cerr << "Skipping unknown marketplace journal record type " << static_cast<int>(type) << std::endl;
+            break;
+    }
+}
+
+Marketplace* Marketplace::getInstance() {
+    std::call_once(instanceCreated, [] { instance = new Marketplace(); });
     return instance;
 }
 
-bool Marketplace::listNFT(NFT& nft, double price) {
+std::mutex& Marketplace::tokenLock(TokenId tokenId) {
+    return tokenLocks[std::hash<TokenId>()(tokenId) % TOKEN_LOCK_STRIPES];
+}
+
+// Replaces one collection's entry in the published view; the rest are shared with the old view
+void Marketplace::publishView(const std::string& collection) {
+    std::shared_ptr<const ListingsView> current = std::atomic_load(&listingsView);
+    auto next = std::make_shared<ListingsView>(*current);
+    auto book = collectionBooks.find(collection);
+    if (book == collectionBooks.end()) {
+        next->erase(collection);
+    } else {
+        auto view = std::make_shared<CollectionListingsView>();
+        view->floorPrice = book->second.floorPrice();
+        view->listingCount = book->second.size();
+        view->cheapest = book->second.cheapest(VIEW_DEPTH);
+        (*next)[collection] = std::move(view);
+    }
+    std::atomic_store(&listingsView, std::shared_ptr<const ListingsView>(std::move(next)));
+}
+
+// After a bulk load: one view built from scratch instead of one per listing
+void Marketplace::publishAllViews() {
+    auto next = std::make_shared<ListingsView>();
+    for (const auto& entry : collectionBooks) {
+        auto view = std::make_shared<CollectionListingsView>();
+        view->floorPrice = entry.second.floorPrice();
+        view->listingCount = entry.second.size();
+        view->cheapest = entry.second.cheapest(VIEW_DEPTH);
+        (*next)[entry.first] = std::move(view);
+    }
+    std::atomic_store(&listingsView, std::shared_ptr<const ListingsView>(std::move(next)));
+}
+
+void Marketplace::addListing(const NFT& nft) {
+    listedNFTs.push_back(nft);
+    listingIndex.insert(nft.id(), listedNFTs.size() - 1);
+    uint64_t listedSeq = nextListingSeq++;
+    listingColumns.append(nft.id(), nft.getPrice(), nft.ownerKey(), nft.getCollection(), listedSeq);
+    collectionBooks[nft.getCollection()].add(nft.id(), nft.getPrice(), listedSeq);
+    allListings.add(nft.id(), nft.getPrice(), listedSeq);
+}
+
+// Swap-and-pop: the last listing moves into the freed slot, so removal is O(1)
+NFT Marketplace::removeListingAt(size_t slot) {
+    NFT removed = std::move(listedNFTs[slot]);
+    auto book = collectionBooks.find(removed.getCollection());
+    if (book != collectionBooks.end()) {
+        book->second.remove(removed.id());
+        if (book->second.empty()) {
+            collectionBooks.erase(book);
+        }
+    }
+    allListings.remove(removed.id());
+    listingIndex.erase(removed.id());
+    size_t last = listedNFTs.size() - 1;
+    if (slot != last) {
+        listedNFTs[slot] = std::move(listedNFTs[last]);
+        listingIndex.insert(listedNFTs[slot].id(), slot);
+    }
+    listedNFTs.pop_back();
+    listingColumns.removeAt(slot);
+    return removed;
+}
+
+bool Marketplace::listNFT(const std::string& tokenText, double price, UserAccount& seller) {
     try {
-        std::cout << "DEBUG: Listing NFT with tokenId: '" << nft.getTokenId() << "', name: '" << nft.getName() << "', owner: '" << nft.getOwner() << "', price: " << nft.getPrice() << std::endl;
-        if (nft.getOwner() != UserAccount::getCurrentUser()->getWalletAddress()) {
-            throw std::runtime_error("You can only list NFTs that you own");
-        }   
-
-        // Check if NFT is already listed
-        if (nft.getIsListed()) {
-            throw std::runtime_error("NFT is already listed for sale");
+        TokenId tokenId = TokenId::lookup(tokenText);
+        if (tokenId.empty()) {
+            throw std::runtime_error("NFT not found in your collections");
         }
+        std::lock_guard<std::mutex> tokenGuard(tokenLock(tokenId));
+
+        NFT listed;
+        {
+            // The seller's own copy, found and updated under the account lock so a
+            // concurrent sale or mint result can't move it out from under us
+            AccountGuard account(seller);
+            NFT* nft = nullptr;
+            for (auto& collection : seller.getCollections()) {
+                nft = collection.findNFT(tokenId);
+                if (nft) break;
+            }
+            if (!nft) {
+                throw std::runtime_error("NFT not found in your collections");
+            }
 
-        // Set price and mark as listed
-        nft.setPrice(price);
-        nft.setIsListed(true);
-        
-        // Keep the original owner (seller) - don't transfer to marketplace
-        // The NFT stays owned by the seller but is listed for sale
-        listedNFTs.push_back(nft);
-        
-        // Update the original NFT in the user's collection
-        UserAccount* currentUser = UserAccount::getCurrentUser();
-        if (currentUser) {
-            // Update in user's owned NFTs
-            for (auto& userNFT : currentUser->getOwnedNFTs()) {
-                if (userNFT.getTokenId() == nft.getTokenId()) {
-                    userNFT.setIsListed(true);
-                    userNFT.setPrice(price);
-                    break;
+            if (nft->ownerKey() != Pubkey::lookup(seller.getWalletAddress())) {
+                throw std::runtime_error("You can only list NFTs that you own");
+            }   
+
+            {
+                std::unique_lock<std::shared_mutex> write(stateMutex);
+                // Check if NFT is already listed
+                if (nft->getIsListed() || listingIndex.contains(tokenId)) {
+                    throw std::runtime_error("NFT is already listed for sale");
                 }
+
+                // Set price and mark as listed
+                nft->setPrice(price);
+                nft->setIsListed(true);
+
+                // Keep the original owner (seller) - don't transfer to marketplace
+                // The NFT stays owned by the seller but is listed for sale
+                addListing(*nft);
+                publishView(nft->getCollection());
             }
+            listed = *nft;
             
-            // Update in user's collections
-            for (auto& collection : currentUser->getCollections()) {
-                for (auto& collectionNFT : collection.getNFTs()) {
-                    if (collectionNFT.getTokenId() == nft.getTokenId()) {
-                        collectionNFT.setIsListed(true);
-                        collectionNFT.setPrice(price);
-                        break;
-                    }
+            // Update the original NFT in the seller's owned NFTs
+            if (NFT* userNFT = seller.findOwnedNFT(tokenId)) {
+                userNFT->setIsListed(true);
+                userNFT->setPrice(price);
+            }
+
+            // Update in the seller's other collections
+            for (auto& collection : seller.getCollections()) {
+                if (NFT* collectionNFT = collection.findNFT(tokenId)) {
+                    collectionNFT->setIsListed(true);
+                    collectionNFT->setPrice(price);
                 }
             }
-            
-            // Save updated user data
-            std::string safe_email = currentUser->getEmail();
-            std::replace(safe_email.begin(), safe_email.end(), '@', '_');
-            std::replace(safe_email.begin(), safe_email.end(), '.', '_');
-            std::string keypair_dir = "keypairs/" + currentUser->getName() + "_" + safe_email;
-            currentUser->saveCollections(keypair_dir);
+
+            // Just this token's record; the rest of the inventory is untouched
+            WriteBatch batch;
+            seller.stageNFT(batch, seller.getKeypairDir(), tokenId);
+            commitAccounts(batch, "NFT " + tokenId.toString() + " was listed");
         }
         
-        // Save marketplace data to disk
-        saveMarketplaceData();
+        // Record the listing in the marketplace journal
+        ByteWriter record;
+        record.putU8(EVENT_LIST);
+        encodeNFT(record, listed);
+        journalEvent(record);
         
-        std::cout << "NFT " << nft.getTokenId() << " listed successfully at " << price << " SOL" << std::endl;
+        std::cout << "NFT " << listed.getTokenId() << " listed successfully at " << price << " SOL" << std::endl;
         std::cout << "Note: This is a local marketplace listing. For real Solana marketplace integration," << std::endl;
         std::cout << "you would need to deploy a marketplace program and use proper Solana instructions." << std::endl;
         
         return true;
 
+    } catch (const PersistenceError&) {
+        throw;
     } catch (const std::exception& e) {
         std::cerr << "Error listing: " << e.what() << std::endl;
         return false;
     }
 }
 
-void Marketplace::buyNFT(const std::string& tokenId, UserAccount& buyer) {
+Transaction Marketplace::buyNFT(const std::string& tokenText, UserAccount& buyer) {
     try {
-        // Find the NFT first
-        NFT* nftToBuy = nullptr;
-        size_t nftIndex = 0;
-        
-        for (size_t i = 0; i < listedNFTs.size(); i++) {
-            if (listedNFTs[i].getTokenId() == tokenId) {
-                nftToBuy = &listedNFTs[i];
-                nftIndex = i;
-                break;
-            }
-        }
-
-        if (!nftToBuy) {
+        // Never interns: ids nobody listed can't be in the index anyway
+        TokenId tokenId = TokenId::lookup(tokenText);
+        if (tokenId.empty()) {
             throw std::runtime_error("NFT not found");
         }
 
-        double price = nftToBuy->getPrice();
-        double platformFee = calculateFee(price);
-        double totalCost = price + platformFee;
-        std::string seller = nftToBuy->getOwner();
-        
-        std::cout << "DEBUG: NFT details:" << std::endl;
-        std::cout << "  Token ID: " << tokenId << std::endl;
-        std::cout << "  Name: " << nftToBuy->getName() << std::endl;
-        std::cout << "  Current Owner: " << seller << std::endl;
-        std::cout << "  Price: " << price << " SOL" << std::endl;
-
-        // Add Solana balance check (including platform fee) - use devnet
-        std::string balance_cmd = "solana balance " + buyer.getWalletAddress() + " --url https://api.devnet.solana.com";
-        FILE* balance_pipe = popen(balance_cmd.c_str(), "r");
-        double currentBalance = 0.0;
-        if (balance_pipe) {
-            char buffer[128];
-            if (fgets(buffer, sizeof(buffer), balance_pipe) != nullptr) {
-                std::string balance_str(buffer);
-                // Remove " SOL" suffix and newline
-                size_t sol_pos = balance_str.find(" SOL");
-                if (sol_pos != std::string::npos) {
-                    balance_str = balance_str.substr(0, sol_pos);
-                }
-                if (!balance_str.empty() && balance_str.back() == '\n') {
-                    balance_str.pop_back();
-                }
-                try {
-                    currentBalance = std::stod(balance_str);
-                } catch (const std::exception& e) {
-                    std::cout << "Failed to parse balance: " << e.what() << std::endl;
-                }
+        // Buyers of the same token queue here; whoever gets through first takes it
+        std::lock_guard<std::mutex> tokenGuard(tokenLock(tokenId));
+
+        // Just what the checks need; the NFT itself is moved out of the listing below
+        double price;
+        Pubkey seller;
+        {
+            std::shared_lock<std::shared_mutex> read(stateMutex);
+            size_t nftIndex = listingIndex.find(tokenId);
+            if (nftIndex == FlatHashIndex<TokenId>::npos) {
+                throw std::runtime_error("NFT not found");
             }
-            pclose(balance_pipe);
+            const NFT& listed = listedNFTs[nftIndex];
+            price = listed.getPrice();
+            seller = listed.ownerKey();
         }
-        
-        if (currentBalance < totalCost) {
-            throw std::runtime_error("Insufficient SOL balance. Need " + std::to_string(totalCost) + " SOL (price: " + std::to_string(price) + " SOL + fee: " + std::to_string(platformFee) + " SOL), but have " + std::to_string(currentBalance) + " SOL");
-        }
-
-        // Update ownership
-        nftToBuy->setOwner(buyer.getWalletAddress());
-        nftToBuy->setIsListed(false);
 
-        // Update balances - will be handled after seller account lookup
-        double buyerOldBalance = buyer.getBalance();
-        std::cout << "DEBUG: Updating buyer balance from " << buyerOldBalance << " to " << (buyerOldBalance - totalCost) << " SOL" << std::endl;
-        buyer.updateBalance(-totalCost); // Buyer pays price + platform fee
-        std::cout << "DEBUG: Buyer balance after update: " << buyer.getBalance() << " SOL" << std::endl;
-        
-        // Save buyer's updated balance to disk
-        std::string buyer_safe_email = buyer.getEmail();
-        std::replace(buyer_safe_email.begin(), buyer_safe_email.end(), '@', '_');
-        std::replace(buyer_safe_email.begin(), buyer_safe_email.end(), '.', '_');
-        std::string buyer_keypair_dir = "keypairs/" + buyer.getName() + "_" + buyer_safe_email;
-        
-        // Save balance to balance.txt file
-        std::string buyer_balance_path = buyer_keypair_dir + "/balance.txt";
-        std::ofstream buyer_balance_file(buyer_balance_path);
-        if (buyer_balance_file.is_open()) {
-            double buyerBalanceToSave = buyer.getBalance();
-            buyer_balance_file << buyerBalanceToSave;
-            buyer_balance_file.close();
-            std::cout << "DEBUG: Saved buyer balance to disk: " << buyerBalanceToSave << " SOL" << std::endl;
-            std::cout << "DEBUG: Buyer balance file path: " << buyer_balance_path << std::endl;
-        } else {
-            std::cout << "DEBUG: ERROR - Could not open buyer balance file: " << buyer_balance_path << std::endl;
-        }
-        
-        // Save updated user info to info.json
-        std::string buyer_info_path = buyer_keypair_dir + "/info.json";
-        std::ofstream buyer_info_file(buyer_info_path);
-        if (buyer_info_file.is_open()) {
-            buyer_info_file << "{\n";
-            buyer_info_file << "  \"name\": \"" << buyer.getName() << "\",\n";
-            buyer_info_file << "  \"email\": \"" << buyer.getEmail() << "\",\n";
-            buyer_info_file << "  \"walletAddress\": \"" << buyer.getWalletAddress() << "\",\n";
-            buyer_info_file << "  \"balance\": \"" << buyer.getBalance() << "\"\n";
-            buyer_info_file << "}";
-            buyer_info_file.close();
-        }
+        double platformFee = calculateFee(price);
+        double totalCost = price + platformFee;
+        std::string sellerAddress = seller.toString();
 
-        // Copy NFT data BEFORE modifying listings (to avoid use-after-free)
-        NFT boughtNFT = *nftToBuy;
-        boughtNFT.setIsListed(false);
-        
-        // Record transaction
-        Transaction tx(tokenId, seller, buyer.getWalletAddress(), price);
-        recordTransaction(tx);
-        buyer.addTransaction(tx.getTransactionId());
-
-        // Remove from listings
-        V<NFT> updatedListings;
-        for (size_t i = 0; i < listedNFTs.size(); i++) {
-            if (i != nftIndex) {
-                updatedListings.push_back(listedNFTs[i]);
-            }
-        }
-        listedNFTs = updatedListings;
+        // Ask the node before taking any account lock; other sales needn't wait on the RPC
+        double chainBalance = SolanaIntegration::getBalance(buyer.getWalletAddress());
 
         // Update user collections
         // Remove from seller's collections
-        std::cout << "DEBUG: Looking for seller account with wallet: " << seller << std::endl;
-        std::cout << "DEBUG: Total users in allUsers vector: " << UserAccount::getAllUsers().size() << std::endl;
-        std::cout << "DEBUG: Available users:" << std::endl;
-        for (UserAccount* user : UserAccount::getAllUsers()) {
-            if (user) {
-                std::cout << "  - " << user->getName() << " (" << user->getEmail() << "): " << user->getWalletAddress() << std::endl;
-                std::cout << "    Wallet match: " << (user->getWalletAddress() == seller ? "YES" : "NO") << std::endl;
-            } else {
-                std::cout << "  - NULL user pointer found!" << std::endl;
-            }
-        }
-        
-        UserAccount* sellerAccount = UserAccount::findUserByWallet(seller);
+        UserAccount* sellerAccount = UserAccount::findUserByWallet(sellerAddress);
         
         // If seller account not found and owner is "MARKETPLACE", try to find the actual seller
-        if (!sellerAccount && seller == "MARKETPLACE") {
-            std::cout << "DEBUG: NFT owner is 'MARKETPLACE', searching for actual seller..." << std::endl;
+        if (!sellerAccount && sellerAddress == "MARKETPLACE") {
             // Search through all users to find who owns this NFT
-            for (UserAccount* user : UserAccount::getAllUsers()) {
-                if (user) {
-                    // Check in user's owned NFTs
-                    for (const auto& userNFT : user->getOwnedNFTs()) {
-                        if (userNFT.getTokenId() == tokenId) {
-                            sellerAccount = user;
-                            std::cout << "DEBUG: Found actual seller: " << user->getName() << " (" << user->getEmail() << ")" << std::endl;
-                            break;
-                        }
-                    }
-                    if (sellerAccount) break;
-                    
-                    // Check in user's collections
-                    for (const auto& collection : user->getCollections()) {
-                        for (const auto& collectionNFT : collection.getNFTs()) {
-                            if (collectionNFT.getTokenId() == tokenId) {
-                                sellerAccount = user;
-                                std::cout << "DEBUG: Found actual seller: " << user->getName() << " (" << user->getEmail() << ")" << std::endl;
-                                break;
-                            }
-                        }
-                        if (sellerAccount) break;
-                    }
-                    if (sellerAccount) break;
+            for (UserAccount& account : userTable()) {
+                AccountGuard held(account);
+                if (account.holdsNFT(tokenId)) {
+                    sellerAccount = &account;
+                    break;
                 }
             }
         }
-        
-        if (sellerAccount) {
-            std::cout << "DEBUG: Found seller account: " << sellerAccount->getName() << std::endl;
-            
-            // Update seller's balance
-            double oldBalance = sellerAccount->getBalance();
-            std::cout << "DEBUG: Updating seller balance from " << oldBalance << " to " << (oldBalance + price) << " SOL" << std::endl;
-            sellerAccount->updateBalance(price); // Seller gets full price
-            std::cout << "DEBUG: Seller balance after update: " << sellerAccount->getBalance() << " SOL" << std::endl;
-            
-            // Remove from seller's owned NFTs
-            std::cout << "DEBUG: Removing NFT " << tokenId << " from seller's owned NFTs (had " << sellerAccount->getOwnedNFTs().size() << " NFTs)" << std::endl;
-            V<NFT> updatedOwnedNFTs;
-            for (const auto& userNFT : sellerAccount->getOwnedNFTs()) {
-                if (userNFT.getTokenId() != tokenId) {
-                    updatedOwnedNFTs.push_back(userNFT);
-                } else {
-                    std::cout << "DEBUG: Found and removing NFT " << tokenId << " from owned NFTs" << std::endl;
-                }
+
+        Pubkey buyerKey = Pubkey::parse(buyer.getWalletAddress());
+        Transaction tx(tokenId, seller, buyerKey, price);
+        NFT boughtNFT;
+        size_t sellerOwned = 0;
+        V<std::pair<std::string, size_t>> sellerCollections;
+        size_t buyerOwned = 0;
+        size_t buyerCollections = 0;
+        {
+            // Buyer and seller stay locked from the balance check to the last record update,
+            // so two sales to the same buyer can't both pass the check before either charges
+            AccountGuard accounts(buyer, sellerAccount);
+
+            // Add Solana balance check (including platform fee). Off-chain sales don't move
+            // the node's balance, so earlier charges are taken off it here.
+            double currentBalance = buyer.spendableBalance(chainBalance);
+            if (currentBalance < totalCost) {
+                throw std::runtime_error("Insufficient SOL balance. Need " + std::to_string(totalCost) + " SOL (price: " + std::to_string(price) + " SOL + fee: " + std::to_string(platformFee) + " SOL), but have " + std::to_string(currentBalance) + " SOL");
             }
-            sellerAccount->setOwnedNFTs(updatedOwnedNFTs);
-            std::cout << "DEBUG: Seller now has " << sellerAccount->getOwnedNFTs().size() << " owned NFTs" << std::endl;
-            
-            // Remove from seller's collections
-            std::cout << "DEBUG: Removing NFT " << tokenId << " from seller's collections" << std::endl;
-            for (auto& collection : sellerAccount->getCollections()) {
-                std::cout << "DEBUG: Processing collection: " << collection.getName() << " (has " << collection.getNFTs().size() << " NFTs)" << std::endl;
-                V<NFT> updatedCollectionNFTs;
-                for (const auto& collectionNFT : collection.getNFTs()) {
-                    if (collectionNFT.getTokenId() != tokenId) {
-                        updatedCollectionNFTs.push_back(collectionNFT);
-                    } else {
-                        std::cout << "DEBUG: Found and removing NFT " << tokenId << " from collection " << collection.getName() << std::endl;
-                    }
-                }
-                collection.getNFTs() = updatedCollectionNFTs;
-                std::cout << "DEBUG: Collection " << collection.getName() << " now has " << collection.getNFTs().size() << " NFTs" << std::endl;
+
+            // Take the listing off the market and record the sale in one step. The
+            // token lock kept it listed since the lookup above, but its slot may have moved.
+            {
+                std::unique_lock<std::shared_mutex> write(stateMutex);
+                boughtNFT = removeListingAt(listingIndex.find(tokenId));
+                appendTransaction(tx);
+                publishView(boughtNFT.getCollection());
             }
-            
-            // Save seller's updated data (collections and balance)
-            std::string seller_safe_email = sellerAccount->getEmail();
-            std::replace(seller_safe_email.begin(), seller_safe_email.end(), '@', '_');
-            std::replace(seller_safe_email.begin(), seller_safe_email.end(), '.', '_');
-            std::string seller_keypair_dir = "keypairs/" + sellerAccount->getName() + "_" + seller_safe_email;
-            
-            // Save collections
-            sellerAccount->saveCollections(seller_keypair_dir);
-            
-            // Save balance to balance.txt file
-            std::string balance_path = seller_keypair_dir + "/balance.txt";
-            std::ofstream balance_file(balance_path);
-            if (balance_file.is_open()) {
-                double balanceToSave = sellerAccount->getBalance();
-                balance_file << balanceToSave;
-                balance_file.close();
-                std::cout << "DEBUG: Saved seller balance to disk: " << balanceToSave << " SOL" << std::endl;
-                std::cout << "DEBUG: Balance file path: " << balance_path << std::endl;
+            buyer.addTransaction(tx.getTransactionId());
+
+            // Update ownership
+            boughtNFT.setOwner(buyerKey);
+            boughtNFT.setIsListed(false);
+
+            buyer.updateBalance(-totalCost); // Buyer pays price + platform fee
+
+            // Both sides' balances moved; make the next lookup ask the node
+            balanceCache().invalidate(buyer.getWalletAddress());
+            balanceCache().invalidate(sellerAddress);
+
+            if (sellerAccount) {
+                // Update seller's balance
+                sellerAccount->updateBalance(price); // Seller gets full price
+
+                // Out of the seller's owned NFTs and collections: index updates, nothing else is copied
+                sellerAccount->releaseNFT(tokenId);
+
+                sellerOwned = sellerAccount->getOwnedNFTs().size();
+                for (const auto& collection : sellerAccount->getCollections()) {
+                    sellerCollections.emplace_back(collection.getName(), collection.getNFTs().size());
+                }
             } else {
-                std::cout << "DEBUG: ERROR - Could not open seller balance file: " << balance_path << std::endl;
+                std::cerr << "Warning: no account for seller wallet " << sellerAddress
+                          << "; the sale is recorded but no seller was paid" << std::endl;
             }
             
-            // Save updated user info to info.json
-            std::string info_path = seller_keypair_dir + "/info.json";
-            std::ofstream info_file(info_path);
-            if (info_file.is_open()) {
-                info_file << "{\n";
-                info_file << "  \"name\": \"" << sellerAccount->getName() << "\",\n";
-                info_file << "  \"email\": \"" << sellerAccount->getEmail() << "\",\n";
-                info_file << "  \"walletAddress\": \"" << sellerAccount->getWalletAddress() << "\",\n";
-                info_file << "  \"balance\": \"" << sellerAccount->getBalance() << "\",\n";
-                info_file << "  \"passwordHash\": \"\"\n";
-                info_file << "}";
-                info_file.close();
-                std::cout << "DEBUG: Saved seller info to disk" << std::endl;
+            // Into the buyer's owned NFTs and first collection ("My NFTs" if there is none)
+            bool firstCollection = buyer.getCollections().empty();
+            buyer.receiveNFT(boughtNFT);
+
+            // Both accounts, the buyer's history and the sale land in one commit, made before
+            // either account is unlocked: on disk the token is never in both inventories or
+            // in neither, and no later write to these accounts can be overtaken by this one
+            WriteBatch batch;
+            std::string buyerDir = buyer.getKeypairDir();
+            buyer.stageUserData(batch, buyerDir);
+            if (firstCollection) {
+                buyer.stageCollectionList(batch, buyerDir);
             }
-        } else {
-            std::cout << "DEBUG: WARNING - Seller account not found for wallet: " << seller << std::endl;
-            std::cout << "DEBUG: This means the NFT removal from seller's collections was skipped!" << std::endl;
-        }
-        
-        // Add to buyer's owned NFTs
-        buyer.getOwnedNFTs().push_back(boughtNFT);
-        
-        // Add to buyer's collections (create a default collection if none exists)
-        if (buyer.getCollections().empty()) {
-            Collection defaultCollection("My NFTs", buyer.getName());
-            buyer.getCollections().push_back(defaultCollection);
-        }
-        
-        // Add NFT to the first collection
-        buyer.getCollections()[0].addNFT(boughtNFT);
-        
-        // Save buyer's updated collections and owned NFTs
-        buyer.saveCollections(buyer_keypair_dir);
-        
-        // Save buyer's transaction history
-        std::string buyer_tx_path = buyer_keypair_dir + "/transactions.txt";
-        std::ofstream buyer_tx_file(buyer_tx_path, std::ios::app);
-        if (buyer_tx_file.is_open()) {
-            buyer_tx_file << tx.getTransactionId() << std::endl;
-            buyer_tx_file.close();
-            std::cout << "DEBUG: Saved transaction ID to buyer's file: " << tx.getTransactionId() << std::endl;
+            buyer.stageNFT(batch, buyerDir, tokenId);
+            buyer.stageTransaction(batch, buyerDir, tx.getTransactionId());
+            if (sellerAccount) {
+                std::string sellerDir = sellerAccount->getKeypairDir();
+                sellerAccount->stageUserData(batch, sellerDir);
+                sellerAccount->stageNFT(batch, sellerDir, tokenId);
+            }
+            // What reconcileWithAccounts needs if the journal append below never happens
+            ByteWriter sale;
+            encodeTransaction(sale, tx);
+            batch.put(SALE_PREFIX + tokenId.toString(), sale.str());
+            commitAccounts(batch, "Sale " + tx.getTransactionId() + " went through");
+
+            buyerOwned = buyer.getOwnedNFTs().size();
+            buyerCollections = buyer.getCollections().size();
         }
 
-        // Save marketplace data
-        saveMarketplaceData();
+        // Record the sale in the marketplace journal
+        ByteWriter record;
+        record.putU8(EVENT_BUY);
+        encodeTransaction(record, tx);
+        journalEvent(record);
 
         std::cout << "NFT transferred successfully!" << std::endl;
         std::cout << "Transaction Summary:" << std::endl;
-        std::cout << "  NFT: " << tokenId << " (" << nftToBuy->getName() << ")" << std::endl;
-        std::cout << "  Seller: " << seller << " received " << price << " SOL" << std::endl;
+        std::cout << "  NFT: " << tokenId << " (" << boughtNFT.getName() << ")" << std::endl;
+        std::cout << "  Seller: " << sellerAddress << " received " << price << " SOL" << std::endl;
         std::cout << "  Buyer: " << buyer.getWalletAddress() << " paid " << totalCost << " SOL (price: " << price << " SOL + fee: " << platformFee << " SOL)" << std::endl;
         
-        // Final state summary
-        if (UserAccount* sellerAccount = UserAccount::findUserByWallet(seller)) {
+        // Final state summary, as it stood when the sale went through
+        if (sellerAccount) {
             std::cout << "\nFinal State:" << std::endl;
             std::cout << "  Seller (" << sellerAccount->getName() << "):" << std::endl;
-            std::cout << "    - Owned NFTs: " << sellerAccount->getOwnedNFTs().size() << std::endl;
-            std::cout << "    - Collections: " << sellerAccount->getCollections().size() << std::endl;
-            for (const auto& collection : sellerAccount->getCollections()) {
-                std::cout << "      * " << collection.getName() << ": " << collection.getNFTs().size() << " NFTs" << std::endl;
+            std::cout << "    - Owned NFTs: " << sellerOwned << std::endl;
+            std::cout << "    - Collections: " << sellerCollections.size() << std::endl;
+            for (const auto& collection : sellerCollections) {
+                std::cout << "      * " << collection.first << ": " << collection.second << " NFTs" << std::endl;
             }
         }
         std::cout << "  Buyer (" << buyer.getName() << "):" << std::endl;
-        std::cout << "    - Owned NFTs: " << buyer.getOwnedNFTs().size() << std::endl;
-        std::cout << "    - Collections: " << buyer.getCollections().size() << std::endl;
+        std::cout << "    - Owned NFTs: " << buyerOwned << std::endl;
+        std::cout << "    - Collections: " << buyerCollections << std::endl;
+        return tx;
     } catch (const std::exception& e) {
         std::cerr << "Error buying NFT: " << e.what() << std::endl;
         throw;
@@ -376,23 +473,41 @@ void Marketplace::buyNFT(const std::string& tokenId, UserAccount& buyer) {
 
 void Marketplace::displayListedNFTs() const {
     try {
+        std::shared_lock<std::shared_mutex> read(stateMutex);
         if (listedNFTs.empty()) {
             std::cout << "\nNo NFTs currently listed on the marketplace." << std::endl;
             return;
         }
 
+        ListingStats totals = listingColumns.stats();
         std::cout << "\n NFTs Available for Purchase: " << std::endl;
-        std::cout << "Total listings: " << listedNFTs.size() << std::endl;
+        std::cout << "Total listings: " << totals.count << " | Total value: " << totals.totalPrice
+                  << " SOL | Lowest price: " << totals.minPrice << " SOL" << std::endl;
+
+        // Collections in name order, each one cheapest first
+        std::vector<std::string> collectionNames;
+        for (const auto& entry : collectionBooks) {
+            collectionNames.push_back(entry.first);
+        }
+        std::sort(collectionNames.begin(), collectionNames.end());
 
         int counter = 1;
-        for (const auto& nft : listedNFTs) {
-            std::cout << "\nListing #" << counter++ << std::endl;
-            std::cout << "Token ID: " << nft.getTokenId() << std::endl;
-            std::cout << "Name: " << nft.getName() << std::endl;
-            std::cout << "Seller: " << nft.getOwner() << std::endl;
-            std::cout << "Price: " << nft.getPrice() << " SOL" << std::endl;
-            std::cout << "Platform Fee: " << calculateFee(nft.getPrice()) << " SOL" << std::endl;
-            std::cout << "Total Cost: " << (nft.getPrice() + calculateFee(nft.getPrice())) << " SOL" << std::endl;
+        for (const auto& collectionName : collectionNames) {
+            const OrderBook& book = collectionBooks.at(collectionName);
+            std::cout << "\n=== Collection: " << (collectionName.empty() ? "(none)" : collectionName)
+                      << " | Listings: " << book.size()
+                      << " | Floor: " << *book.floorPrice() << " SOL ===" << std::endl;
+
+            for (const auto& entry : book) {
+                const NFT& nft = listedNFTs[listingIndex.find(entry.tokenId)];
+                std::cout << "\nListing #" << counter++ << std::endl;
+                std::cout << "Token ID: " << nft.getTokenId() << std::endl;
+                std::cout << "Name: " << nft.getName() << std::endl;
+                std::cout << "Seller: " << nft.getOwner() << std::endl;
+                std::cout << "Price: " << nft.getPrice() << " SOL" << std::endl;
+                std::cout << "Platform Fee: " << calculateFee(nft.getPrice()) << " SOL" << std::endl;
+                std::cout << "Total Cost: " << (nft.getPrice() + calculateFee(nft.getPrice())) << " SOL" << std::endl;
+            }
         }
     }
     catch (const std::exception& e) {
@@ -402,25 +517,45 @@ void Marketplace::displayListedNFTs() const {
 
 
 
-void Marketplace::unlistNFT(const std::string& tokenId) {
+void Marketplace::unlistNFT(const std::string& tokenText, UserAccount& seller) {
     try {
-        bool found = false;
-        V<NFT> newListedNFTs;
-        
-        for (auto& nft : listedNFTs) {
-            if (nft.getTokenId() == tokenId) {
-                nft.setIsListed(false);
-                found = true;
-            } else {
-                newListedNFTs.push_back(nft);
+        TokenId tokenId = TokenId::lookup(tokenText);
+        std::lock_guard<std::mutex> tokenGuard(tokenLock(tokenId));
+        {
+            AccountGuard account(seller);
+            {
+                std::unique_lock<std::shared_mutex> write(stateMutex);
+                size_t slot = listingIndex.find(tokenId);
+                if (slot == FlatHashIndex<TokenId>::npos) {
+                    throw std::runtime_error("NFT not found");
+                }
+                if (listedNFTs[slot].ownerKey() != Pubkey::lookup(seller.getWalletAddress())) {
+                    throw std::runtime_error("You can only unlist NFTs that you own");
+                }
+
+                std::string collection = listedNFTs[slot].getCollection();
+                removeListingAt(slot);
+                publishView(collection);
             }
+
+            // Back on the shelf in the seller's own records, so it can be listed again
+            if (NFT* userNFT = seller.findOwnedNFT(tokenId)) {
+                userNFT->setIsListed(false);
+            }
+            for (auto& collection : seller.getCollections()) {
+                if (NFT* collectionNFT = collection.findNFT(tokenId)) {
+                    collectionNFT->setIsListed(false);
+                }
+            }
+            WriteBatch batch;
+            seller.stageNFT(batch, seller.getKeypairDir(), tokenId);
+            commitAccounts(batch, "NFT " + tokenId.toString() + " was unlisted");
         }
-        
-        if (!found) {
-            throw std::runtime_error("NFT not found");
-        }
-        
-        listedNFTs = newListedNFTs;
+
+        ByteWriter record;
+        record.putU8(EVENT_UNLIST);
+        record.putString(tokenId.toString());
+        journalEvent(record);
         std::cout << "NFT unlisted successfully" << std::endl;
     }
     catch (const std::exception& e) {
@@ -429,24 +564,117 @@ void Marketplace::unlistNFT(const std::string& tokenId) {
     }
 }
 
-NFT* Marketplace::findNFTByTokenId(const std::string& tokenId) {
-    	for (auto& nft : listedNFTs) {
-        	if (nft.getTokenId() == tokenId) {
-            		return &nft;
-        	}
+std::optional<double> Marketplace::getFloorPrice(const std::string& collection) const {
+    std::shared_ptr<const ListingsView> view = getListingsView();
+    auto entry = view->find(collection);
+    if (entry == view->end()) {
+        return std::nullopt;
+    }
+    return entry->second->floorPrice;
+}
+
+V<OrderBookEntry> Marketplace::getCheapestListings(const std::string& collection, size_t count) const {
+    // The published view answers the usual short queries without locking
+    {
+        std::shared_ptr<const ListingsView> view = getListingsView();
+        auto entry = view->find(collection);
+        if (entry == view->end()) {
+            return V<OrderBookEntry>();
+        }
+        const CollectionListingsView& summary = *entry->second;
+        if (count <= summary.cheapest.size() || summary.cheapest.size() == summary.listingCount) {
+            V<OrderBookEntry> result;
+            for (size_t i = 0; i < count && i < summary.cheapest.size(); i++) {
+                result.push_back(summary.cheapest[i]);
+            }
+            return result;
+        }
+    }
+
+    std::shared_lock<std::shared_mutex> read(stateMutex);
+    auto book = collectionBooks.find(collection);
+    if (book == collectionBooks.end()) {
+        return V<OrderBookEntry>();
+    }
+    return book->second.cheapest(count);
+}
+
+// Count and total come from a column scan; the lowest price is the first order book entry in range
+ListingStats Marketplace::getListingStats(double minPrice, double maxPrice, const std::string& collection) const {
+    std::shared_lock<std::shared_mutex> read(stateMutex);
+    const OrderBook* book = &allListings;
+    ListingStats stats;
+    if (collection.empty()) {
+        stats = listingColumns.stats(minPrice, maxPrice);
+    } else {
+        auto found = collectionBooks.find(collection);
+        if (found == collectionBooks.end()) {
+            return stats;
+        }
+        book = &found->second;
+        stats = listingColumns.collectionStats(listingColumns.collectionKey(collection), minPrice, maxPrice);
+    }
+    V<OrderBookEntry> lowest = book->priceRange(minPrice, maxPrice, 1);
+    if (!lowest.empty()) {
+        stats.minPrice = lowest[0].price;
+    }
+    return stats;
+}
+
+ListingStats Marketplace::getOwnerListingStats(const std::string& ownerAddress) const {
+    Pubkey owner = Pubkey::lookup(ownerAddress);
+    std::shared_lock<std::shared_mutex> read(stateMutex);
+    return listingColumns.ownerStats(listingColumns.ownerKey(owner));
+}
+
+ListingPage Marketplace::getListingsPage(const std::string& collection, double minPrice, double maxPrice,
+                                         ListingSort sort, const std::optional<OrderBookEntry>& after,
+                                         size_t limit) const {
+    ListingPage result;
+    limit = std::min(limit, MAX_PAGE_SIZE);
+    if (limit == 0) {
+        return result;
+    }
+
+    std::shared_lock<std::shared_mutex> read(stateMutex);
+    const OrderBook* book = &allListings;
+    if (!collection.empty()) {
+        auto found = collectionBooks.find(collection);
+        if (found == collectionBooks.end()) {
+            return result;
+        }
+        book = &found->second;
+    }
+
+    OrderBookPage page = book->page(sort, minPrice, maxPrice, after, limit);
+    result.next = page.next;
+    result.items.reserve(page.entries.size());
+    for (const auto& entry : page.entries) {
+        result.items.push_back(listedNFTs[listingIndex.find(entry.tokenId)]);
+    }
+    return result;
+}
+
+// A copy: a pointer into listedNFTs would dangle as soon as the lock is released
+std::optional<NFT> Marketplace::findNFTByTokenId(const std::string& tokenId) const {
+    	std::shared_lock<std::shared_mutex> read(stateMutex);
+    	size_t slot = listingIndex.find(TokenId::lookup(tokenId));
+    	if (slot == FlatHashIndex<TokenId>::npos) {
+        	return std::nullopt;
     	}
-    	return nullptr;
+    	return listedNFTs[slot];
 }
 
 
 void Marketplace::displayTransactionHistory() const {
     try {
-        if (transactionHistory.empty()) {
+        std::shared_lock<std::shared_mutex> read(stateMutex);
+        if (transactions.empty()) {
             std::cout << "\nNo transactions recorded." << std::endl;
             return;
         }
 
-        for (const auto& tx : transactionHistory) {
+        for (const auto& tx : transactions) {
             tx.displayTransaction();
         }
     }
@@ -456,178 +684,326 @@ void Marketplace::displayTransactionHistory() const {
 }
 
 void Marketplace::recordTransaction(const Transaction& transaction) {
-    transactionHistory.push_back(transaction);
+    std::unique_lock<std::shared_mutex> write(stateMutex);
+    appendTransaction(transaction);
 }
 
-const Transaction* Marketplace::getTransaction(const std::string& transactionId) const {
-    for (const auto& tx : transactionHistory) {
-        if (tx.getTransactionId() == transactionId) {
-            return &tx;
-        }
+// Skips ids already recorded, so replaying the journal over a snapshot is harmless
+void Marketplace::appendTransaction(const Transaction& transaction) {
+    transactions.append(transaction);
+}
+
+std::optional<Transaction> Marketplace::getTransaction(const std::string& transactionId) const {
+    std::shared_lock<std::shared_mutex> read(stateMutex);
+    const Transaction* tx = transactions.find(transactionId);
+    if (!tx) {
+        return std::nullopt;
+    }
+    return *tx;
+}
+
+TransactionPage Marketplace::getTransactions(std::optional<uint64_t> cursor, size_t limit) const {
+    std::shared_lock<std::shared_mutex> read(stateMutex);
+    return transactions.all(cursor, std::min(limit, MAX_PAGE_SIZE));
+}
+
+TransactionPage Marketplace::getWalletTransactions(const std::string& walletAddress,
+                                                   std::optional<uint64_t> cursor, size_t limit) const {
+    Pubkey wallet = Pubkey::lookup(walletAddress);
+    if (wallet.empty()) {
+        return TransactionPage();
     }
-    return nullptr;
+    std::shared_lock<std::shared_mutex> read(stateMutex);
+    return transactions.forWallet(wallet, cursor, std::min(limit, MAX_PAGE_SIZE));
+}
+
+TransactionPage Marketplace::getProvenance(const std::string& tokenId, std::optional<uint64_t> cursor,
+                                           size_t limit) const {
+    TokenId token = TokenId::lookup(tokenId);
+    if (token.empty()) {
+        return TransactionPage();
+    }
+    std::shared_lock<std::shared_mutex> read(stateMutex);
+    return transactions.forToken(token, cursor, std::min(limit, MAX_PAGE_SIZE));
 }
 
 void Marketplace::saveMarketplaceData() {
+    std::lock_guard<std::mutex> compaction(compactionMutex);
+    compact();
+}
+
+// The listings are copied and the journal's position noted under one shared
+// lock, so the copy covers exactly the records before that position. Files are
+// written outside the lock; sales only wait for the copy, and for the
+// transactions, which are append-only and read a chunk per lock. Events
+// journaled meanwhile stay in the journal and replay over the new snapshot.
+// Expects compactionMutex held.
+void Marketplace::compact() {
     try {
+        openJournal();
+        V<NFT> listings;
+        size_t transactionCount;
+        MarketplaceJournal::Mark covered;
+        {
+            std::shared_lock<std::shared_mutex> read(stateMutex);
+            covered = journal.mark();
+            listings = listedNFTs;
+            transactionCount = transactions.size();
+        }
+
         // Create marketplace directory if it doesn't exist
-        std::string mkdir_cmd = "mkdir -p marketplace";
-        system(mkdir_cmd.c_str());
+        std::filesystem::create_directories("marketplace");
+
+        // One reused buffer for both files
+        thread_local JsonWriter json(true);
 
         // Save listed NFTs
-        std::string listings_path = "marketplace/listings.json";
-        std::ofstream listings_file(listings_path);
-        if (listings_file.is_open()) {
-            listings_file << "{\n";
-            listings_file << "  \"listings\": [\n";
-            
-            for (size_t i = 0; i < listedNFTs.size(); i++) {
-                const auto& nft = listedNFTs[i];
-                listings_file << "    {\n";
-                listings_file << "      \"tokenId\": \"" << nft.getTokenId() << "\",\n";
-                listings_file << "      \"name\": \"" << nft.getName() << "\",\n";
-                listings_file << "      \"owner\": \"" << nft.getOwner() << "\",\n";
-                listings_file << "      \"price\": " << nft.getPrice() << ",\n";
-                listings_file << "      \"isListed\": " << (nft.getIsListed() ? "true" : "false") << ",\n";
-                listings_file << "      \"mintAddress\": \"" << nft.getMintAddress() << "\",\n";
-                listings_file << "      \"metadataUri\": \"" << nft.getMetadataUri() << "\"\n";
-                listings_file << "    }";
-                if (i < listedNFTs.size() - 1) listings_file << ",";
-                listings_file << "\n";
-            }
-            
-            listings_file << "  ]\n";
-            listings_file << "}";
-            listings_file.close();
+        json.clear();
+        json.beginObject().key("listings").beginArray();
+        for (const auto& nft : listings) {
+            json.beginObject()
+                .field("tokenId", nft.getTokenId())
+                .field("name", nft.getName())
+                .field("owner", nft.getOwner())
+                .field("price", nft.getPrice())
+                .field("isListed", nft.getIsListed())
+                .field("mintAddress", nft.getMintAddress())
+                .field("metadataUri", nft.getMetadataUri())
+                .field("collection", nft.getCollection())
+                .endObject();
         }
-
-        // Save transaction history
-        std::string transactions_path = "marketplace/transactions.json";
-        std::ofstream transactions_file(transactions_path);
-        if (transactions_file.is_open()) {
-            transactions_file << "{\n";
-            transactions_file << "  \"transactions\": [\n";
-            
-            for (size_t i = 0; i < transactionHistory.size(); i++) {
-                const auto& tx = transactionHistory[i];
-                transactions_file << "    {\n";
-                transactions_file << "      \"transactionId\": \"" << tx.getTransactionId() << "\",\n";
-                transactions_file << "      \"tokenId\": \"" << tx.getTokenId() << "\",\n";
-                transactions_file << "      \"seller\": \"" << tx.getSeller() << "\",\n";
-                transactions_file << "      \"buyer\": \"" << tx.getBuyer() << "\",\n";
-                transactions_file << "      \"price\": " << tx.getPrice() << ",\n";
-                transactions_file << "      \"timestamp\": \"" << tx.getTimestamp() << "\",\n";
-                transactions_file << "      \"status\": \"" << tx.getStatus() << "\"\n";
-                transactions_file << "    }";
-                if (i < transactionHistory.size() - 1) transactions_file << ",";
-                transactions_file << "\n";
+        json.endArray().endObject();
+        writeFileAtomic("marketplace/listings.json", json.str());
+
+        // Save transaction history, up to where the copy above was taken
+        json.clear();
+        json.beginObject().key("transactions").beginArray();
+        for (size_t from = 0; from < transactionCount; from += COMPACT_CHUNK) {
+            std::shared_lock<std::shared_mutex> read(stateMutex);
+            const Transaction* chunk = transactions.begin() + from;
+            const Transaction* chunkEnd = transactions.begin() + std::min(transactionCount, from + COMPACT_CHUNK);
+            for (const Transaction* tx = chunk; tx != chunkEnd; ++tx) {
+                json.beginObject()
+                    .field("transactionId", tx->getTransactionId())
+                    .field("tokenId", tx->getTokenId())
+                    .field("seller", tx->getSeller())
+                    .field("buyer", tx->getBuyer())
+                    .field("price", tx->getPrice())
+                    .field("timestamp", tx->getTimestamp())
+                    .field("status", tx->getStatus())
+                    .endObject();
             }
-            
-            transactions_file << "  ]\n";
-            transactions_file << "}";
-            transactions_file.close();
         }
+        json.endArray().endObject();
+        writeFileAtomic("marketplace/transactions.json", json.str());
+
+        // The snapshot now covers every record before the mark
+        journal.truncate(covered);
     } catch (const std::exception& e) {
         std::cerr << "Error saving marketplace data: " << e.what() << std::endl;
     }
 }
 
+void Marketplace::addToSnapshot(SnapshotBuilder& builder) const {
+    std::shared_lock<std::shared_mutex> read(stateMutex);
+    for (const auto& nft : listedNFTs) {
+        builder.addListing(nft.toSnapshot(builder));
+    }
+    for (const auto& tx : transactions) {
+        builder.addTransaction(tx.toSnapshot(builder));
+    }
+}
+
+// Same end state as loadMarketplaceData, read from a mapped image. The
+// records are decoded before anything is applied, so a damaged image
+// throws without leaving a half-loaded marketplace.
+void Marketplace::loadFromSnapshot(const SnapshotImage& image) {
+    V<NFT> listings;
+    listings.reserve(image.listings().size());
+    for (const auto& record : image.listings()) {
+        listings.push_back(NFT::fromSnapshot(image, record));
+    }
+    V<Transaction> recorded;
+    recorded.reserve(image.transactions().size());
+    for (const auto& record : image.transactions()) {
+        recorded.push_back(Transaction::fromSnapshot(image, record));
+    }
+
+    std::unique_lock<std::shared_mutex> write(stateMutex);
+    listedNFTs.reserve(listings.size());
+    listingIndex.reserve(listings.size());
+    listingColumns.reserve(listings.size());
+    for (const auto& nft : listings) {
+        if (!listingIndex.contains(nft.id())) {
+            addListing(nft);
+        }
+    }
+    transactions.reserve(recorded.size());
+    for (const auto& tx : recorded) {
+        appendTransaction(tx);
+    }
+
+    // Normally empty; covers an exit where the JSON snapshot failed to save
+    openJournal();
+    size_t replayed = journal.replay([this](ByteReader& reader) {
+        applyJournalRecord(reader);
+    });
+    publishAllViews();
+    std::cout << "Marketplace: " << listedNFTs.size() << " listings, " << transactions.size()
+              << " transactions (" << replayed << " journal records replayed)" << std::endl;
+}
+
 void Marketplace::loadMarketplaceData() {
     try {
+        std::unique_lock<std::shared_mutex> write(stateMutex);
+
         // Load listed NFTs
         std::string listings_path = "marketplace/listings.json";
-        std::cout << "DEBUG: Loading marketplace data from: " << listings_path << std::endl;
-        std::ifstream listings_file(listings_path);
-        if (listings_file.is_open()) {
-            std::string line;
-            bool inListings = false;
-            bool inNFT = false;
-            
-            std::string tokenId, name, owner, mintAddress, metadataUri;
+        {
+            std::string tokenId, name, owner, mintAddress, metadataUri, collection;
             double price = 0.0;
             bool isListed = false;
+            JsonFields fields;
+            fields.bind("tokenId", tokenId);
+            fields.bind("name", name);
+            fields.bind("owner", owner);
+            fields.bind("price", price);
+            fields.bind("isListed", isListed);
+            fields.bind("mintAddress", mintAddress);
+            fields.bind("metadataUri", metadataUri);
+            fields.bind("collection", collection);
+
+            JsonRecordHandler listings(fields, 3, [&]() {
+                // Complete NFT - use constructor with explicit tokenId
+                NFT nft(tokenId, name, owner, price, isListed, metadataUri);
+                // Set mint address separately since constructor doesn't handle it
+                nft.setMintAddress(mintAddress);
+                nft.setCollection(collection);
+                if (!listingIndex.contains(nft.id())) {
+                    addListing(nft);
+                }
+            });
+            try {
+                parseJsonFile(listings_path, listings);
+            } catch (const std::exception& e) {
+                // Keep going: the journal can still bring the rest back
+                std::cerr << "Error loading " << listings_path << ": " << e.what() << std::endl;
+            }
+        }
 
-            while (std::getline(listings_file, line)) {
-                // Remove whitespace
-                line.erase(0, line.find_first_not_of(" \t"));
-                if (line.empty()) continue;
-
-                if (line.find("\"listings\":") != std::string::npos) {
-                    inListings = true;
-                } else if (line.find("\"tokenId\":") != std::string::npos && inNFT) {
-                    size_t start = line.find("\"", line.find(":"));
-                    size_t end = line.find("\"", start + 1);
-                    if (start != std::string::npos && end != std::string::npos) {
-                        tokenId = line.substr(start + 1, end - start - 1);
-                    }
-                } else if (line.find("\"name\":") != std::string::npos && inNFT) {
-                    size_t start = line.find("\"", line.find(":"));
-                    size_t end = line.find("\"", start + 1);
-                    if (start != std::string::npos && end != std::string::npos) {
-                        name = line.substr(start + 1, end - start - 1);
-                    }
-                } else if (line.find("\"owner\":") != std::string::npos && inNFT) {
-                    size_t start = line.find("\"", line.find(":"));
-                    size_t end = line.find("\"", start + 1);
-                    if (start != std::string::npos && end != std::string::npos) {
-                        owner = line.substr(start + 1, end - start - 1);
-                    }
-                } else if (line.find("\"price\":") != std::string::npos && inNFT) {
-                    size_t colonPos = line.find(":");
-                    if (colonPos != std::string::npos) {
-                        std::string priceStr = line.substr(colonPos + 1);
-                        if (!priceStr.empty() && priceStr.back() == ',') {
-                            priceStr.pop_back();
-                        }
-                        price = std::stod(priceStr);
-                    }
-                } else if (line.find("\"isListed\":") != std::string::npos && inNFT) {
-                    if (line.find("true") != std::string::npos) {
-                        isListed = true;
-                    }
-                } else if (line.find("\"mintAddress\":") != std::string::npos && inNFT) {
-                    size_t start = line.find("\"", line.find(":"));
-                    size_t end = line.find("\"", start + 1);
-                    if (start != std::string::npos && end != std::string::npos) {
-                        mintAddress = line.substr(start + 1, end - start - 1);
+        // Load transaction history
+        std::string transactions_path = "marketplace/transactions.json";
+        {
+            std::string transactionId, tokenId, seller, buyer, timestamp, status;
+            double price = 0.0;
+            JsonFields fields;
+            fields.bind("transactionId", transactionId);
+            fields.bind("tokenId", tokenId);
+            fields.bind("seller", seller);
+            fields.bind("buyer", buyer);
+            fields.bind("price", price);
+            fields.bind("timestamp", timestamp);
+            fields.bind("status", status);
+
+            JsonRecordHandler transactions(fields, 3, [&]() {
+                appendTransaction(Transaction(transactionId, tokenId, seller, buyer, price, timestamp, status));
+            });
+            try {
+                parseJsonFile(transactions_path, transactions);
+            } catch (const std::exception& e) {
+                std::cerr << "Error loading " << transactions_path << ": " << e.what() << std::endl;
+            }
+        }
+
+        // Replay events recorded after the snapshot was taken
+        openJournal();
+        size_t replayed = journal.replay([this](ByteReader& reader) {
+            applyJournalRecord(reader);
+        });
+        publishAllViews();
+        std::cout << "Marketplace: " << listedNFTs.size() << " listings, " << transactions.size()
+                  << " transactions (" << replayed << " journal records replayed)" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading marketplace data: " << e.what() << std::endl;
+    }
+}
+
+void Marketplace::reconcileWithAccounts() {
+    try {
+        // What the accounts themselves have listed
+        std::unordered_map<TokenId, NFT> listedByAccounts;
+        for (UserAccount& account : userTable()) {
+            AccountGuard guard(account);
+            for (const auto& collection : account.getCollections()) {
+                for (const auto& nft : collection.getNFTs()) {
+                    if (nft.getIsListed()) {
+                        listedByAccounts.emplace(nft.id(), nft);
                     }
-                } else if (line.find("\"metadataUri\":") != std::string::npos && inNFT) {
-                    size_t start = line.find("\"", line.find(":"));
-                    size_t end = line.find("\"", start + 1);
-                    if (start != std::string::npos && end != std::string::npos) {
-                        metadataUri = line.substr(start + 1, end - start - 1);
+                }
+            }
+        }
+
+        V<ByteWriter> repairs;
+        size_t dropped = 0, recovered = 0, restored = 0;
+        {
+            std::unique_lock<std::shared_mutex> write(stateMutex);
+            // Backwards, so the listing swapped into a freed slot has already been looked at
+            for (size_t slot = listedNFTs.size(); slot-- > 0;) {
+                std::string owner = listedNFTs[slot].getOwner();
+                if (!UserAccount::findUserByWallet(owner)) {
+                    continue; // "MARKETPLACE" and other owners without an account
+                }
+                auto account = listedByAccounts.find(listedNFTs[slot].id());
+                if (account != listedByAccounts.end() && account->second.getOwner() == owner) {
+                    continue;
+                }
+
+                // Sold or taken down, and the journal never heard of it
+                TokenId tokenId = removeListingAt(slot).id();
+                dropped++;
+                ByteWriter record;
+                std::string saleText;
+                if (accountStore().get(SALE_PREFIX + tokenId.toString(), saleText)) {
+                    ByteReader reader(saleText.data(), saleText.size());
+                    Transaction tx = decodeTransaction(reader);
+                    if (reader.ok() && tx.getSeller() == owner && !transactions.find(tx.getTransactionId())) {
+                        appendTransaction(tx);
+                        record.putU8(EVENT_BUY);
+                        encodeTransaction(record, tx);
+                        repairs.push_back(std::move(record));
+                        recovered++;
+                        continue;
                     }
-                } else if (line.find("{") != std::string::npos && inListings && !inNFT) {
-                    inNFT = true;
-                    tokenId = "";
-                    name = "";
-                    owner = "";
-                    price = 0.0;
-                    isListed = false;
-                    mintAddress = "";
-                    metadataUri = "";
-                } else if (line.find("}") != std::string::npos && inNFT) {
-                    // Complete NFT - use constructor with explicit tokenId
-                    NFT nft(tokenId, name, owner, price, isListed, metadataUri);
-                    // Set mint address separately since constructor doesn't handle it
-                    nft.setMintAddress(mintAddress);
-                    std::cout << "DEBUG: Loaded marketplace NFT: tokenId='" << tokenId << "', name='" << name << "', owner='" << owner << "', price=" << price << std::endl;
-                    listedNFTs.push_back(nft);
-                    inNFT = false;
                 }
+                record.putU8(EVENT_UNLIST);
+                record.putString(tokenId.toString());
+                repairs.push_back(std::move(record));
+            }
+
+            // Listed in the account, but the listing never reached the journal
+            for (const auto& entry : listedByAccounts) {
+                if (!listingIndex.contains(entry.first)) {
+                    addListing(entry.second);
+                    ByteWriter record;
+                    record.putU8(EVENT_LIST);
+                    encodeNFT(record, entry.second);
+                    repairs.push_back(std::move(record));
+                    restored++;
+                }
+            }
+            if (!repairs.empty()) {
+                publishAllViews();
             }
-            listings_file.close();
         }
 
-        // Load transaction history (simplified - just count for now)
-        std::string transactions_path = "marketplace/transactions.json";
-        std::ifstream transactions_file(transactions_path);
-        if (transactions_file.is_open()) {
-            // For now, just acknowledge that transactions exist
-            // Full transaction loading can be implemented later
-            transactions_file.close();
+        if (!repairs.empty()) {
+            for (const auto& record : repairs) {
+                journalEvent(record);
+            }
+            std::cout << "Marketplace: reconciled with accounts (" << dropped << " listings dropped, "
+                      << recovered << " of them sales recovered, " << restored << " listings restored)" << std::endl;
         }
     } catch (const std::exception& e) {
-        std::cerr << "Error loading marketplace data: " << e.what() << std::endl;
+        std::cerr << "Error reconciling marketplace with accounts: " << e.what() << std::endl;
     }
 }
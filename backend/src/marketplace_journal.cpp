@@ -0,0 +1,227 @@
+#include "../include/marketplace_journal.hpp"
+#include "../include/crc32.hpp"
+#include "../include/file_util.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+    const char JOURNAL_MAGIC[8] = {'M', 'K', 'T', 'J', 'R', 'N', 'L', '1'};
+    const size_t FRAME_HEADER = 8;
+    const uint32_t MAX_RECORD = 16 * 1024 * 1024;
+
+    uint32_t readU32(const unsigned char* p) {
+        return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+               (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+    void writeU32(std::string& out, uint32_t value) {
+        for (int i = 0; i < 4; i++) {
+            out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+        }
+    }
+}
+
+MarketplaceJournal::~MarketplaceJournal() {
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+void MarketplaceJournal::open(const std::string& journalPath) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    path = journalPath;
+    openLocked();
+}
+
+void MarketplaceJournal::openLocked() {
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open journal " + path + ": " + std::strerror(errno));
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        throw std::runtime_error("Cannot stat journal " + path);
+    }
+    if (st.st_size == 0) {
+        writeAll(std::string(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)));
+        ::fsync(fd);
+        fileBytes = sizeof(JOURNAL_MAGIC);
+    } else {
+        fileBytes = static_cast<uint64_t>(st.st_size);
+    }
+    ::lseek(fd, 0, SEEK_END);
+}
+
+void MarketplaceJournal::writeAll(const std::string& data) {
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("Journal write failed: " + std::string(std::strerror(errno)));
+        }
+        written += static_cast<size_t>(n);
+    }
+}
+
+size_t MarketplaceJournal::replay(const std::function<void(ByteReader&)>& apply) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (fd < 0) {
+        throw std::runtime_error("Journal is not open");
+    }
+
+    std::vector<unsigned char> contents(fileBytes);
+    ssize_t n = ::pread(fd, contents.data(), contents.size(), 0);
+    if (n < 0 || static_cast<uint64_t>(n) != fileBytes) {
+        throw std::runtime_error("Cannot read journal " + path);
+    }
+    if (fileBytes < sizeof(JOURNAL_MAGIC) ||
+        std::memcmp(contents.data(), JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0) {
+        throw std::runtime_error("Not a marketplace journal: " + path);
+    }
+
+    size_t offset = sizeof(JOURNAL_MAGIC);
+    size_t replayed = 0;
+    while (offset + FRAME_HEADER <= contents.size()) {
+        uint32_t length = readU32(&contents[offset]);
+        uint32_t checksum = readU32(&contents[offset + 4]);
+        if (length > MAX_RECORD || offset + FRAME_HEADER + length > contents.size()) {
+            break;
+        }
+        const unsigned char* payload = &contents[offset + FRAME_HEADER];
+        if (crc32(payload, length) != checksum) {
+            break;
+        }
+        ByteReader reader(payload, length);
+        apply(reader);
+        offset += FRAME_HEADER + length;
+        replayed++;
+    }
+
+    // Anything past the last good frame is a torn write from a crash
+    if (offset != contents.size()) {
+        if (::ftruncate(fd, static_cast<off_t>(offset)) != 0) {
+            throw std::runtime_error("Cannot truncate journal tail: " + path);
+        }
+        ::fsync(fd);
+        fileBytes = offset;
+    }
+    ::lseek(fd, 0, SEEK_END);
+    recordCount = replayed;
+    return replayed;
+}
+
+void MarketplaceJournal::append(const ByteWriter& record) {
+    std::string frame;
+    frame.reserve(FRAME_HEADER + record.size());
+    writeU32(frame, static_cast<uint32_t>(record.size()));
+    writeU32(frame, crc32(record.str().data(), record.size()));
+    frame.append(record.str());
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (fd < 0) {
+        throw std::runtime_error("Journal is not open");
+    }
+    pending.append(frame);
+    uint64_t mySeq = ++appendedSeq;
+
+    while (durableSeq < mySeq) {
+        if (mySeq <= failedSeq) {
+            throw std::runtime_error("Journal flush failed");
+        }
+        if (flushing) {
+            // Someone else is writing; our record goes out with the next batch
+            flushed.wait(lock);
+            continue;
+        }
+
+        // Become the leader: write everything queued so far with one fsync
+        flushing = true;
+        std::string batch;
+        batch.swap(pending);
+        uint64_t batchSeq = appendedSeq;
+        lock.unlock();
+
+        bool ok = true;
+        std::string error;
+        try {
+            writeAll(batch);
+            if (::fsync(fd) != 0) {
+                ok = false;
+                error = std::strerror(errno);
+            }
+        } catch (const std::exception& e) {
+            ok = false;
+            error = e.what();
+        }
+
+        lock.lock();
+        flushing = false;
+        if (ok) {
+            recordCount += batchSeq - durableSeq;
+            durableSeq = batchSeq;
+            fileBytes += batch.size();
+        } else {
+            // Fail the whole batch and drop any partial write so later frames stay readable
+            failedSeq = batchSeq;
+            if (::ftruncate(fd, static_cast<off_t>(fileBytes)) == 0) {
+                ::lseek(fd, 0, SEEK_END);
+            }
+        }
+        flushed.notify_all();
+        if (!ok) {
+            throw std::runtime_error("Journal flush failed: " + error);
+        }
+    }
+}
+
+MarketplaceJournal::Mark MarketplaceJournal::mark() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return Mark{fileBytes, recordCount};
+}
+
+void MarketplaceJournal::truncate(const Mark& upTo) {
+    std::unique_lock<std::mutex> lock(mutex);
+    // A batch being written would land past the end we copy from
+    flushed.wait(lock, [this] { return !flushing; });
+    if (fd < 0 || upTo.bytes <= sizeof(JOURNAL_MAGIC) || upTo.bytes > fileBytes) {
+        return;
+    }
+
+    if (upTo.bytes == fileBytes) {
+        // Nothing appended since the mark: just cut the file back to its header
+        if (::ftruncate(fd, static_cast<off_t>(sizeof(JOURNAL_MAGIC))) != 0) {
+            throw std::runtime_error("Cannot truncate journal " + path);
+        }
+        ::fsync(fd);
+    } else {
+        std::string contents(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+        size_t tailStart = contents.size();
+        contents.resize(tailStart + (fileBytes - upTo.bytes));
+        ssize_t n = ::pread(fd, &contents[tailStart], fileBytes - upTo.bytes, static_cast<off_t>(upTo.bytes));
+        if (n < 0 || static_cast<uint64_t>(n) != fileBytes - upTo.bytes) {
+            throw std::runtime_error("Cannot read journal " + path);
+        }
+        writeFileAtomic(path, contents);
+        int replaced = ::open(path.c_str(), O_RDWR);
+        if (replaced < 0) {
+            throw std::runtime_error("Cannot reopen journal " + path + ": " + std::strerror(errno));
+        }
+        ::close(fd);
+        fd = replaced;
+    }
+    ::lseek(fd, 0, SEEK_END);
+    fileBytes = sizeof(JOURNAL_MAGIC) + (fileBytes - upTo.bytes);
+    recordCount -= std::min(recordCount, upTo.records);
+}
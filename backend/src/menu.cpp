@@ -1,13 +1,8 @@
 #include "../include/header.hpp"
 
-void menu(std::vector<UserAccount>& users, std::vector<NFT>& nfts, std::vector<Collection>& collections) {
+void menu(UserTable& users, std::vector<NFT>& nfts, std::vector<Collection>& collections) {
     int choice = 0;
     Marketplace* marketplace = Marketplace::getInstance();
-    V<UserAccount*> userPointers;
-    for (auto& user : users) {
-        userPointers.push_back(&user);
-    }
-    UserAccount::setAllUsers(userPointers);
 
     // Ensure streams are properly initialized
     std::cin.clear();
@@ -16,6 +11,9 @@ void menu(std::vector<UserAccount>& users, std::vector<NFT>& nfts, std::vector<C
     std::cout << "Welcome to the NFT store!\n" << std::endl; 
 
     while (true) {
+        // Pick up mints that finished while the user was busy
+        UserAccount::applyCompletedMints();
+
         // Display menu options
         std::cout << "1 - create a new account\n"
                   << "2 - login to an existing account\n"
@@ -65,7 +63,7 @@ void menu(std::vector<UserAccount>& users, std::vector<NFT>& nfts, std::vector<C
                     break;
                 }
                 case 2: 
-                    UserAccount::login(users);
+                    UserAccount::login();
                     break;
                 case 3:
                     UserAccount::logout();
@@ -97,13 +95,16 @@ void menu(std::vector<UserAccount>& users, std::vector<NFT>& nfts, std::vector<C
                     std::cout << "\nYour NFTs:" << std::endl;
                     bool hasNFTs = false;
 
-                    for (const auto& collection : UserAccount::getCurrentUser()->getCollections()) {
-                        std::cout << "Checking collection: " << collection.getName() << std::endl;
-                        const V<NFT>& collectionNFTs = collection.getNFTs();
-                        for (const auto& nft : collectionNFTs) {
-                            if (!nft.getIsListed()) {
-                                nft.displayDetails();
-                                hasNFTs = true;
+                    {
+                        AccountGuard account(*UserAccount::getCurrentUser());
+                        for (const auto& collection : UserAccount::getCurrentUser()->getCollections()) {
+                            std::cout << "Checking collection: " << collection.getName() << std::endl;
+                            const V<NFT>& collectionNFTs = collection.getNFTs();
+                            for (const auto& nft : collectionNFTs) {
+                                if (!nft.getIsListed()) {
+                                    nft.displayDetails();
+                                    hasNFTs = true;
+                                }
                             }
                         }
                     }
@@ -124,22 +125,11 @@ void menu(std::vector<UserAccount>& users, std::vector<NFT>& nfts, std::vector<C
                     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
 
                     try {
-                        bool found = false;
-                        for (auto& collection : UserAccount::getCurrentUser()->getCollections()) {
-                            V<NFT>& collectionNFTs = collection.getNFTs();
-                            for (auto& nft : collectionNFTs) {
-                                if (nft.getTokenId() == tokenId) {
-                                    marketplace->listNFT(nft, price);
-                                    found = true;
-                                    std::cout << "NFT listed successfully!" << std::endl;
-                                    break;
-                                }
-                            }
-                            if (found) break;
-                        }
-
-                        if (!found) {
-                            std::cout << "NFT not found with token ID: " << tokenId << std::endl;
+                        // Finds the NFT in the user's collections itself, under their account lock
+                        if (marketplace->listNFT(tokenId, price, *UserAccount::getCurrentUser())) {
+                            std::cout << "NFT listed successfully!" << std::endl;
+                        } else {
+                            std::cout << "NFT could not be listed: " << tokenId << std::endl;
                         }
                     } catch (const std::exception& e) {
                         std::cout << "Error: " << e.what() << std::endl;
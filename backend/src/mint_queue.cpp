@@ -0,0 +1,74 @@
+#include "../include/mint_queue.hpp"
+#include "../include/solana_integration.hpp"
+#include <cstdlib>
+#include <ctime>
+
+MintQueue::MintQueue(size_t workerCount, size_t maxOutstanding, const std::string& directory)
+    : workDir(directory),
+      runId(std::to_string(std::time(nullptr))),
+      capacity(maxOutstanding == 0 ? 1 : maxOutstanding),
+      workers(workerCount) {}
+
+MintResult MintQueue::run(uint64_t jobId, const MintRequest& request) {
+    MintResult result;
+    result.jobId = jobId;
+    result.tokenId = request.tokenId;
+    result.owner = request.owner;
+    try {
+        std::string jobDir = workDir + "/" + runId + "-" + std::to_string(jobId);
+        result.mintAddress = SolanaIntegration::mintNFT(request.metadata, jobDir);
+        // Minting spent fees from the owner's wallet
+        balanceCache().invalidate(request.owner);
+    } catch (const std::exception& e) {
+        result.mintAddress.clear();
+        result.error = e.what();
+    }
+    return result;
+}
+
+MintQueue::Ticket MintQueue::submit(MintRequest request) {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this] { return outstanding < capacity; });
+        outstanding++;
+    }
+
+    uint64_t jobId = nextJobId++;
+    std::future<MintResult> future = workers.submit([this, jobId, request = std::move(request)] {
+        MintResult result = run(jobId, request);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            completed.push_back(result);
+            outstanding--;
+        }
+        changed.notify_all();
+        return result;
+    });
+    return Ticket{jobId, future.share()};
+}
+
+std::vector<MintResult> MintQueue::takeCompleted() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<MintResult> done;
+    done.swap(completed);
+    return done;
+}
+
+size_t MintQueue::pending() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return outstanding;
+}
+
+void MintQueue::waitIdle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this] { return outstanding == 0; });
+}
+
+MintQueue& mintQueue() {
+    static MintQueue queue([] {
+        const char* workers = std::getenv("MINT_WORKERS");
+        long count = workers && *workers ? std::strtol(workers, nullptr, 10) : 4;
+        return static_cast<size_t>(count < 1 ? 1 : count);
+    }(), 256);
+    return queue;
+}
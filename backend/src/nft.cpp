@@ -48,6 +48,8 @@ void UserAccount::viewOwnedNFTs() {
         return;
     }
 
+    // A sale through the API could otherwise reshuffle the list mid-print
+    AccountGuard account(*currentUser);
     const V<NFT>& ownedNFTs = currentUser->getOwnedNFTs();
     
     if (ownedNFTs.empty()) {
@@ -101,5 +103,33 @@ void UserAccount::viewOwnedNFTs() {
     std::cout << "Listed for sale: " << listedCount << " NFTs" << std::endl;
     std::cout << "Not listed: " << notListedCount << " NFTs" << std::endl;
     std::cout << "Total estimated value: " << totalValue << " SOL" << std::endl;
+    // What the marketplace actually has up for this wallet, from its column scan
+    ListingStats live = Marketplace::getInstance()->getOwnerListingStats(currentUser->getWalletAddress());
+    std::cout << "Live marketplace listings: " << live.count;
+    if (live.count > 0) {
+        std::cout << " (" << live.totalPrice << " SOL, lowest " << live.minPrice << " SOL)";
+    }
+    std::cout << std::endl;
     std::cout << "================\n" << std::endl;
 }
+
+SnapshotNFT NFT::toSnapshot(SnapshotBuilder& builder) const {
+	SnapshotNFT record{};
+	record.tokenId = builder.intern(tokenId.toString());
+	record.name = builder.intern(name);
+	record.owner = builder.intern(owner.toString());
+	record.mintAddress = builder.intern(mintAddress);
+	record.metadataUri = builder.intern(metadataUri);
+	record.collection = builder.intern(collection);
+	record.isListed = isListed ? 1 : 0;
+	record.price = price;
+	return record;
+}
+
+NFT NFT::fromSnapshot(const SnapshotImage& image, const SnapshotNFT& record) {
+	NFT nft(image.text(record.tokenId), image.text(record.name), image.text(record.owner),
+		record.price, record.isListed != 0, image.text(record.metadataUri));
+	nft.mintAddress = image.text(record.mintAddress);
+	nft.collection = image.text(record.collection);
+	return nft;
+}
@@ -0,0 +1,119 @@
+#include "../include/order_book.hpp"
+#include <iterator>
+
+void OrderBook::add(TokenId tokenId, double price, uint64_t listedSeq) {
+    remove(tokenId);
+    auto it = entries.insert(OrderBookEntry{price, listedSeq, tokenId}).first;
+    byToken[tokenId] = it;
+    bySeq[listedSeq] = it;
+}
+
+bool OrderBook::remove(TokenId tokenId) {
+    auto found = byToken.find(tokenId);
+    if (found == byToken.end()) {
+        return false;
+    }
+    bySeq.erase(found->second->listedSeq);
+    entries.erase(found->second);
+    byToken.erase(found);
+    return true;
+}
+
+std::optional<double> OrderBook::floorPrice() const {
+    if (entries.empty()) {
+        return std::nullopt;
+    }
+    return entries.begin()->price;
+}
+
+V<OrderBookEntry> OrderBook::cheapest(size_t n) const {
+    V<OrderBookEntry> result;
+    result.reserve(n < entries.size() ? n : entries.size());
+    for (auto it = entries.begin(); it != entries.end() && result.size() < n; ++it) {
+        result.push_back(*it);
+    }
+    return result;
+}
+
+V<OrderBookEntry> OrderBook::priceRange(double minPrice, double maxPrice, size_t limit) const {
+    V<OrderBookEntry> result;
+    // Seq 0 sorts before every real listing at minPrice
+    auto it = entries.lower_bound(OrderBookEntry{minPrice, 0, TokenId()});
+    for (; it != entries.end() && it->price <= maxPrice && result.size() < limit; ++it) {
+        result.push_back(*it);
+    }
+    return result;
+}
+
+namespace {
+    // Walks listing-order positions [it, end), keeping the entries in range
+    template<typename It>
+    void recencyPage(It it, It end, double minPrice, double maxPrice, size_t limit, OrderBookPage& page) {
+        size_t budget = limit * OrderBook::RECENCY_SCAN_FACTOR;
+        for (size_t scanned = 0; it != end; ++it) {
+            const OrderBookEntry& entry = *it->second;
+            if (entry.price >= minPrice && entry.price <= maxPrice) {
+                if (page.entries.size() == limit) {
+                    page.next = page.entries.back();
+                    return;
+                }
+                page.entries.push_back(entry);
+            }
+            if (++scanned == budget && std::next(it) != end) {
+                page.next = entry;
+                return;
+            }
+        }
+    }
+}
+
+OrderBookPage OrderBook::page(ListingSort sort, double minPrice, double maxPrice,
+                              const std::optional<OrderBookEntry>& after, size_t limit) const {
+    OrderBookPage result;
+    if (limit == 0) {
+        return result;
+    }
+
+    switch (sort) {
+        case ListingSort::PRICE_ASC: {
+            // A cursor below the range starts at the range instead
+            auto it = after && after->price >= minPrice
+                ? entries.upper_bound(*after)
+                : entries.lower_bound(OrderBookEntry{minPrice, 0, TokenId()});
+            for (; it != entries.end() && it->price <= maxPrice; ++it) {
+                if (result.entries.size() == limit) {
+                    result.next = result.entries.back();
+                    break;
+                }
+                result.entries.push_back(*it);
+            }
+            break;
+        }
+        case ListingSort::PRICE_DESC: {
+            auto it = after && after->price <= maxPrice
+                ? entries.lower_bound(*after)
+                : entries.upper_bound(OrderBookEntry{maxPrice, UINT64_MAX, TokenId()});
+            while (it != entries.begin()) {
+                --it;
+                if (it->price < minPrice) break;
+                if (result.entries.size() == limit) {
+                    result.next = result.entries.back();
+                    break;
+                }
+                result.entries.push_back(*it);
+            }
+            break;
+        }
+        case ListingSort::NEWEST: {
+            auto from = after ? bySeq.lower_bound(after->listedSeq) : bySeq.end();
+            recencyPage(std::make_reverse_iterator(from), bySeq.rend(), minPrice, maxPrice, limit, result);
+            break;
+        }
+        case ListingSort::OLDEST: {
+            auto from = after ? bySeq.upper_bound(after->listedSeq) : bySeq.begin();
+            recencyPage(from, bySeq.end(), minPrice, maxPrice, limit, result);
+            break;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,237 @@
+#include "../include/password_hasher.hpp"
+#include <argon2.h>
+#include <algorithm>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <random>
+
+namespace {
+    constexpr uint32_t SALT_LENGTH = 16;
+    constexpr uint32_t HASH_LENGTH = 32;
+    const char ENCODED_PREFIX[] = "$argon2id$";
+
+    // Parameters of the salt+hash hex form written before hashes were encoded
+    constexpr uint32_t LEGACY_TIME_COST = 2;
+    constexpr uint32_t LEGACY_MEMORY_COST = 1 << 16;
+
+    bool decodeHex(const std::string& hex, std::vector<uint8_t>& out) {
+        if (hex.size() % 2 != 0) return false;
+        out.clear();
+        out.reserve(hex.size() / 2);
+        auto nibble = [](char c) -> int {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        };
+        for (size_t i = 0; i < hex.size(); i += 2) {
+            int high = nibble(hex[i]);
+            int low = nibble(hex[i + 1]);
+            if (high < 0 || low < 0) return false;
+            out.push_back(static_cast<uint8_t>((high << 4) | low));
+        }
+        return true;
+    }
+
+    size_t envSize(const char* name, size_t fallback) {
+        const char* value = std::getenv(name);
+        if (!value || !*value) return fallback;
+        long parsed = std::strtol(value, nullptr, 10);
+        return parsed > 0 ? static_cast<size_t>(parsed) : fallback;
+    }
+}
+
+void LatencyHistogram::record(std::chrono::steady_clock::duration elapsed) {
+    uint64_t ms = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+    size_t bucket = 0;
+    while (bucket < BOUNDS_MS.size() && ms > BOUNDS_MS[bucket]) bucket++;
+    counts[bucket]++;
+    totalMs += ms;
+}
+
+PasswordHasher::PasswordHasher(const Options& opts) : options(opts) {
+    unsigned int hardware = std::thread::hardware_concurrency();
+    cores = hardware == 0 ? 4 : hardware;
+    if (options.lanes == 0) options.lanes = 1;
+    if (options.maxParallelism == 0) options.maxParallelism = 1;
+
+    workers.reserve(options.lanes);
+    for (size_t i = 0; i < options.lanes; i++) {
+        workers.emplace_back([this] { workerLoop(); });
+    }
+}
+
+PasswordHasher::~PasswordHasher() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    available.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void PasswordHasher::workerLoop() {
+    using Clock = std::chrono::steady_clock;
+    while (true) {
+        Job job;
+        uint32_t parallelism = 1;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            available.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping && queue.empty()) return;
+            job = std::move(queue.front());
+            queue.pop_front();
+
+            Clock::duration waited = Clock::now() - job.enqueuedAt;
+            if (waited > options.timeout) {
+                timedOut++;
+                lock.unlock();
+                job.fail(std::make_exception_ptr(PasswordHasherBusy("Password check timed out waiting for a free lane")));
+                continue;
+            }
+            queueWait.record(waited);
+
+            // Spare cores go to a new hash only when nobody else is waiting for a lane
+            if (job.adaptive && queue.empty() && cores > busyThreads + 1) {
+                parallelism = static_cast<uint32_t>(std::min<size_t>(options.maxParallelism, cores - busyThreads));
+            }
+            active++;
+            busyThreads += parallelism;
+        }
+
+        Clock::time_point start = Clock::now();
+        try {
+            job.run(parallelism);
+        } catch (...) {
+            job.fail(std::current_exception());
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        active--;
+        busyThreads -= parallelism;
+        completed++;
+        hashTime.record(Clock::now() - start);
+    }
+}
+
+void PasswordHasher::enqueue(Job job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) {
+            throw PasswordHasherBusy("Password hasher is shutting down");
+        }
+        if (queue.size() >= options.maxQueued) {
+            rejected++;
+            throw PasswordHasherBusy("Too many password checks in progress, try again shortly");
+        }
+        job.enqueuedAt = std::chrono::steady_clock::now();
+        queue.push_back(std::move(job));
+    }
+    available.notify_one();
+}
+
+std::string PasswordHasher::hash(const std::string& password) {
+    auto promise = std::make_shared<std::promise<std::string>>();
+    std::future<std::string> result = promise->get_future();
+    Job job;
+    // The caller blocks on the future, so the password outlives the job
+    job.run = [this, promise, &password](uint32_t parallelism) { promise->set_value(hashNow(password, parallelism)); };
+    job.fail = [promise](std::exception_ptr error) { promise->set_exception(error); };
+    job.adaptive = true;
+    enqueue(std::move(job));
+    return result.get();
+}
+
+bool PasswordHasher::verify(const std::string& password, const std::string& stored) {
+    auto promise = std::make_shared<std::promise<bool>>();
+    std::future<bool> result = promise->get_future();
+    Job job;
+    job.run = [this, promise, &password, &stored](uint32_t) { promise->set_value(verifyNow(password, stored)); };
+    job.fail = [promise](std::exception_ptr error) { promise->set_exception(error); };
+    enqueue(std::move(job));
+    return result.get();
+}
+
+std::string PasswordHasher::hashNow(const std::string& password, uint32_t parallelism) const {
+    std::vector<uint8_t> salt(SALT_LENGTH);
+    std::random_device rd;
+    std::generate(salt.begin(), salt.end(), std::ref(rd));
+
+    size_t encodedLength = argon2_encodedlen(options.timeCost, options.memoryCostKiB, parallelism,
+                                             SALT_LENGTH, HASH_LENGTH, Argon2_id);
+    std::vector<char> encoded(encodedLength);
+    int result = argon2id_hash_encoded(options.timeCost, options.memoryCostKiB, parallelism,
+                                       password.c_str(), password.length(), salt.data(), salt.size(),
+                                       HASH_LENGTH, encoded.data(), encoded.size());
+    if (result != ARGON2_OK) {
+        throw std::runtime_error("Error hashing password: " + std::string(argon2_error_message(result)));
+    }
+    return std::string(encoded.data());
+}
+
+bool PasswordHasher::verifyNow(const std::string& password, const std::string& stored) const {
+    if (stored.compare(0, sizeof(ENCODED_PREFIX) - 1, ENCODED_PREFIX) == 0) {
+        int result = argon2id_verify(stored.c_str(), password.c_str(), password.length());
+        if (result == ARGON2_OK) return true;
+        if (result == ARGON2_VERIFY_MISMATCH) return false;
+        throw std::runtime_error("Error verifying password: " + std::string(argon2_error_message(result)));
+    }
+
+    // Legacy form: hex of the 16-byte salt followed by the 32-byte hash
+    std::vector<uint8_t> storedBytes;
+    if (!decodeHex(stored, storedBytes) || storedBytes.size() != SALT_LENGTH + HASH_LENGTH) {
+        std::cout << "WARNING: Corrupted password hash detected. Please reset password." << std::endl;
+        return false;
+    }
+
+    std::vector<uint8_t> computed(HASH_LENGTH);
+    int result = argon2id_hash_raw(LEGACY_TIME_COST, LEGACY_MEMORY_COST, 1,
+                                   password.c_str(), password.length(), storedBytes.data(), SALT_LENGTH,
+                                   computed.data(), computed.size());
+    if (result != ARGON2_OK) {
+        throw std::runtime_error("Error verifying password: " + std::string(argon2_error_message(result)));
+    }
+
+    // Constant-time comparison
+    uint8_t difference = 0;
+    for (size_t i = 0; i < HASH_LENGTH; i++) {
+        difference |= static_cast<uint8_t>(computed[i] ^ storedBytes[SALT_LENGTH + i]);
+    }
+    return difference == 0;
+}
+
+bool PasswordHasher::needsRehash(const std::string& stored) {
+    return stored.compare(0, sizeof(ENCODED_PREFIX) - 1, ENCODED_PREFIX) != 0;
+}
+
+PasswordHasher::Stats PasswordHasher::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats stats;
+    stats.lanes = workers.size();
+    stats.queued = queue.size();
+    stats.active = active;
+    stats.completed = completed;
+    stats.rejected = rejected;
+    stats.timedOut = timedOut;
+    stats.queueWait = queueWait;
+    stats.hashTime = hashTime;
+    return stats;
+}
+
+PasswordHasher& passwordHasher() {
+    static PasswordHasher hasher([] {
+        PasswordHasher::Options options;
+        unsigned int hardware = std::thread::hardware_concurrency();
+        size_t cores = hardware == 0 ? 4 : hardware;
+        size_t budgetKiB = envSize("PASSWORD_HASH_MEMORY_MB", 512) * 1024;
+        options.lanes = std::max<size_t>(1, std::min(cores, budgetKiB / options.memoryCostKiB));
+        options.maxQueued = envSize("PASSWORD_HASH_QUEUE", options.maxQueued);
+        options.timeout = std::chrono::milliseconds(envSize("PASSWORD_HASH_TIMEOUT_MS", 5000));
+        return options;
+    }());
+    return hasher;
+}
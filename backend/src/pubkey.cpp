@@ -0,0 +1,49 @@
+#include "../include/pubkey.hpp"
+#include "../include/base58.hpp"
+#include "../include/string_interner.hpp"
+#include <vector>
+
+bool Pubkey::decodeKey(std::string_view text, std::array<uint8_t, SIZE>& out) {
+    // 32 bytes take 32 to 44 base58 digits
+    if (text.size() < 32 || text.size() > 44) return false;
+    std::vector<uint8_t> decoded;
+    if (!base58Decode(text, decoded) || decoded.size() != SIZE) return false;
+    std::memcpy(out.data(), decoded.data(), SIZE);
+    return true;
+}
+
+Pubkey Pubkey::named(uint32_t id) {
+    Pubkey key;
+    key.kind = NAME;
+    std::memcpy(key.bytes.data(), &id, sizeof(id));
+    return key;
+}
+
+Pubkey Pubkey::parse(std::string_view text) {
+    if (text.empty()) return Pubkey();
+    std::array<uint8_t, SIZE> key;
+    if (decodeKey(text, key)) return Pubkey(key);
+    return named(identifierInterner().intern(text));
+}
+
+Pubkey Pubkey::lookup(std::string_view text) {
+    if (text.empty()) return Pubkey();
+    std::array<uint8_t, SIZE> key;
+    if (decodeKey(text, key)) return Pubkey(key);
+    std::optional<uint32_t> id = identifierInterner().find(text);
+    return id ? named(*id) : Pubkey();
+}
+
+std::string Pubkey::toString() const {
+    switch (kind) {
+        case KEY:
+            return base58Encode(bytes.data(), bytes.size());
+        case NAME: {
+            uint32_t id;
+            std::memcpy(&id, bytes.data(), sizeof(id));
+            return identifierInterner().text(id);
+        }
+        default:
+            return std::string();
+    }
+}
@@ -0,0 +1,183 @@
+#include "../include/session_manager.hpp"
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    const char BASE64URL[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+    // Payload: 8-byte big-endian expiry, 16-byte session id, then the email
+    constexpr size_t EXPIRY_BYTES = 8;
+    constexpr size_t ID_BYTES = 16;
+
+    std::string base64UrlEncode(const uint8_t* data, size_t size) {
+        std::string out;
+        out.reserve((size * 4 + 2) / 3);
+        size_t i = 0;
+        for (; i + 3 <= size; i += 3) {
+            uint32_t chunk = (uint32_t(data[i]) << 16) | (uint32_t(data[i + 1]) << 8) | data[i + 2];
+            out.push_back(BASE64URL[(chunk >> 18) & 63]);
+            out.push_back(BASE64URL[(chunk >> 12) & 63]);
+            out.push_back(BASE64URL[(chunk >> 6) & 63]);
+            out.push_back(BASE64URL[chunk & 63]);
+        }
+        if (size - i == 1) {
+            uint32_t chunk = uint32_t(data[i]) << 16;
+            out.push_back(BASE64URL[(chunk >> 18) & 63]);
+            out.push_back(BASE64URL[(chunk >> 12) & 63]);
+        } else if (size - i == 2) {
+            uint32_t chunk = (uint32_t(data[i]) << 16) | (uint32_t(data[i + 1]) << 8);
+            out.push_back(BASE64URL[(chunk >> 18) & 63]);
+            out.push_back(BASE64URL[(chunk >> 12) & 63]);
+            out.push_back(BASE64URL[(chunk >> 6) & 63]);
+        }
+        return out;
+    }
+
+    bool base64UrlDecode(std::string_view text, std::string& out) {
+        auto value = [](char c) -> int {
+            if (c >= 'A' && c <= 'Z') return c - 'A';
+            if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+            if (c >= '0' && c <= '9') return c - '0' + 52;
+            if (c == '-') return 62;
+            if (c == '_') return 63;
+            return -1;
+        };
+        if (text.size() % 4 == 1) return false;
+        out.clear();
+        out.reserve(text.size() * 3 / 4);
+        uint32_t bits = 0;
+        int count = 0;
+        for (char c : text) {
+            int v = value(c);
+            if (v < 0) return false;
+            bits = (bits << 6) | static_cast<uint32_t>(v);
+            count += 6;
+            if (count >= 8) {
+                count -= 8;
+                out.push_back(static_cast<char>((bits >> count) & 0xFF));
+            }
+        }
+        return true;
+    }
+}
+
+size_t SessionManager::IdHash::operator()(const std::array<uint8_t, 16>& id) const {
+    // Ids are random, so any eight of their bytes already hash well
+    uint64_t word;
+    std::memcpy(&word, id.data(), sizeof(word));
+    return static_cast<size_t>(word);
+}
+
+SessionManager::SessionManager(std::string secret, long timeToLiveSeconds)
+    : key(std::move(secret)), ttlSeconds(timeToLiveSeconds > 0 ? timeToLiveSeconds : 1) {
+    if (key.empty()) {
+        throw std::runtime_error("Session secret must not be empty");
+    }
+}
+
+std::string SessionManager::sign(std::string_view payload) const {
+    unsigned char mac[EVP_MAX_MD_SIZE];
+    unsigned int macLength = 0;
+    if (!HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()),
+              reinterpret_cast<const unsigned char*>(payload.data()), payload.size(), mac, &macLength)) {
+        throw std::runtime_error("HMAC-SHA256 failed");
+    }
+    return std::string(reinterpret_cast<const char*>(mac), macLength);
+}
+
+std::string SessionManager::issue(const std::string& email) {
+    std::string payload(EXPIRY_BYTES + ID_BYTES, '\0');
+    uint64_t expiresAt = static_cast<uint64_t>(std::time(nullptr) + ttlSeconds);
+    for (size_t i = 0; i < EXPIRY_BYTES; i++) {
+        payload[i] = static_cast<char>(expiresAt >> (8 * (EXPIRY_BYTES - 1 - i)));
+    }
+    if (RAND_bytes(reinterpret_cast<unsigned char*>(&payload[EXPIRY_BYTES]), ID_BYTES) != 1) {
+        throw std::runtime_error("Cannot generate session id");
+    }
+    payload += email;
+
+    std::string mac = sign(payload);
+    return base64UrlEncode(reinterpret_cast<const uint8_t*>(payload.data()), payload.size()) + "." +
+           base64UrlEncode(reinterpret_cast<const uint8_t*>(mac.data()), mac.size());
+}
+
+std::optional<Session> SessionManager::validate(std::string_view token) const {
+    size_t dot = token.find('.');
+    if (dot == std::string_view::npos) return std::nullopt;
+
+    std::string payload;
+    std::string mac;
+    if (!base64UrlDecode(token.substr(0, dot), payload) || !base64UrlDecode(token.substr(dot + 1), mac)) {
+        return std::nullopt;
+    }
+    if (payload.size() <= EXPIRY_BYTES + ID_BYTES) return std::nullopt;
+
+    std::string expected = sign(payload);
+    if (mac.size() != expected.size() || CRYPTO_memcmp(mac.data(), expected.data(), mac.size()) != 0) {
+        return std::nullopt;
+    }
+
+    Session session;
+    uint64_t expiresAt = 0;
+    for (size_t i = 0; i < EXPIRY_BYTES; i++) {
+        expiresAt = (expiresAt << 8) | static_cast<uint8_t>(payload[i]);
+    }
+    session.expiresAt = static_cast<std::time_t>(expiresAt);
+    if (session.expiresAt <= std::time(nullptr)) return std::nullopt;
+
+    std::memcpy(session.id.data(), payload.data() + EXPIRY_BYTES, ID_BYTES);
+    session.email = payload.substr(EXPIRY_BYTES + ID_BYTES);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (revoked.count(session.id) > 0) return std::nullopt;
+    return session;
+}
+
+bool SessionManager::revoke(std::string_view token) {
+    std::optional<Session> session = validate(token);
+    if (!session) return false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    revoked[session->id] = session->expiresAt;
+    purgeExpired(std::time(nullptr));
+    return true;
+}
+
+// Expired sessions fail validation on their own, so their revocations can go
+void SessionManager::purgeExpired(std::time_t now) {
+    if (now < nextPurge) return;
+    nextPurge = now + 60;
+    for (auto it = revoked.begin(); it != revoked.end();) {
+        if (it->second <= now) {
+            it = revoked.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+size_t SessionManager::revokedCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return revoked.size();
+}
+
+SessionManager& sessionManager() {
+    static SessionManager manager([] {
+        const char* secret = std::getenv("SESSION_SECRET");
+        if (secret && *secret) return std::string(secret);
+        std::string random(32, '\0');
+        if (RAND_bytes(reinterpret_cast<unsigned char*>(&random[0]), static_cast<int>(random.size())) != 1) {
+            throw std::runtime_error("Cannot generate session secret");
+        }
+        return random;
+    }(), [] {
+        const char* ttl = std::getenv("SESSION_TTL_SECONDS");
+        return ttl && *ttl ? std::strtol(ttl, nullptr, 10) : 12L * 60 * 60;
+    }());
+    return manager;
+}
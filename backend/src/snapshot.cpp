@@ -0,0 +1,166 @@
+#include "../include/snapshot.hpp"
+#include "../include/crc32.hpp"
+#include "../include/file_util.hpp"
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+
+namespace {
+    const char SNAPSHOT_MAGIC[8] = {'N', 'F', 'T', 'S', 'N', 'A', 'P', '1'};
+    const uint32_t SNAPSHOT_VERSION = 1;
+    const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    // Files whose contents the image stands in for, in SnapshotStamp order
+    const char* SOURCE_PATHS[SNAPSHOT_SOURCE_COUNT] = {
+        "data/accounts.db",
+        "marketplace/journal.bin",
+        "marketplace/listings.json",
+        "marketplace/transactions.json"
+    };
+
+    static_assert(std::is_trivially_copyable<SnapshotHeader>::value, "snapshot records are copied as raw bytes");
+    static_assert(std::is_trivially_copyable<SnapshotUser>::value, "snapshot records are copied as raw bytes");
+    static_assert(std::is_trivially_copyable<SnapshotNFT>::value, "snapshot records are copied as raw bytes");
+    static_assert(sizeof(SnapshotHeader) % 8 == 0, "sections start 8-byte aligned");
+
+    void padTo8(std::string& out) {
+        while (out.size() % 8 != 0) {
+            out.push_back('\0');
+        }
+    }
+
+    template<typename T>
+    SnapshotSection appendSection(std::string& out, const T* records, size_t count) {
+        padTo8(out);
+        SnapshotSection section{out.size(), count};
+        out.append(reinterpret_cast<const char*>(records), count * sizeof(T));
+        return section;
+    }
+}
+
+SnapshotStamp currentSnapshotStamp() {
+    SnapshotStamp stamp{};
+    for (size_t i = 0; i < SNAPSHOT_SOURCE_COUNT; i++) {
+        std::error_code ec;
+        uint64_t size = std::filesystem::file_size(SOURCE_PATHS[i], ec);
+        if (ec) continue; // missing files stamp as zero
+        auto mtime = std::filesystem::last_write_time(SOURCE_PATHS[i], ec);
+        if (ec) continue;
+        stamp.sources[i].size = size;
+        stamp.sources[i].mtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+    }
+    return stamp;
+}
+
+uint32_t SnapshotBuilder::intern(const std::string& value) {
+    auto it = stringIds.find(value);
+    if (it != stringIds.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(strings.size());
+    strings.push_back(SnapshotString{stringData.size(), static_cast<uint32_t>(value.size()), 0});
+    stringData.append(value);
+    stringIds.emplace(value, id);
+    return id;
+}
+
+void SnapshotBuilder::write(const std::string& path, const SnapshotStamp& stamp) const {
+    SnapshotHeader header{};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version = SNAPSHOT_VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.stamp = stamp;
+
+    std::string out(sizeof(SnapshotHeader), '\0');
+    header.sections[SECTION_STRINGS] = appendSection(out, strings.data(), strings.size());
+    header.sections[SECTION_STRING_DATA] = appendSection(out, stringData.data(), stringData.size());
+    header.sections[SECTION_USERS] = appendSection(out, users.data(), users.size());
+    header.sections[SECTION_COLLECTIONS] = appendSection(out, collections.data(), collections.size());
+    header.sections[SECTION_NFTS] = appendSection(out, nfts.data(), nfts.size());
+    header.sections[SECTION_HISTORY] = appendSection(out, history.data(), history.size());
+    header.sections[SECTION_LISTINGS] = appendSection(out, listings.data(), listings.size());
+    header.sections[SECTION_TRANSACTIONS] = appendSection(out, transactions.data(), transactions.size());
+    padTo8(out);
+
+    header.fileSize = out.size();
+    header.crc = crc32(out.data() + sizeof(SnapshotHeader), out.size() - sizeof(SnapshotHeader));
+    std::memcpy(&out[0], &header, sizeof(header));
+
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent);
+    }
+    writeFileAtomic(path, out);
+}
+
+void SnapshotImage::close() {
+    if (base) {
+        ::munmap(base, length);
+        base = nullptr;
+        length = 0;
+    }
+}
+
+bool SnapshotImage::open(const std::string& path, const SnapshotStamp& expected) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SnapshotHeader)) {
+        ::close(fd);
+        return false;
+    }
+    length = static_cast<size_t>(st.st_size);
+    void* mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        length = 0;
+        return false;
+    }
+    base = mapped;
+
+    if (!validate() || !(header().stamp == expected)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+// Checks the header, that every section lies inside the file, and the checksum
+bool SnapshotImage::validate() const {
+    const SnapshotHeader& h = header();
+    if (std::memcmp(h.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+        h.version != SNAPSHOT_VERSION || h.byteOrder != BYTE_ORDER_MARK || h.fileSize != length) {
+        return false;
+    }
+
+    const size_t recordSizes[SECTION_COUNT] = {
+        sizeof(SnapshotString), 1, sizeof(SnapshotUser), sizeof(SnapshotCollection),
+        sizeof(SnapshotNFT), sizeof(uint32_t), sizeof(SnapshotNFT), sizeof(SnapshotTransaction)
+    };
+    for (size_t i = 0; i < SECTION_COUNT; i++) {
+        const SnapshotSection& s = h.sections[i];
+        if (s.offset < sizeof(SnapshotHeader) || s.offset > length || s.offset % 8 != 0 ||
+            s.count > (length - s.offset) / recordSizes[i]) {
+            return false;
+        }
+    }
+
+    const char* body = static_cast<const char*>(base) + sizeof(SnapshotHeader);
+    return crc32(body, length - sizeof(SnapshotHeader)) == h.crc;
+}
+
+std::string_view SnapshotImage::string(uint32_t id) const {
+    const SnapshotString& entry = section<SnapshotString>(SECTION_STRINGS)[id];
+    const SnapshotSection& data = header().sections[SECTION_STRING_DATA];
+    if (entry.offset > data.count || entry.length > data.count - entry.offset) {
+        throw std::out_of_range("Snapshot string out of range");
+    }
+    return std::string_view(static_cast<const char*>(base) + data.offset + entry.offset, entry.length);
+}
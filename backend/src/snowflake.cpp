@@ -0,0 +1,94 @@
+#include "../include/snowflake.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+    const char HEX[] = "0123456789ABCDEF";
+}
+
+SnowflakeGenerator::SnowflakeGenerator(uint32_t node) : nodeId(node) {
+    if (nodeId > MAX_NODE) {
+        throw std::invalid_argument("Snowflake node id must be at most " + std::to_string(MAX_NODE));
+    }
+}
+
+uint64_t SnowflakeGenerator::nowMs() {
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    uint64_t unixMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now).count());
+    return unixMs > EPOCH_MS ? unixMs - EPOCH_MS : 0;
+}
+
+uint64_t SnowflakeGenerator::next() {
+    uint64_t current = state.load(std::memory_order_relaxed);
+    uint64_t claimed;
+    do {
+        uint64_t lastMs = current >> SEQUENCE_BITS;
+        uint64_t now = nowMs();
+        if (now > lastMs) {
+            claimed = now << SEQUENCE_BITS;
+        } else if ((current & SEQUENCE_MASK) < SEQUENCE_MASK) {
+            claimed = current + 1;
+        } else {
+            // Sequence used up (or the clock went back): borrow the next millisecond
+            claimed = (lastMs + 1) << SEQUENCE_BITS;
+        }
+    } while (!state.compare_exchange_weak(current, claimed, std::memory_order_relaxed));
+
+    uint64_t ms = claimed >> SEQUENCE_BITS;
+    return (ms << (NODE_BITS + SEQUENCE_BITS)) | (uint64_t(nodeId) << SEQUENCE_BITS) | (claimed & SEQUENCE_MASK);
+}
+
+void SnowflakeGenerator::observe(uint64_t id) {
+    uint64_t ms = id >> (NODE_BITS + SEQUENCE_BITS);
+    // A corrupt or hostile id far in the future would drag every later id along with it
+    if (ms > nowMs() + MAX_OBSERVED_LEAD_MS) {
+        return;
+    }
+    uint64_t seen = (ms << SEQUENCE_BITS) | (id & SEQUENCE_MASK);
+    uint64_t current = state.load(std::memory_order_relaxed);
+    while (current < seen && !state.compare_exchange_weak(current, seen, std::memory_order_relaxed)) {
+    }
+}
+
+std::string SnowflakeGenerator::format(std::string_view prefix, uint64_t id) {
+    std::string text;
+    text.reserve(prefix.size() + HEX_DIGITS);
+    text.append(prefix);
+    for (size_t i = HEX_DIGITS; i-- > 0;) {
+        text.push_back(HEX[(id >> (4 * i)) & 0xF]);
+    }
+    return text;
+}
+
+bool SnowflakeGenerator::parse(std::string_view text, std::string_view prefix, uint64_t& id) {
+    if (text.size() != prefix.size() + HEX_DIGITS || text.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+    id = 0;
+    for (size_t i = prefix.size(); i < text.size(); i++) {
+        char c = text[i];
+        int digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+        else return false;
+        id = (id << 4) | static_cast<uint64_t>(digit);
+    }
+    // Anything wider than 62 bits was not made here
+    return (id >> (TIME_BITS + NODE_BITS + SEQUENCE_BITS)) == 0;
+}
+
+SnowflakeGenerator& idGenerator() {
+    static SnowflakeGenerator generator([] {
+        const char* node = std::getenv("NODE_ID");
+        if (!node || !*node) return 0UL;
+        unsigned long parsed = std::strtoul(node, nullptr, 10);
+        if (parsed > SnowflakeGenerator::MAX_NODE) {
+            std::cerr << "NODE_ID " << node << " is out of range 0-" << SnowflakeGenerator::MAX_NODE << "; using 0" << std::endl;
+            return 0UL;
+        }
+        return parsed;
+    }());
+    return generator;
+}
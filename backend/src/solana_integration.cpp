@@ -0,0 +1,78 @@
+#include "../include/solana_integration.hpp"
+#include "../include/thread_pool.hpp"
+#include "../include/file_util.hpp"
+#include "../include/solana_keypair.hpp"
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+#include <unordered_set>
+
+std::unordered_map<std::string, double> SolanaIntegration::getBalances(const V<std::string>& addresses) {
+    // Each wallet is asked for once, however often it appears
+    V<std::string> unique;
+    std::unordered_set<std::string> seen;
+    for (const auto& address : addresses) {
+        if (!address.empty() && seen.insert(address).second) {
+            unique.push_back(address);
+        }
+    }
+
+    std::unordered_map<std::string, double> balances;
+    if (unique.empty()) return balances;
+
+    size_t chunkCount = (unique.size() + MAX_ACCOUNTS_PER_REQUEST - 1) / MAX_ACCOUNTS_PER_REQUEST;
+    std::vector<V<std::optional<RpcAccountInfo>>> results(chunkCount);
+    std::vector<char> succeeded(chunkCount, 0);  // not vector<bool>: written from several threads
+
+    // One RPC per chunk; the client's connection pool keeps these on warm connections
+    ThreadPool pool(std::min<size_t>(chunkCount, 8));
+    pool.parallelFor(chunkCount, [&](size_t chunk) {
+        size_t begin = chunk * MAX_ACCOUNTS_PER_REQUEST;
+        size_t end = std::min(begin + MAX_ACCOUNTS_PER_REQUEST, unique.size());
+        V<std::string> batch;
+        for (size_t i = begin; i < end; i++) {
+            batch.push_back(unique[i]);
+        }
+        try {
+            results[chunk] = solanaRpc().getMultipleAccounts(batch);
+            succeeded[chunk] = 1;
+        } catch (const std::exception& e) {
+            std::cerr << "Balance batch " << chunk + 1 << "/" << chunkCount << " failed: " << e.what() << std::endl;
+        }
+    });
+
+    balances.reserve(unique.size());
+    for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+        if (!succeeded[chunk]) continue;
+        size_t begin = chunk * MAX_ACCOUNTS_PER_REQUEST;
+        for (size_t i = 0; i < results[chunk].size(); i++) {
+            const auto& account = results[chunk][i];
+            uint64_t lamports = account ? account->lamports : 0;
+            // Fresh values; later single lookups can be served from memory
+            balanceCache().put(unique[begin + i], lamports);
+            balances[unique[begin + i]] = static_cast<double>(lamports) / LAMPORTS_PER_SOL;
+        }
+    }
+    return balances;
+}
+
+std::string SolanaIntegration::mintNFT(const std::string& metadata, const std::string& jobDir) {
+    std::error_code ec;
+    std::filesystem::create_directories(jobDir, ec);
+    if (ec) {
+        throw std::runtime_error("Cannot create " + jobDir + ": " + ec.message());
+    }
+
+    // Keypair for the NFT; an existing mint key is never overwritten
+    SolanaKeypair keypair = SolanaKeypair::generate();
+    keypair.save(jobDir + "/keypair.json");
+    std::string mintAddress = keypair.address();
+
+    // TODO: Upload metadata to IPFS or similar service
+    // TODO: Use the metadata URI in the actual minting command
+    if (!metadata.empty()) {
+        writeFileAtomic(jobDir + "/metadata.json", metadata);
+    }
+
+    return mintAddress;
+}
@@ -0,0 +1,138 @@
+#include "../include/solana_keypair.hpp"
+#include "../include/base58.hpp"
+#include "../include/file_util.hpp"
+#include "../include/json_reader.hpp"
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    struct PkeyDeleter {
+        void operator()(EVP_PKEY* key) const { EVP_PKEY_free(key); }
+    };
+    struct PkeyContextDeleter {
+        void operator()(EVP_PKEY_CTX* context) const { EVP_PKEY_CTX_free(context); }
+    };
+    using PkeyPtr = std::unique_ptr<EVP_PKEY, PkeyDeleter>;
+
+    [[noreturn]] void cryptoError(const std::string& what) {
+        char detail[256] = "unknown error";
+        unsigned long code = ERR_get_error();
+        if (code != 0) ERR_error_string_n(code, detail, sizeof(detail));
+        throw std::runtime_error(what + ": " + detail);
+    }
+
+    void rawKeys(EVP_PKEY* key, std::array<uint8_t, 32>& seed, std::array<uint8_t, 32>& publicKey) {
+        size_t seedLength = seed.size();
+        size_t publicLength = publicKey.size();
+        if (EVP_PKEY_get_raw_private_key(key, seed.data(), &seedLength) != 1 || seedLength != seed.size() ||
+            EVP_PKEY_get_raw_public_key(key, publicKey.data(), &publicLength) != 1 || publicLength != publicKey.size()) {
+            cryptoError("Cannot read ed25519 key");
+        }
+    }
+
+    // id.json is a flat array of byte values
+    class ByteArrayHandler : public JsonHandler {
+    public:
+        std::vector<uint8_t> bytes;
+        bool valid = true;
+        int depth = 0;
+
+        ~ByteArrayHandler() override { OPENSSL_cleanse(bytes.data(), bytes.size()); }
+
+        void startArray() override { if (++depth > 1) valid = false; }
+        void endArray() override { depth--; }
+        void startObject() override { valid = false; }
+        void string(std::string_view) override { valid = false; }
+        void boolean(bool) override { valid = false; }
+        void null() override { valid = false; }
+        void number(double value) override {
+            if (depth != 1 || value < 0 || value > 255 || value != static_cast<double>(static_cast<int>(value))) {
+                valid = false;
+                return;
+            }
+            bytes.push_back(static_cast<uint8_t>(value));
+        }
+    };
+}
+
+SolanaKeypair SolanaKeypair::generate() {
+    std::unique_ptr<EVP_PKEY_CTX, PkeyContextDeleter> context(EVP_PKEY_CTX_new_id(EVP_PKEY_ED25519, nullptr));
+    if (!context || EVP_PKEY_keygen_init(context.get()) != 1) {
+        cryptoError("Cannot initialise ed25519 keygen");
+    }
+    EVP_PKEY* raw = nullptr;
+    if (EVP_PKEY_keygen(context.get(), &raw) != 1) {
+        cryptoError("ed25519 keygen failed");
+    }
+    PkeyPtr key(raw);
+
+    SolanaKeypair keypair;
+    rawKeys(key.get(), keypair.seed, keypair.publicKey);
+    return keypair;
+}
+
+SolanaKeypair SolanaKeypair::load(const std::string& path) {
+    ByteArrayHandler handler;
+    if (!parseJsonFile(path, handler)) {
+        throw std::runtime_error("Cannot read keypair " + path);
+    }
+    if (!handler.valid || handler.bytes.size() != 64) {
+        throw std::runtime_error(path + " is not a 64-byte keypair array");
+    }
+
+    // Rederive the public half rather than trusting the file's copy
+    PkeyPtr key(EVP_PKEY_new_raw_private_key(EVP_PKEY_ED25519, nullptr, handler.bytes.data(), 32));
+    if (!key) {
+        cryptoError("Invalid ed25519 seed in " + path);
+    }
+    SolanaKeypair keypair;
+    rawKeys(key.get(), keypair.seed, keypair.publicKey);
+    if (!std::equal(keypair.publicKey.begin(), keypair.publicKey.end(), handler.bytes.begin() + 32)) {
+        throw std::runtime_error(path + " public key does not match its secret key");
+    }
+    return keypair;
+}
+
+SolanaKeypair::~SolanaKeypair() {
+    OPENSSL_cleanse(seed.data(), seed.size());
+}
+
+std::string SolanaKeypair::address() const {
+    return base58Encode(publicKey.data(), publicKey.size());
+}
+
+std::string SolanaKeypair::toJson() const {
+    std::string json;
+    json.reserve(64 * 4 + 2);
+    json.push_back('[');
+    auto append = [&json](const std::array<uint8_t, 32>& bytes) {
+        for (uint8_t byte : bytes) {
+            if (json.size() > 1) json.push_back(',');
+            json.append(std::to_string(byte));
+        }
+    };
+    append(seed);
+    append(publicKey);
+    json.push_back(']');
+    return json;
+}
+
+void SolanaKeypair::save(const std::string& path, bool overwrite) const {
+    if (!overwrite && std::filesystem::exists(path)) {
+        throw std::runtime_error("Refusing to overwrite keypair " + path);
+    }
+    std::string json = toJson();
+    try {
+        writeFileAtomic(path, json, 0600);
+    } catch (...) {
+        OPENSSL_cleanse(&json[0], json.size());
+        throw;
+    }
+    OPENSSL_cleanse(&json[0], json.size());
+}
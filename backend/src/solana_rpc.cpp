@@ -0,0 +1,598 @@
+#include "../include/solana_rpc.hpp"
+#include "../include/json_reader.hpp"
+#include "../include/json_writer.hpp"
+#include "../include/solana_config.hpp"
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace {
+    const int CONNECT_TIMEOUT_MS = 5000;
+    const int IO_TIMEOUT_SECONDS = 15;
+    const size_t MAX_HEADER_BYTES = 64 * 1024;
+
+    std::string lowercase(std::string text) {
+        for (auto& c : text) {
+            if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+        }
+        return text;
+    }
+
+    std::string sslError(const std::string& what) {
+        unsigned long code = ERR_get_error();
+        char detail[256] = "unknown error";
+        if (code != 0) {
+            ERR_error_string_n(code, detail, sizeof(detail));
+        }
+        return what + ": " + detail;
+    }
+
+    /*
+     * Tracks where in an RPC response each token sits as a dotted path,
+     * e.g. "result.value.[].lamports", and picks up a JSON-RPC error object
+     * if the node returned one instead of a result.
+     */
+    class RpcResponseHandler : public JsonHandler {
+    private:
+        std::string path;
+        std::vector<size_t> marks;      // path length before each open container
+        std::vector<bool> inArray;
+        std::string pendingKey;
+        std::string location;
+
+        // Path of the value about to be reported
+        const std::string& here() {
+            location = path;
+            if (!inArray.empty()) {
+                if (!location.empty()) location.push_back('.');
+                location.append(inArray.back() ? "[]" : pendingKey);
+            }
+            return location;
+        }
+
+        void open(bool array) {
+            marks.push_back(path.size());
+            path = here();
+            inArray.push_back(array);
+        }
+
+        void close() {
+            path.resize(marks.back());
+            marks.pop_back();
+            inArray.pop_back();
+        }
+
+    protected:
+        virtual void onObject(const std::string&) {}
+        virtual void onString(const std::string&, std::string_view) {}
+        virtual void onNumber(const std::string&, double) {}
+        virtual void onBool(const std::string&, bool) {}
+        virtual void onNull(const std::string&) {}
+
+    public:
+        bool hasError = false;
+        int errorCode = 0;
+        std::string errorMessage;
+
+        void startObject() override {
+            const std::string& where = here();
+            if (where == "error") hasError = true;
+            onObject(where);
+            open(false);
+        }
+        void endObject() override { close(); }
+        void startArray() override { open(true); }
+        void endArray() override { close(); }
+        void key(std::string_view name) override { pendingKey.assign(name.data(), name.size()); }
+
+        void string(std::string_view value) override {
+            const std::string& where = here();
+            if (where == "error.message") errorMessage.assign(value.data(), value.size());
+            onString(where, value);
+        }
+        void number(double value) override {
+            const std::string& where = here();
+            if (where == "error.code") errorCode = static_cast<int>(value);
+            onNumber(where, value);
+        }
+        void boolean(bool value) override { onBool(here(), value); }
+        void null() override { onNull(here()); }
+
+        void parse(const std::string& body) {
+            JsonReader(body).parse(*this);
+            if (hasError) {
+                throw SolanaRpcError(errorCode, "RPC error " + std::to_string(errorCode) + ": " + errorMessage);
+            }
+        }
+    };
+
+    class StringResultHandler : public RpcResponseHandler {
+    protected:
+        void onString(const std::string& where, std::string_view value) override {
+            if (where == "result") result.assign(value.data(), value.size());
+        }
+    public:
+        std::string result;
+    };
+
+    class BalanceHandler : public RpcResponseHandler {
+    protected:
+        void onNumber(const std::string& where, double value) override {
+            if (where == "result.value") {
+                lamports = static_cast<uint64_t>(value);
+                found = true;
+            }
+        }
+    public:
+        uint64_t lamports = 0;
+        bool found = false;
+    };
+
+    class AccountsHandler : public RpcResponseHandler {
+    protected:
+        void onObject(const std::string& where) override {
+            if (where == "result.value.[]") accounts.push_back(RpcAccountInfo());
+        }
+        void onNull(const std::string& where) override {
+            if (where == "result.value.[]") accounts.push_back(std::nullopt);
+        }
+        void onNumber(const std::string& where, double value) override {
+            if (where == "result.value.[].lamports") accounts.back()->lamports = static_cast<uint64_t>(value);
+            else if (where == "result.value.[].space") accounts.back()->space = static_cast<uint64_t>(value);
+        }
+        void onString(const std::string& where, std::string_view value) override {
+            if (where == "result.value.[].owner") accounts.back()->owner.assign(value.data(), value.size());
+        }
+        void onBool(const std::string& where, bool value) override {
+            if (where == "result.value.[].executable") accounts.back()->executable = value;
+        }
+    public:
+        V<std::optional<RpcAccountInfo>> accounts;
+    };
+
+    class SignatureStatusHandler : public RpcResponseHandler {
+    protected:
+        void onObject(const std::string& where) override {
+            if (where == "result.value.[]") statuses.push_back(RpcSignatureStatus());
+            else if (where == "result.value.[].err") statuses.back()->failed = true;
+        }
+        void onNull(const std::string& where) override {
+            if (where == "result.value.[]") statuses.push_back(std::nullopt);
+        }
+        void onNumber(const std::string& where, double value) override {
+            if (where == "result.value.[].slot") statuses.back()->slot = static_cast<uint64_t>(value);
+            else if (where == "result.value.[].confirmations") statuses.back()->confirmations = static_cast<uint64_t>(value);
+        }
+        void onString(const std::string& where, std::string_view value) override {
+            if (where == "result.value.[].confirmationStatus") {
+                statuses.back()->confirmationStatus.assign(value.data(), value.size());
+            } else if (where == "result.value.[].err") {
+                statuses.back()->failed = true;
+            }
+        }
+    public:
+        V<std::optional<RpcSignatureStatus>> statuses;
+    };
+}
+
+// One TCP (optionally TLS) connection and the bytes read past the last response
+class HttpConnection {
+private:
+    int fd = -1;
+    SSL* ssl = nullptr;
+    std::string pending;
+
+    void connectSocket(const std::string& host, const std::string& port) {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* addresses = nullptr;
+        int rc = ::getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses);
+        if (rc != 0) {
+            throw SolanaRpcError(0, "Cannot resolve " + host + ": " + gai_strerror(rc));
+        }
+
+        std::string lastError = "no addresses";
+        for (addrinfo* a = addresses; a && fd < 0; a = a->ai_next) {
+            int s = ::socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+            if (s < 0) continue;
+
+            // Non-blocking connect so a dead host can't stall for minutes
+            int flags = ::fcntl(s, F_GETFL, 0);
+            ::fcntl(s, F_SETFL, flags | O_NONBLOCK);
+            int result = ::connect(s, a->ai_addr, a->ai_addrlen);
+            if (result != 0 && errno == EINPROGRESS) {
+                pollfd p{s, POLLOUT, 0};
+                result = ::poll(&p, 1, CONNECT_TIMEOUT_MS) == 1 ? 0 : -1;
+                int soError = result == 0 ? 0 : ETIMEDOUT;
+                socklen_t len = sizeof(soError);
+                if (result == 0) ::getsockopt(s, SOL_SOCKET, SO_ERROR, &soError, &len);
+                if (soError != 0) {
+                    errno = soError;
+                    result = -1;
+                }
+            }
+            if (result != 0) {
+                lastError = std::strerror(errno);
+                ::close(s);
+                continue;
+            }
+            ::fcntl(s, F_SETFL, flags);
+            fd = s;
+        }
+        ::freeaddrinfo(addresses);
+        if (fd < 0) {
+            throw SolanaRpcError(0, "Cannot connect to " + host + ":" + port + ": " + lastError);
+        }
+
+        timeval timeout{IO_TIMEOUT_SECONDS, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#ifdef SO_NOSIGPIPE
+        ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+    }
+
+    // Reads more bytes into pending; returns false on a clean EOF
+    bool fill() {
+        char chunk[16 * 1024];
+        while (true) {
+            ssize_t n;
+            if (ssl) {
+                n = SSL_read(ssl, chunk, sizeof(chunk));
+                if (n <= 0) {
+                    int err = SSL_get_error(ssl, static_cast<int>(n));
+                    if (err == SSL_ERROR_ZERO_RETURN) return false;
+                    if (err == SSL_ERROR_SYSCALL && ERR_peek_error() == 0 && n == 0) return false;
+                    throw SolanaRpcError(0, sslError("TLS read failed"));
+                }
+            } else {
+                n = ::recv(fd, chunk, sizeof(chunk), 0);
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    throw SolanaRpcError(0, "Read failed: " + std::string(std::strerror(errno)));
+                }
+                if (n == 0) return false;
+            }
+            pending.append(chunk, static_cast<size_t>(n));
+            return true;
+        }
+    }
+
+    // Consumes one CRLF-terminated line from pending
+    std::string readLine() {
+        size_t end;
+        while ((end = pending.find("\r\n")) == std::string::npos) {
+            if (pending.size() > MAX_HEADER_BYTES || !fill()) {
+                throw SolanaRpcError(0, "Malformed HTTP response");
+            }
+        }
+        std::string line = pending.substr(0, end);
+        pending.erase(0, end + 2);
+        return line;
+    }
+
+    void readExactly(size_t count, std::string& out) {
+        while (pending.size() < count) {
+            if (!fill()) throw SolanaRpcError(0, "Connection closed mid-response");
+        }
+        out.append(pending, 0, count);
+        pending.erase(0, count);
+    }
+
+public:
+    HttpConnection(const std::string& host, const std::string& port, SSL_CTX* context) {
+        connectSocket(host, port);
+        if (!context) return;
+
+        ssl = SSL_new(context);
+        if (!ssl) {
+            ::close(fd);
+            throw SolanaRpcError(0, sslError("Cannot create TLS session"));
+        }
+        SSL_set_fd(ssl, fd);
+        SSL_set_tlsext_host_name(ssl, host.c_str());
+        SSL_set1_host(ssl, host.c_str());
+        if (SSL_connect(ssl) != 1) {
+            std::string message = sslError("TLS handshake with " + host + " failed");
+            SSL_free(ssl);
+            ::close(fd);
+            throw SolanaRpcError(0, message);
+        }
+    }
+
+    ~HttpConnection() {
+        if (ssl) SSL_free(ssl);
+        if (fd >= 0) ::close(fd);
+    }
+
+    HttpConnection(const HttpConnection&) = delete;
+    HttpConnection& operator=(const HttpConnection&) = delete;
+
+    void writeAll(const std::string& data) {
+        size_t written = 0;
+        while (written < data.size()) {
+            ssize_t n;
+            if (ssl) {
+                n = SSL_write(ssl, data.data() + written, static_cast<int>(data.size() - written));
+                if (n <= 0) throw SolanaRpcError(0, sslError("TLS write failed"));
+            } else {
+                int sendFlags = 0;
+#ifdef MSG_NOSIGNAL
+                sendFlags = MSG_NOSIGNAL;
+#endif
+                n = ::send(fd, data.data() + written, data.size() - written, sendFlags);
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    throw SolanaRpcError(0, "Write failed: " + std::string(std::strerror(errno)));
+                }
+            }
+            written += static_cast<size_t>(n);
+        }
+    }
+
+    // Reads one response. responseStarted tells the caller whether any
+    // byte arrived, i.e. whether the request may be retried elsewhere.
+    std::string readResponse(int& status, bool& keepAlive, bool& responseStarted) {
+        responseStarted = false;
+        if (pending.empty() && !fill()) {
+            throw SolanaRpcError(0, "Connection closed before response");
+        }
+        responseStarted = true;
+
+        std::string statusLine = readLine();
+        if (statusLine.compare(0, 5, "HTTP/") != 0 || statusLine.size() < 12) {
+            throw SolanaRpcError(0, "Malformed HTTP status line");
+        }
+        status = std::atoi(statusLine.c_str() + 9);
+        keepAlive = statusLine.compare(0, 8, "HTTP/1.0") != 0;
+
+        long long contentLength = -1;
+        bool chunked = false;
+        while (true) {
+            std::string line = readLine();
+            if (line.empty()) break;
+            size_t colon = line.find(':');
+            if (colon == std::string::npos) continue;
+            std::string name = lowercase(line.substr(0, colon));
+            size_t valueStart = line.find_first_not_of(" \t", colon + 1);
+            std::string value = valueStart == std::string::npos ? "" : line.substr(valueStart);
+            if (name == "content-length") {
+                contentLength = std::atoll(value.c_str());
+            } else if (name == "transfer-encoding") {
+                chunked = lowercase(value).find("chunked") != std::string::npos;
+            } else if (name == "connection") {
+                std::string v = lowercase(value);
+                if (v.find("close") != std::string::npos) keepAlive = false;
+                else if (v.find("keep-alive") != std::string::npos) keepAlive = true;
+            }
+        }
+
+        std::string body;
+        if (chunked) {
+            while (true) {
+                size_t size = std::strtoul(readLine().c_str(), nullptr, 16);
+                if (size == 0) break;
+                readExactly(size, body);
+                readLine();
+            }
+            while (!readLine().empty()) {} // trailers
+        } else if (contentLength >= 0) {
+            readExactly(static_cast<size_t>(contentLength), body);
+        } else {
+            // Body runs to EOF; the connection can't be reused
+            while (fill()) {}
+            body.swap(pending);
+            keepAlive = false;
+        }
+        return body;
+    }
+};
+
+HttpConnectionPool::HttpConnectionPool(const std::string& url, size_t maxIdleConnections)
+    : maxIdle(maxIdleConnections) {
+    std::string rest;
+    if (url.compare(0, 8, "https://") == 0) {
+        tls = true;
+        rest = url.substr(8);
+    } else if (url.compare(0, 7, "http://") == 0) {
+        rest = url.substr(7);
+    } else {
+        throw std::invalid_argument("Unsupported RPC URL: " + url);
+    }
+
+    size_t slash = rest.find('/');
+    std::string authority = rest.substr(0, slash);
+    path = slash == std::string::npos ? "/" : rest.substr(slash);
+    size_t colon = authority.rfind(':');
+    if (colon != std::string::npos && authority.find(']') == std::string::npos) {
+        host = authority.substr(0, colon);
+        port = authority.substr(colon + 1);
+    } else {
+        host = authority;
+        port = tls ? "443" : "80";
+    }
+    if (!host.empty() && host.front() == '[' && host.back() == ']') {
+        host = host.substr(1, host.size() - 2);
+    }
+
+    // A write to a connection the server dropped must fail, not kill the process
+    std::signal(SIGPIPE, SIG_IGN);
+
+    if (tls) {
+        sslContext = SSL_CTX_new(TLS_client_method());
+        if (!sslContext) {
+            throw std::runtime_error(sslError("Cannot create TLS context"));
+        }
+        SSL_CTX_set_min_proto_version(sslContext, TLS1_2_VERSION);
+        SSL_CTX_set_default_verify_paths(sslContext);
+        SSL_CTX_set_verify(sslContext, SSL_VERIFY_PEER, nullptr);
+    }
+}
+
+HttpConnectionPool::~HttpConnectionPool() {
+    idle.clear();
+    if (sslContext) SSL_CTX_free(sslContext);
+}
+
+std::unique_ptr<HttpConnection> HttpConnectionPool::acquire(bool& wasReused) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!idle.empty()) {
+            std::unique_ptr<HttpConnection> connection = std::move(idle.back());
+            idle.pop_back();
+            wasReused = true;
+            reused++;
+            return connection;
+        }
+    }
+    wasReused = false;
+    opened++;
+    return std::make_unique<HttpConnection>(host, port, sslContext);
+}
+
+void HttpConnectionPool::release(std::unique_ptr<HttpConnection> connection) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (idle.size() < maxIdle) {
+        idle.push_back(std::move(connection));
+    }
+}
+
+std::string HttpConnectionPool::post(const std::string& body) {
+    requests++;
+    std::string request;
+    request.reserve(body.size() + 256);
+    request.append("POST ").append(path).append(" HTTP/1.1\r\nHost: ").append(host);
+    request.append("\r\nContent-Type: application/json\r\nAccept: application/json\r\nContent-Length: ");
+    request.append(std::to_string(body.size())).append("\r\nConnection: keep-alive\r\n\r\n").append(body);
+
+    for (int attempt = 0; ; attempt++) {
+        bool wasReused = false;
+        std::unique_ptr<HttpConnection> connection = acquire(wasReused);
+        int status = 0;
+        bool keepAlive = false;
+        bool responseStarted = false;
+        std::string response;
+        try {
+            connection->writeAll(request);
+            response = connection->readResponse(status, keepAlive, responseStarted);
+        } catch (const SolanaRpcError&) {
+            // The server may have closed an idle connection; try a fresh one once
+            if (wasReused && !responseStarted && attempt == 0) continue;
+            throw;
+        }
+
+        if (keepAlive) {
+            release(std::move(connection));
+        }
+        if (status < 200 || status >= 300) {
+            throw SolanaRpcError(status, "HTTP " + std::to_string(status) + " from " + host + ": " + response.substr(0, 200));
+        }
+        return response;
+    }
+}
+
+HttpConnectionPool::Stats HttpConnectionPool::stats() const {
+    return Stats{requests.load(), opened.load(), reused.load()};
+}
+
+SolanaRpcClient::SolanaRpcClient(const std::string& url) : endpoint(url), pool(url) {}
+
+std::string SolanaRpcClient::call(const char* method, const std::function<void(JsonWriter&)>& params) {
+    thread_local JsonWriter json;
+    json.clear();
+    json.beginObject()
+        .field("jsonrpc", "2.0")
+        .field("id", nextId++)
+        .field("method", method)
+        .key("params").beginArray();
+    params(json);
+    json.endArray().endObject();
+    return pool.post(json.str());
+}
+
+uint64_t SolanaRpcClient::getBalance(const std::string& address) {
+    BalanceHandler handler;
+    handler.parse(call("getBalance", [&](JsonWriter& params) {
+        params.value(address);
+    }));
+    if (!handler.found) {
+        throw SolanaRpcError(0, "getBalance response had no value");
+    }
+    return handler.lamports;
+}
+
+V<std::optional<RpcAccountInfo>> SolanaRpcClient::getMultipleAccounts(const V<std::string>& addresses) {
+    AccountsHandler handler;
+    handler.parse(call("getMultipleAccounts", [&](JsonWriter& params) {
+        params.beginArray();
+        for (const auto& address : addresses) {
+            params.value(address);
+        }
+        params.endArray();
+        // Only the account metadata is wanted, not its data
+        params.beginObject()
+            .field("encoding", "base64")
+            .key("dataSlice").beginObject().field("offset", 0).field("length", 0).endObject()
+            .endObject();
+    }));
+    if (handler.accounts.size() != addresses.size()) {
+        throw SolanaRpcError(0, "getMultipleAccounts returned " + std::to_string(handler.accounts.size()) +
+                                " accounts for " + std::to_string(addresses.size()) + " addresses");
+    }
+    return std::move(handler.accounts);
+}
+
+std::string SolanaRpcClient::requestAirdrop(const std::string& address, uint64_t lamports) {
+    StringResultHandler handler;
+    handler.parse(call("requestAirdrop", [&](JsonWriter& params) {
+        params.value(address).value(lamports);
+    }));
+    return handler.result;
+}
+
+std::string SolanaRpcClient::sendTransaction(const std::string& base64Transaction) {
+    StringResultHandler handler;
+    handler.parse(call("sendTransaction", [&](JsonWriter& params) {
+        params.value(base64Transaction);
+        params.beginObject().field("encoding", "base64").endObject();
+    }));
+    return handler.result;
+}
+
+V<std::optional<RpcSignatureStatus>> SolanaRpcClient::getSignatureStatuses(const V<std::string>& signatures) {
+    SignatureStatusHandler handler;
+    handler.parse(call("getSignatureStatuses", [&](JsonWriter& params) {
+        params.beginArray();
+        for (const auto& signature : signatures) {
+            params.value(signature);
+        }
+        params.endArray();
+        params.beginObject().field("searchTransactionHistory", true).endObject();
+    }));
+    if (handler.statuses.size() != signatures.size()) {
+        throw SolanaRpcError(0, "getSignatureStatuses returned the wrong number of entries");
+    }
+    return std::move(handler.statuses);
+}
+
+SolanaRpcClient& solanaRpc() {
+    static SolanaRpcClient client([] {
+        const char* url = std::getenv("SOLANA_RPC_URL");
+        return std::string(url && *url ? url : SolanaConfig::NETWORK_URL);
+    }());
+    return client;
+}
@@ -16,18 +16,11 @@ bool SolanaWallet::connectPhantom() {
             publicKey = std::string(buffer);
             publicKey = publicKey.substr(0, publicKey.find('\n'));
             
+            pclose(pipe);
+
           // Verify the connection by checking balance
-            std::string balance_cmd = "solana balance";
-            FILE* balance_pipe = popen(balance_cmd.c_str(), "r");
-            if (balance_pipe) {
-                char balance_buffer[128];
-                if (fgets(balance_buffer, sizeof(balance_buffer), balance_pipe) != nullptr) {
-                    std::string balance_str(balance_buffer);
-                    balance = std::stod(balance_str);
-                }
-                pclose(balance_pipe);
-            }
-            
+            updateBalance();
+
             isConnected = true;
             return true;
         }
@@ -84,6 +77,7 @@ bool SolanaWallet::requestAirdrop() {
             result += buffer;
         }
         pclose(pipe);
+        balanceCache().invalidate(publicKey);
 
         if (result.find("Signature: ") != std::string::npos) {
             lastAirdropTime = currentTime;
@@ -123,3 +117,10 @@ std::string SolanaWallet::getPublicKey() const {
 double SolanaWallet::getBalance() const {
     return balance;
 }
+
+bool SolanaWallet::updateBalance() {
+    if (publicKey.empty()) {
+        return false;
+    }
+    return SolanaIntegration::tryGetBalance(publicKey, balance);
+}
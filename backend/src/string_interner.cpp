@@ -0,0 +1,41 @@
+#include "../include/string_interner.hpp"
+#include <mutex>
+#include <stdexcept>
+
+uint32_t StringInterner::intern(std::string_view text) {
+    if (std::optional<uint32_t> existing = find(text)) {
+        return *existing;
+    }
+
+    std::unique_lock<std::shared_mutex> write(mutex);
+    auto found = ids.find(text);
+    if (found != ids.end()) {
+        return found->second;
+    }
+    uint32_t id = static_cast<uint32_t>(strings.size());
+    strings.emplace_back(text);
+    ids.emplace(strings.back(), id);
+    return id;
+}
+
+std::optional<uint32_t> StringInterner::find(std::string_view text) const {
+    std::shared_lock<std::shared_mutex> read(mutex);
+    auto found = ids.find(text);
+    if (found == ids.end()) {
+        return std::nullopt;
+    }
+    return found->second;
+}
+
+const std::string& StringInterner::text(uint32_t id) const {
+    std::shared_lock<std::shared_mutex> read(mutex);
+    if (id >= strings.size()) {
+        throw std::out_of_range("Unknown interned string " + std::to_string(id));
+    }
+    return strings[id];
+}
+
+StringInterner& identifierInterner() {
+    static StringInterner interner;
+    return interner;
+}
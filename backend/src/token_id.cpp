@@ -0,0 +1,83 @@
+#include "../include/token_id.hpp"
+#include "../include/snowflake.hpp"
+#include "../include/string_interner.hpp"
+
+namespace {
+    const char PREFIX[] = "NFT-";
+    constexpr size_t PREFIX_LENGTH = sizeof(PREFIX) - 1;
+    constexpr size_t HEX_DIGITS = 6;     // legacy ids
+    const char HEX[] = "0123456789ABCDEF";
+}
+
+bool TokenId::parseLegacy(std::string_view text, uint64_t& number) {
+    if (text.size() != PREFIX_LENGTH + HEX_DIGITS || text.compare(0, PREFIX_LENGTH, PREFIX) != 0) {
+        return false;
+    }
+    number = 0;
+    for (size_t i = PREFIX_LENGTH; i < text.size(); i++) {
+        char c = text[i];
+        int digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+        else return false;     // lower-case ids would not print back the same
+        number = (number << 4) | static_cast<uint64_t>(digit);
+    }
+    return true;
+}
+
+bool TokenId::parseCompact(std::string_view text, TokenId& id) {
+    uint64_t number;
+    if (SnowflakeGenerator::parse(text, PREFIX, number)) {
+        id = TokenId(SNOWFLAKE, number);
+        return true;
+    }
+    if (parseLegacy(text, number)) {
+        id = TokenId(LEGACY, number);
+        return true;
+    }
+    return false;
+}
+
+TokenId TokenId::parse(std::string_view text) {
+    TokenId id;
+    if (text.empty()) return id;
+    if (parseCompact(text, id)) {
+        // Ids being loaded or created: keep new ones from landing on them.
+        // lookup() skips this, so request input can't push the clock ahead.
+        if ((id.value >> TAG_SHIFT) == SNOWFLAKE) {
+            idGenerator().observe(id.value & PAYLOAD);
+        }
+        return id;
+    }
+    return TokenId(INTERNED, identifierInterner().intern(text));
+}
+
+TokenId TokenId::lookup(std::string_view text) {
+    TokenId id;
+    if (text.empty() || parseCompact(text, id)) return id;
+    std::optional<uint32_t> interned = identifierInterner().find(text);
+    return interned ? TokenId(INTERNED, *interned) : TokenId();
+}
+
+TokenId TokenId::generate() {
+    return TokenId(SNOWFLAKE, idGenerator().next());
+}
+
+std::string TokenId::toString() const {
+    switch (value >> TAG_SHIFT) {
+        case SNOWFLAKE:
+            return SnowflakeGenerator::format(PREFIX, value & PAYLOAD);
+        case LEGACY: {
+            std::string text(PREFIX, PREFIX_LENGTH);
+            uint64_t number = value & PAYLOAD;
+            for (size_t i = HEX_DIGITS; i-- > 0;) {
+                text.push_back(HEX[(number >> (4 * i)) & 0xF]);
+            }
+            return text;
+        }
+        case INTERNED:
+            return identifierInterner().text(static_cast<uint32_t>(value & PAYLOAD));
+        default:
+            return std::string();
+    }
+}
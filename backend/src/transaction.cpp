@@ -9,3 +9,20 @@ void Transaction::displayTransaction() const {
     std::cout << "Time: " << timestamp;
     std::cout << "Status: " << status << std::endl;
 }
+
+SnapshotTransaction Transaction::toSnapshot(SnapshotBuilder& builder) const {
+    SnapshotTransaction record{};
+    record.transactionId = builder.intern(transactionId);
+    record.tokenId = builder.intern(tokenId.toString());
+    record.seller = builder.intern(seller.toString());
+    record.buyer = builder.intern(buyer.toString());
+    record.timestamp = builder.intern(timestamp);
+    record.status = builder.intern(status);
+    record.price = price;
+    return record;
+}
+
+Transaction Transaction::fromSnapshot(const SnapshotImage& image, const SnapshotTransaction& record) {
+    return Transaction(image.text(record.transactionId), image.text(record.tokenId), image.text(record.seller),
+                       image.text(record.buyer), record.price, image.text(record.timestamp), image.text(record.status));
+}
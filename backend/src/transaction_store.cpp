@@ -0,0 +1,103 @@
+#include "../include/header.hpp"
+#include <algorithm>
+
+namespace {
+    // Sequence lists only ever grow at the end, so they stay sorted
+    void addSequence(V<uint64_t>& sequences, uint64_t sequence) {
+        // A wallet that sold to itself is listed once
+        if (sequences.empty() || sequences.back() != sequence) {
+            sequences.push_back(sequence);
+        }
+    }
+
+    const V<uint64_t> NO_SEQUENCES;
+}
+
+bool TransactionStore::append(const Transaction& transaction) {
+    uint64_t sequence = records.size();
+    if (!byId.insert(transaction.getTransactionId(), sequence)) {
+        return false;
+    }
+    records.push_back(transaction);
+    addSequence(byWallet[transaction.sellerKey()], sequence);
+    addSequence(byWallet[transaction.buyerKey()], sequence);
+    addSequence(byToken[transaction.token()], sequence);
+    return true;
+}
+
+void TransactionStore::reserve(size_t n) {
+    records.reserve(n);
+    byId.reserve(n);
+}
+
+const Transaction* TransactionStore::find(const std::string& transactionId) const {
+    size_t sequence = byId.find(transactionId);
+    return sequence == FlatHashIndex<std::string>::npos ? nullptr : records.begin() + sequence;
+}
+
+// Cursor is the sequence number of the last item already returned
+TransactionPage TransactionStore::page(const V<uint64_t>& sequences, std::optional<uint64_t> cursor,
+                                       size_t limit, Order order) const {
+    TransactionPage result;
+    const uint64_t* first = sequences.begin();
+    const uint64_t* last = sequences.end();
+
+    if (order == Order::NEWEST_FIRST) {
+        // Everything before the cursor, walking backwards
+        const uint64_t* stop = cursor ? std::lower_bound(first, last, *cursor) : last;
+        const uint64_t* it = stop;
+        while (it != first && result.items.size() < limit) {
+            --it;
+            result.items.push_back(records.begin()[*it]);
+        }
+        if (it != first && !result.items.empty()) {
+            result.nextCursor = *it;
+        }
+    } else {
+        const uint64_t* it = cursor ? std::upper_bound(first, last, *cursor) : first;
+        while (it != last && result.items.size() < limit) {
+            result.items.push_back(records.begin()[*it]);
+            ++it;
+        }
+        if (it != last && !result.items.empty()) {
+            result.nextCursor = *(it - 1);
+        }
+    }
+    return result;
+}
+
+TransactionPage TransactionStore::all(std::optional<uint64_t> cursor, size_t limit, Order order) const {
+    // The sequence numbers of all records are just 0..size-1
+    TransactionPage result;
+    uint64_t count = records.size();
+    if (order == Order::NEWEST_FIRST) {
+        uint64_t next = cursor ? std::min(*cursor, count) : count;
+        while (next > 0 && result.items.size() < limit) {
+            result.items.push_back(records.begin()[--next]);
+        }
+        if (next > 0 && !result.items.empty()) {
+            result.nextCursor = next;
+        }
+    } else {
+        uint64_t next = cursor ? (*cursor < count ? *cursor + 1 : count) : 0;
+        while (next < count && result.items.size() < limit) {
+            result.items.push_back(records.begin()[next++]);
+        }
+        if (next < count && !result.items.empty()) {
+            result.nextCursor = next - 1;
+        }
+    }
+    return result;
+}
+
+TransactionPage TransactionStore::forWallet(const Pubkey& wallet, std::optional<uint64_t> cursor,
+                                            size_t limit, Order order) const {
+    auto found = byWallet.find(wallet);
+    return page(found == byWallet.end() ? NO_SEQUENCES : found->second, cursor, limit, order);
+}
+
+TransactionPage TransactionStore::forToken(TokenId tokenId, std::optional<uint64_t> cursor,
+                                           size_t limit, Order order) const {
+    auto found = byToken.find(tokenId);
+    return page(found == byToken.end() ? NO_SEQUENCES : found->second, cursor, limit, order);
+}
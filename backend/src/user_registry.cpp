@@ -0,0 +1,105 @@
+#include "../include/user_registry.hpp"
+#include "../include/header.hpp"
+#include <cctype>
+#include <functional>
+#include <mutex>
+
+UserRegistry::Shard& UserRegistry::shardFor(std::array<Shard, SHARDS>& index, const std::string& key) {
+    return index[std::hash<std::string>{}(key) % SHARDS];
+}
+
+const UserRegistry::Shard& UserRegistry::shardFor(const std::array<Shard, SHARDS>& index, const std::string& key) {
+    return index[std::hash<std::string>{}(key) % SHARDS];
+}
+
+UserAccount* UserRegistry::find(const std::array<Shard, SHARDS>& index, const std::string& key) const {
+    UserHandle handle;
+    {
+        const Shard& shard = shardFor(index, key);
+        std::shared_lock<std::shared_mutex> read(shard.mutex);
+        auto it = shard.users.find(key);
+        if (it == shard.users.end()) return nullptr;
+        handle = it->second;
+    }
+    return table.get(handle);
+}
+
+std::string UserRegistry::normalizeEmail(const std::string& email) {
+    size_t begin = 0;
+    size_t end = email.size();
+    while (begin < end && std::isspace(static_cast<unsigned char>(email[begin]))) begin++;
+    while (end > begin && std::isspace(static_cast<unsigned char>(email[end - 1]))) end--;
+
+    std::string normalized = email.substr(begin, end - begin);
+    for (char& c : normalized) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return normalized;
+}
+
+bool UserRegistry::add(UserHandle handle) {
+    UserAccount* user = table.get(handle);
+    if (!user) return false;
+
+    std::string email = normalizeEmail(user->getEmail());
+    {
+        Shard& shard = shardFor(byEmail, email);
+        std::unique_lock<std::shared_mutex> write(shard.mutex);
+        if (!shard.users.emplace(email, handle).second) {
+            return false;
+        }
+    }
+
+    std::string wallet = user->getWalletAddress();
+    if (!wallet.empty()) {
+        Shard& shard = shardFor(byWallet, wallet);
+        std::unique_lock<std::shared_mutex> write(shard.mutex);
+        shard.users.emplace(wallet, handle);
+    }
+    return true;
+}
+
+void UserRegistry::clear() {
+    for (auto* index : {&byWallet, &byEmail}) {
+        for (Shard& shard : *index) {
+            std::unique_lock<std::shared_mutex> write(shard.mutex);
+            shard.users.clear();
+        }
+    }
+}
+
+void UserRegistry::rebuild() {
+    clear();
+    for (auto it = table.begin(); it != table.end(); ++it) {
+        if (!add(it.handle())) {
+            std::cerr << "Duplicate account email " << it->getEmail() << "; keeping the first one" << std::endl;
+        }
+    }
+}
+
+UserAccount* UserRegistry::findByWallet(const std::string& walletAddress) const {
+    return find(byWallet, walletAddress);
+}
+
+UserAccount* UserRegistry::findByEmail(const std::string& email) const {
+    return find(byEmail, normalizeEmail(email));
+}
+
+size_t UserRegistry::size() const {
+    size_t total = 0;
+    for (const Shard& shard : byEmail) {
+        std::shared_lock<std::shared_mutex> read(shard.mutex);
+        total += shard.users.size();
+    }
+    return total;
+}
+
+UserTable& userTable() {
+    static UserTable users;
+    return users;
+}
+
+UserRegistry& userRegistry() {
+    static UserRegistry registry(userTable());
+    return registry;
+}
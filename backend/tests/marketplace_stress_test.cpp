@@ -0,0 +1,232 @@
+#include "../include/header.hpp"
+#include "rpc_stand_in.hpp"
+#include "test_util.hpp"
+#include <atomic>
+#include <cmath>
+#include <map>
+#include <thread>
+
+/*
+ * Many threads buying, listing and unlisting at once through Marketplace,
+ * the way concurrent API requests do. Every token must end up with exactly
+ * one owner, sold at most once per listing, with balances and records that
+ * agree with the sales that went through.
+ *
+ * Balances come from an RpcStandIn: 10 SOL for every wallet but "poor-*",
+ * which get 2.5 SOL.
+ */
+
+namespace {
+    const int BUYERS = 8;
+    const int TOKENS = 200;
+    const double PRICE = 0.1;
+
+    UserAccount& addUser(const std::string& wallet, const std::string& balance) {
+        UserTable& users = userTable();
+        UserHandle handle = users.emplace(UserAccount(wallet, wallet, wallet + "@stress", "", balance));
+        userRegistry().add(handle);
+        return *users.get(handle);
+    }
+
+    // Gives seller `count` NFTs in one collection and lists each of them at price
+    V<std::string> listInventory(UserAccount& seller, const std::string& collection, int count, double price) {
+        V<std::string> tokenIds;
+        {
+            AccountGuard account(seller);
+            seller.getCollections().push_back(Collection(collection, seller.getName()));
+            for (int i = 0; i < count; i++) {
+                NFT nft(collection + "-" + std::to_string(i), seller.getWalletAddress(), price);
+                nft.setCollection(collection);
+                seller.addOwnedNFT(nft);
+                seller.getCollections().back().addNFT(nft);
+                tokenIds.push_back(nft.getTokenId());
+            }
+        }
+        for (const auto& tokenId : tokenIds) {
+            CHECK(Marketplace::getInstance()->listNFT(tokenId, price, seller));
+        }
+        return tokenIds;
+    }
+
+    // Accounts holding tokenId in their owned NFTs
+    int holders(const V<UserAccount*>& accounts, TokenId tokenId) {
+        int count = 0;
+        for (UserAccount* account : accounts) {
+            AccountGuard guard(*account);
+            if (account->findOwnedNFT(tokenId)) count++;
+        }
+        return count;
+    }
+
+    size_t transactionCount() {
+        size_t count = 0;
+        std::optional<uint64_t> cursor;
+        do {
+            TransactionPage page = Marketplace::getInstance()->getTransactions(cursor, Marketplace::MAX_PAGE_SIZE);
+            count += page.items.size();
+            cursor = page.nextCursor;
+        } while (cursor);
+        return count;
+    }
+
+    size_t storedTransactions(const UserAccount& user) {
+        return accountStore().keysWithPrefix(user.getKeypairDir() + "/transactions/").size();
+    }
+
+    size_t storedNFTs(const UserAccount& user) {
+        return accountStore().keysWithPrefix(user.getKeypairDir() + "/nfts/").size();
+    }
+}
+
+int main() {
+    enterScratchDir("marketplace_stress_test");
+    RpcStandIn node([](const std::string& method, const std::string& body) -> RpcReply {
+        if (method != "getBalance") {
+            return rpcError(-32601, "Method not found");
+        }
+        uint64_t lamports = firstParam(body).compare(0, 5, "poor-") == 0 ? 2500000000ULL : 10000000000ULL;
+        return rpcResult("{\"context\":{\"slot\":1},\"value\":" + std::to_string(lamports) + "}");
+    });
+    setenv("SOLANA_RPC_URL", node.url().c_str(), 1);
+
+    // The marketplace narrates every step, and every lost race on cerr
+    std::cout.setstate(std::ios::failbit);
+    std::cerr.setstate(std::ios::failbit);
+
+    Marketplace* marketplace = Marketplace::getInstance();
+    UserAccount& seller = addUser("stress-seller", "0");
+    V<UserAccount*> buyers;
+    for (int b = 0; b < BUYERS; b++) {
+        buyers.push_back(&addUser("stress-buyer-" + std::to_string(b), "10"));
+    }
+    V<UserAccount*> everyone = buyers;
+    everyone.push_back(&seller);
+
+    runCase("every listing sells exactly once to racing buyers", [&] {
+        V<std::string> tokenIds = listInventory(seller, "Stress", TOKENS, PRICE);
+        std::vector<std::atomic<int>> sold(TOKENS);
+        std::vector<int> bought(BUYERS, 0);
+        std::vector<std::thread> threads;
+        for (int b = 0; b < BUYERS; b++) {
+            threads.emplace_back([&, b] {
+                // Each buyer starts somewhere else, so every token is contested
+                for (int i = 0; i < TOKENS; i++) {
+                    int t = (i + b * TOKENS / BUYERS) % TOKENS;
+                    try {
+                        marketplace->buyNFT(tokenIds[t], *buyers[b]);
+                        sold[t]++;
+                        bought[b]++;
+                    } catch (const std::exception&) {
+                        // Someone else got it first
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+
+        for (int t = 0; t < TOKENS; t++) {
+            CHECK(sold[t] == 1);
+            CHECK(holders(everyone, TokenId::lookup(tokenIds[t])) == 1);
+        }
+        CHECK(!marketplace->hasListedNFTs());
+        CHECK(seller.getOwnedNFTs().empty());
+        CHECK(transactionCount() == static_cast<size_t>(TOKENS));
+
+        double fee = marketplace->calculateFee(PRICE);
+        CHECK(std::abs(seller.getBalance() - TOKENS * PRICE) < 1e-3);
+        for (int b = 0; b < BUYERS; b++) {
+            CHECK(buyers[b]->getOwnedNFTs().size() == static_cast<size_t>(bought[b]));
+            CHECK(std::abs(buyers[b]->getBalance() - (10 - bought[b] * (PRICE + fee))) < 1e-3);
+        }
+
+        // Every sale committed both sides, however the sales interleaved
+        CHECK(storedNFTs(seller) == 0);
+        for (int b = 0; b < BUYERS; b++) {
+            CHECK(storedTransactions(*buyers[b]) == static_cast<size_t>(bought[b]));
+            CHECK(storedNFTs(*buyers[b]) == static_cast<size_t>(bought[b]));
+        }
+    });
+
+    runCase("one buyer's concurrent purchases never overspend", [&] {
+        UserAccount& poor = addUser("poor-buyer", "2.5");
+        UserAccount& dealer = addUser("stress-dealer", "0");
+        V<std::string> tokenIds = listInventory(dealer, "Dealer", 16, 1.0);
+        std::atomic<int> succeeded{0};
+        std::vector<std::thread> threads;
+        for (const auto& tokenId : tokenIds) {
+            threads.emplace_back([&, tokenId] {
+                try {
+                    marketplace->buyNFT(tokenId, poor);
+                    succeeded++;
+                } catch (const std::exception&) {
+                    // Balance already spent
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+
+        // 2.5 SOL covers two sales at 1.025 each, never three
+        CHECK(succeeded == 2);
+        CHECK(poor.getOwnedNFTs().size() == 2);
+        CHECK(dealer.getOwnedNFTs().size() == tokenIds.size() - 2);
+        // The unsold rest would only get in the way of the next case
+        for (const auto& tokenId : tokenIds) {
+            try { marketplace->unlistNFT(tokenId, dealer); } catch (const std::exception&) {}
+        }
+    });
+
+    runCase("buyers trade with each other while relisting", [&] {
+        // Every buyer relists what it bought, then all of them buy each other's
+        // listings: buyer and seller locks are taken in both orders at once
+        std::atomic<int> sales{0};
+        std::vector<std::thread> threads;
+        for (int b = 0; b < BUYERS; b++) {
+            threads.emplace_back([&, b] {
+                UserAccount& me = *buyers[b];
+                V<std::string> mine;
+                {
+                    AccountGuard account(me);
+                    for (const auto& nft : me.getOwnedNFTs()) mine.push_back(nft.getTokenId());
+                }
+                for (const auto& tokenId : mine) {
+                    marketplace->listNFT(tokenId, 0.01, me);
+                }
+                for (int round = 0; round < 3; round++) {
+                    ListingPage page = marketplace->getListingsPage("Stress", 0, ListingColumns::ANY_PRICE,
+                                                                    ListingSort::OLDEST, std::nullopt, 50);
+                    for (const auto& nft : page.items) {
+                        if (nft.getOwner() == me.getWalletAddress()) {
+                            // Take some of our own back down while others are buying them
+                            try { marketplace->unlistNFT(nft.getTokenId(), me); } catch (const std::exception&) {}
+                            continue;
+                        }
+                        try {
+                            marketplace->buyNFT(nft.getTokenId(), me);
+                            sales++;
+                        } catch (const std::exception&) {
+                            // Sold or unlisted first
+                        }
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+
+        size_t owned = 0;
+        for (UserAccount* account : everyone) owned += account->getOwnedNFTs().size();
+        CHECK(owned == static_cast<size_t>(TOKENS));
+        std::map<std::string, int> owners;
+        for (UserAccount* account : everyone) {
+            for (const auto& nft : account->getOwnedNFTs()) {
+                owners[nft.getTokenId()]++;
+                CHECK(nft.getOwner() == account->getWalletAddress());
+                // Listed in the account exactly when the marketplace has it
+                CHECK(nft.getIsListed() == marketplace->findNFTByTokenId(nft.getTokenId()).has_value());
+            }
+        }
+        CHECK(owners.size() == static_cast<size_t>(TOKENS));
+        CHECK(transactionCount() == static_cast<size_t>(TOKENS) + 2 + sales);
+    });
+
+    return testResult("marketplace_stress_test");
+}
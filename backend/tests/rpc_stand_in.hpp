@@ -0,0 +1,186 @@
+#ifndef RPC_STAND_IN_HPP
+#define RPC_STAND_IN_HPP
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <netinet/in.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// What the stand-in sends back for one request
+struct RpcReply {
+    int status = 200;
+    std::string body;
+
+    RpcReply(std::string json) : body(std::move(json)) {}
+    RpcReply(int httpStatus, std::string text) : status(httpStatus), body(std::move(text)) {}
+};
+
+/*
+ * Loopback HTTP/1.1 server standing in for a Solana RPC node. Listens on
+ * 127.0.0.1 on a port the kernel picks; each POST body goes to the handler
+ * together with its JSON-RPC method, and the handler's reply is sent back.
+ * Connections stay open until the client closes them, so a client that
+ * pools connections opens only as many as it runs requests concurrently.
+ */
+class RpcStandIn {
+public:
+    using Handler = std::function<RpcReply(const std::string& method, const std::string& body)>;
+
+private:
+    Handler handler;
+    int listenFd = -1;
+    uint16_t port = 0;
+    std::atomic<bool> stopping{false};
+    std::atomic<size_t> accepted{0};
+    std::atomic<size_t> requests{0};
+    std::thread acceptor;
+    std::mutex mutex;
+    std::vector<int> clientFds;
+    std::vector<std::thread> clients;
+
+    static bool sendAll(int fd, const std::string& data) {
+        size_t written = 0;
+        while (written < data.size()) {
+            ssize_t n = ::send(fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+            if (n <= 0) return false;
+            written += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // "method":"name" from a compact JSON-RPC request
+    static std::string methodOf(const std::string& body) {
+        const std::string key = "\"method\":\"";
+        size_t start = body.find(key);
+        if (start == std::string::npos) return "";
+        start += key.size();
+        size_t end = body.find('"', start);
+        return end == std::string::npos ? "" : body.substr(start, end - start);
+    }
+
+    void serve(int fd) {
+        std::string buffer;
+        char chunk[16 * 1024];
+        while (!stopping) {
+            size_t headerEnd;
+            while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+                ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+                if (n <= 0) return;
+                buffer.append(chunk, static_cast<size_t>(n));
+            }
+            size_t length = 0;
+            size_t field = buffer.find("Content-Length:");
+            if (field == std::string::npos) field = buffer.find("content-length:");
+            if (field != std::string::npos && field < headerEnd) {
+                length = std::stoul(buffer.substr(field + 15));
+            }
+            size_t bodyStart = headerEnd + 4;
+            while (buffer.size() < bodyStart + length) {
+                ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+                if (n <= 0) return;
+                buffer.append(chunk, static_cast<size_t>(n));
+            }
+            std::string body = buffer.substr(bodyStart, length);
+            buffer.erase(0, bodyStart + length);
+
+            requests++;
+            RpcReply reply = handler(methodOf(body), body);
+            std::string response = "HTTP/1.1 " + std::to_string(reply.status) +
+                                   (reply.status == 200 ? " OK" : " Error") + "\r\n"
+                                   "Content-Type: application/json\r\n"
+                                   "Content-Length: " + std::to_string(reply.body.size()) + "\r\n"
+                                   "\r\n" + reply.body;
+            if (!sendAll(fd, response)) return;
+        }
+    }
+
+    void acceptLoop() {
+        while (!stopping) {
+            int fd = ::accept(listenFd, nullptr, nullptr);
+            if (fd < 0) {
+                if (stopping) return;
+                continue;
+            }
+            accepted++;
+            std::lock_guard<std::mutex> lock(mutex);
+            clientFds.push_back(fd);
+            clients.emplace_back([this, fd] { serve(fd); });
+        }
+    }
+
+public:
+    explicit RpcStandIn(Handler requestHandler) : handler(std::move(requestHandler)) {
+        listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (listenFd < 0) throw std::runtime_error("Stand-in socket failed");
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+        socklen_t size = sizeof(address);
+        if (::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            ::listen(listenFd, 64) != 0 ||
+            ::getsockname(listenFd, reinterpret_cast<sockaddr*>(&address), &size) != 0) {
+            ::close(listenFd);
+            throw std::runtime_error("Stand-in could not listen on 127.0.0.1");
+        }
+        port = ntohs(address.sin_port);
+        acceptor = std::thread([this] { acceptLoop(); });
+    }
+
+    ~RpcStandIn() {
+        stopping = true;
+        // Wakes accept() and every blocked recv()
+        ::shutdown(listenFd, SHUT_RDWR);
+        acceptor.join();
+        ::close(listenFd);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (int fd : clientFds) ::shutdown(fd, SHUT_RDWR);
+        }
+        for (auto& client : clients) client.join();
+        for (int fd : clientFds) ::close(fd);
+    }
+
+    RpcStandIn(const RpcStandIn&) = delete;
+    RpcStandIn& operator=(const RpcStandIn&) = delete;
+
+    // Hangs up on every open connection, as a node does with idle keep-alives
+    void dropConnections() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int fd : clientFds) ::shutdown(fd, SHUT_RDWR);
+    }
+
+    std::string url() const { return "http://127.0.0.1:" + std::to_string(port); }
+    // TCP connections accepted so far
+    size_t connections() const { return accepted; }
+    size_t requestCount() const { return requests; }
+};
+
+// The JSON-RPC envelopes a handler usually answers with
+inline std::string rpcResult(const std::string& resultJson) {
+    return "{\"jsonrpc\":\"2.0\",\"id\":1,\"result\":" + resultJson + "}";
+}
+
+inline std::string rpcError(int code, const std::string& message) {
+    return "{\"jsonrpc\":\"2.0\",\"id\":1,\"error\":{\"code\":" + std::to_string(code) +
+           ",\"message\":\"" + message + "\"}}";
+}
+
+// The first string in the request's params array, e.g. getBalance's address
+inline std::string firstParam(const std::string& body) {
+    size_t params = body.find("\"params\":[");
+    if (params == std::string::npos) return "";
+    size_t start = body.find('"', params + 10);
+    if (start == std::string::npos) return "";
+    size_t end = body.find('"', start + 1);
+    return end == std::string::npos ? "" : body.substr(start + 1, end - start - 1);
+}
+
+#endif
@@ -0,0 +1,184 @@
+#include "../include/solana_rpc.hpp"
+#include "rpc_stand_in.hpp"
+#include "test_util.hpp"
+#include <thread>
+
+/*
+ * SolanaRpcClient against a loopback stand-in for the node: request
+ * encoding, result parsing (including null entries), error mapping to
+ * SolanaRpcError, and connection reuse through HttpConnectionPool.
+ */
+
+namespace {
+    const std::string OWNER = "11111111111111111111111111111111";
+
+    RpcReply answer(const std::string& method, const std::string& body) {
+        if (method == "getBalance") {
+            std::string address = firstParam(body);
+            if (address == "bad") {
+                return rpcError(-32602, "Invalid param: WrongSize");
+            }
+            if (address == "down") {
+                return RpcReply(503, "Service Unavailable");
+            }
+            return rpcResult("{\"context\":{\"slot\":5},\"value\":1500000000}");
+        }
+        if (method == "getMultipleAccounts") {
+            // One entry per address in order; "missing" doesn't exist
+            std::string value = "[";
+            size_t at = body.find("\"params\":[[") + 11;
+            size_t end = body.find(']', at);
+            bool first = true;
+            while (at < end) {
+                size_t open = body.find('"', at);
+                if (open == std::string::npos || open > end) break;
+                size_t close = body.find('"', open + 1);
+                std::string address = body.substr(open + 1, close - open - 1);
+                value += first ? "" : ",";
+                first = false;
+                if (address == "missing") {
+                    value += "null";
+                } else {
+                    value += "{\"lamports\":" + std::to_string(address.size() * 1000) + ",\"owner\":\"" + OWNER +
+                             "\",\"executable\":" + (address == "program" ? "true" : "false") +
+                             ",\"space\":165,\"data\":[\"\",\"base64\"],\"rentEpoch\":1}";
+                }
+                at = close + 1;
+            }
+            return rpcResult("{\"context\":{\"slot\":5},\"value\":" + value + "]}");
+        }
+        if (method == "getSignatureStatuses") {
+            return rpcResult("{\"context\":{\"slot\":9},\"value\":[null,"
+                             "{\"slot\":7,\"confirmations\":null,\"err\":null,\"confirmationStatus\":\"finalized\"},"
+                             "{\"slot\":8,\"confirmations\":2,\"err\":{\"InstructionError\":[0,\"Custom\"]},"
+                             "\"confirmationStatus\":\"confirmed\"}]}");
+        }
+        if (method == "requestAirdrop") {
+            return rpcResult("\"airdrop-signature\"");
+        }
+        return rpcError(-32601, "Method not found");
+    }
+}
+
+int main() {
+    RpcStandIn node(answer);
+
+    runCase("getBalance returns the lamports in result.value", [&] {
+        SolanaRpcClient client(node.url());
+        CHECK(client.getBalance("wallet") == 1500000000ULL);
+        CHECK(client.requestAirdrop("wallet", 1000000000ULL) == "airdrop-signature");
+    });
+
+    runCase("getMultipleAccounts keeps one entry per address, null where missing", [&] {
+        SolanaRpcClient client(node.url());
+        V<std::string> addresses;
+        for (const char* address : {"alpha", "missing", "program"}) addresses.push_back(address);
+        V<std::optional<RpcAccountInfo>> accounts = client.getMultipleAccounts(addresses);
+        CHECK(accounts.size() == 3);
+        if (accounts.size() != 3) return;
+        CHECK(accounts[0] && accounts[0]->lamports == 5000 && accounts[0]->owner == OWNER);
+        CHECK(accounts[0] && !accounts[0]->executable && accounts[0]->space == 165);
+        CHECK(!accounts[1]);
+        CHECK(accounts[2] && accounts[2]->executable && accounts[2]->lamports == 7000);
+    });
+
+    runCase("getSignatureStatuses reads finalized, failed and unknown signatures", [&] {
+        SolanaRpcClient client(node.url());
+        V<std::string> signatures;
+        for (const char* signature : {"unknown", "done", "failed"}) signatures.push_back(signature);
+        V<std::optional<RpcSignatureStatus>> statuses = client.getSignatureStatuses(signatures);
+        CHECK(statuses.size() == 3);
+        if (statuses.size() != 3) return;
+        CHECK(!statuses[0]);
+        CHECK(statuses[1] && statuses[1]->slot == 7 && !statuses[1]->confirmations);
+        CHECK(statuses[1] && statuses[1]->confirmationStatus == "finalized" && !statuses[1]->failed);
+        CHECK(statuses[2] && statuses[2]->failed && statuses[2]->confirmations == 2u);
+    });
+
+    runCase("a JSON-RPC error becomes SolanaRpcError with its code", [&] {
+        SolanaRpcClient client(node.url());
+        bool thrown = false;
+        try {
+            client.getBalance("bad");
+        } catch (const SolanaRpcError& e) {
+            thrown = true;
+            CHECK(e.code() == -32602);
+            CHECK(std::string(e.what()) == "RPC error -32602: Invalid param: WrongSize");
+        }
+        CHECK(thrown);
+        // The error came back on a healthy connection; the next call uses it
+        CHECK(client.getBalance("wallet") == 1500000000ULL);
+        CHECK(client.stats().connectionsOpened == 1);
+    });
+
+    runCase("an HTTP error status becomes SolanaRpcError with the status", [&] {
+        SolanaRpcClient client(node.url());
+        bool thrown = false;
+        try {
+            client.getBalance("down");
+        } catch (const SolanaRpcError& e) {
+            thrown = true;
+            CHECK(e.code() == 503);
+        }
+        CHECK(thrown);
+    });
+
+    runCase("an unreachable node is a transport error (code 0)", [&] {
+        // A port nothing listens on: bind one, then give it back
+        std::string url;
+        {
+            RpcStandIn gone(answer);
+            url = gone.url();
+        }
+        SolanaRpcClient client(url);
+        bool thrown = false;
+        try {
+            client.getBalance("wallet");
+        } catch (const SolanaRpcError& e) {
+            thrown = true;
+            CHECK(e.code() == 0);
+        }
+        CHECK(thrown);
+    });
+
+    runCase("sequential requests reuse one keep-alive connection", [&] {
+        SolanaRpcClient client(node.url());
+        size_t acceptedBefore = node.connections();
+        for (int i = 0; i < 50; i++) {
+            CHECK(client.getBalance("wallet") == 1500000000ULL);
+        }
+        HttpConnectionPool::Stats stats = client.stats();
+        CHECK(stats.requests == 50);
+        CHECK(stats.connectionsOpened == 1);
+        CHECK(stats.connectionsReused == 49);
+        CHECK(node.connections() - acceptedBefore == 1);
+    });
+
+    runCase("concurrent requests open at most one connection per caller", [&] {
+        SolanaRpcClient client(node.url());
+        const int THREADS = 4;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < THREADS; t++) {
+            threads.emplace_back([&] {
+                for (int i = 0; i < 25; i++) client.getBalance("wallet");
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        HttpConnectionPool::Stats stats = client.stats();
+        CHECK(stats.requests == 100);
+        CHECK(stats.connectionsOpened <= static_cast<uint64_t>(THREADS));
+        CHECK(stats.connectionsOpened + stats.connectionsReused == 100);
+    });
+
+    runCase("a pooled connection the node dropped is retried on a fresh one", [&] {
+        SolanaRpcClient client(node.url());
+        CHECK(client.getBalance("wallet") == 1500000000ULL);
+        node.dropConnections();
+        CHECK(client.getBalance("wallet") == 1500000000ULL);
+        HttpConnectionPool::Stats stats = client.stats();
+        CHECK(stats.requests == 2);
+        CHECK(stats.connectionsOpened == 2);
+    });
+
+    return testResult("solana_rpc_test");
+}
@@ -0,0 +1,56 @@
+#ifndef TEST_UTIL_HPP
+#define TEST_UTIL_HPP
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+// Failed CHECKs so far; testResult() turns them into the exit status
+inline int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+// Reports the failed condition and keeps going, so one run shows every failure.
+// Test output goes to std::clog: tests silence the backend's cout and cerr chatter.
+#define CHECK(condition)                                                                  \
+    do {                                                                                  \
+        if (!(condition)) {                                                               \
+            std::clog << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #condition     \
+                      << std::endl;                                                       \
+            testFailures()++;                                                             \
+        }                                                                                 \
+    } while (0)
+
+// Runs one named case; an exception out of it counts as a failure
+template <typename Body>
+void runCase(const char* name, Body body) {
+    int before = testFailures();
+    try {
+        body();
+    } catch (const std::exception& e) {
+        std::clog << name << ": threw " << e.what() << std::endl;
+        testFailures()++;
+    }
+    std::clog << (testFailures() == before ? "  ok   " : "  FAIL ") << name << std::endl;
+}
+
+inline int testResult(const char* suite) {
+    int failures = testFailures();
+    std::clog << suite << ": " << (failures == 0 ? "passed" : std::to_string(failures) + " check(s) failed") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
+
+// Moves the process into a fresh directory under /tmp, so the stores and
+// journals a test writes never touch the checkout
+inline std::string enterScratchDir(const std::string& name) {
+    std::string path = "/tmp/" + name + ".XXXXXX";
+    if (!::mkdtemp(&path[0]) || ::chdir(path.c_str()) != 0) {
+        throw std::runtime_error("Cannot create scratch directory " + path);
+    }
+    return path;
+}
+
+#endif